@@ -18,17 +18,37 @@
  */
 
 #include <app/glwidget.h>
+#include "base/profiler.h"
 
 #include <QtOpenGL>
 
 #include <GL/glu.h>
 
+#include <cstddef>
+
+
+//! Vertical field of view, in degrees.
+static float const FIELD_OF_VIEW = 60.0f;
+//! Buildings smaller than this many pixels across are not drawn.
+static float const LOD_SKIP_PIXELS = 1.0f;
+//! Buildings smaller than this many pixels across are drawn as roofs only.
+static float const LOD_ROOF_PIXELS = 16.0f;
+
 
 GLWidget::GLWidget(QGLFormat const & format, QWidget * parent)
 	: QGLWidget(format, parent)
 	, m_texId(0)
+	, m_terrainIndexCount(0)
+	, m_vertexBuffer(QGLBuffer::VertexBuffer)
+	, m_indexBuffer(QGLBuffer::IndexBuffer)
+	, m_buffersDirty(true)
+	, m_useBuffers(false)
+	, m_pixelsPerUnit(1.0f)
 {
+	m_indexBuffer.setUsagePattern(QGLBuffer::DynamicDraw);
+
 	setViewingCoords(1.0f, M_PI/4); // reflect in toolbox.ui
+	setBuildings(QVector<core::VolumeBox>());
 }
 
 
@@ -51,7 +71,105 @@ void GLWidget::setTexture(QImage const & image)
 
 void GLWidget::setBuildings(QVector<core::VolumeBox> const & buildings)
 {
-	m_buildings = buildings;
+	PROFILE_SPAN("glwidget/setBuildings");
+
+	m_vertices.clear();
+	m_indices.clear();
+
+	// city coordinates map to the unit square around the origin, with
+	// height along the y axis
+	//
+	Vertex v;
+
+	// terrain quad, textured with the city image
+	//
+	static GLfloat const terrain[4][2] = { {0.0f, 0.0f}, {1.0f, 0.0f}, {1.0f, 1.0f}, {0.0f, 1.0f} };
+
+	for (int i = 0; i < 4; ++i)
+	{
+		v.position[0] = -0.5f + terrain[i][0];
+		v.position[1] = 0.0f;
+		v.position[2] = 0.5f - terrain[i][1];
+		v.texCoord[0] = terrain[i][0];
+		v.texCoord[1] = terrain[i][1];
+		m_vertices.append(v);
+	}
+
+	m_indices << 0 << 1 << 2 << 0 << 2 << 3;
+	m_terrainIndexCount = m_indices.size();
+
+	// buildings, each as a prism whose roof alone is drawn for distant views
+	//
+	m_buildingTree.build(buildings);
+	m_buildingRanges.resize(buildings.size());
+
+	for (int i = 0; i < buildings.size(); ++i)
+	{
+		core::VolumeBox const & building = buildings[i];
+		BuildingRange & range = m_buildingRanges[i];
+
+		range.prismFirst = range.roofFirst = m_indices.size();
+		range.prismCount = range.roofCount = 0;
+
+		QVector<math::Point2f> outline = building.base().points();
+
+		if (outline.size() < 3) continue;
+
+		appendPrism(outline, building.height());
+		range.prismCount = m_indices.size() - range.prismFirst;
+
+		// the roof triangles end the prism's indices
+		range.roofCount = 3 * (outline.size() - 2);
+		range.roofFirst = m_indices.size() - range.roofCount;
+	}
+
+	// at most, every building is drawn at full detail
+	m_frameIndices.resize(m_indices.size());
+
+	m_buffersDirty = true;
+}
+
+void GLWidget::appendPrism(QVector<math::Point2f> const & outline, float height)
+{
+	// a ring of base vertices followed by a ring of roof vertices
+	//
+	int n = outline.size();
+
+	GLuint base = m_vertices.size();
+	GLuint roof = base + n;
+
+	Vertex v;
+	v.texCoord[0] = 0.0f;
+	v.texCoord[1] = 0.0f;
+
+	for (int ring = 0; ring < 2; ++ring)
+	{
+		foreach (math::Point2f const & p, outline)
+		{
+			v.position[0] = -0.5f + p.x();
+			v.position[1] = ring == 0 ? 0.0f : height;
+			v.position[2] = 0.5f - p.y();
+			m_vertices.append(v);
+		}
+	}
+
+	// walls
+	for (int i = 0, j = 1; i < n; ++i, ++j)
+	{
+		if (j == n)
+		{
+			j = 0;
+		}
+
+		m_indices << base + i << base + j << roof + j;
+		m_indices << base + i << roof + j << roof + i;
+	}
+
+	// roof, as a fan over the convex outline
+	for (int i = 1; i + 1 < n; ++i)
+	{
+		m_indices << roof << roof + i << roof + i + 1;
+	}
 }
 
 void GLWidget::animate()
@@ -87,11 +205,18 @@ void GLWidget::resizeGL(int width, int height)
 
 	glMatrixMode(GL_PROJECTION);
 	glLoadIdentity();
-	gluPerspective(60.0, (GLdouble)width/height, 0.1, 100.0);
+	gluPerspective(FIELD_OF_VIEW, (GLdouble)width/height, 0.1, 100.0);
+
+	m_projection.setToIdentity();
+	m_projection.perspective(FIELD_OF_VIEW, (qreal)width/height, 0.1, 100.0);
+
+	m_pixelsPerUnit = height / (2.0f * tanf(FIELD_OF_VIEW/2 * M_PI/180));
 }
 
 void GLWidget::paintGL()
 {
+	PROFILE_SPAN("glwidget/paint");
+
 	glClear(GL_COLOR_BUFFER_BIT);
 
 	glMatrixMode(GL_MODELVIEW);
@@ -109,49 +234,145 @@ void GLWidget::paintGL()
 		eyeCen.x(), eyeCen.y(), eyeCen.z(),
 		eyeUpv.x(), eyeUpv.y(), eyeUpv.z());
 
-	// assign texture
-	glBindTexture(GL_TEXTURE_2D, m_texId);
+	if (m_buffersDirty)
+	{
+		uploadBuffers();
+	}
+
+	QMatrix4x4 view;
+	view.lookAt(eyePos, eyeCen, eyeUpv);
 
-	// draw the polygon
+	int indexCount = selectIndices(eyePos, view);
+
+	// with buffers bound, attribute pointers are offsets into them
 	//
-	glBegin(GL_POLYGON);
-	glTexCoord2f(0.0f, 0.0f); glVertex3f(-0.5f,  0.0f,  0.5f);
-	glTexCoord2f(1.0f, 0.0f); glVertex3f( 0.5f,  0.0f,  0.5f);
-	glTexCoord2f(1.0f, 1.0f); glVertex3f( 0.5f,  0.0f, -0.5f);
-	glTexCoord2f(0.0f, 1.0f); glVertex3f(-0.5f,  0.0f, -0.5f);
-	glEnd();
-
-	// draw buildings
+	char const * vertexData = m_useBuffers ? NULL : reinterpret_cast<char const *>(m_vertices.constData());
+	char const * indexData  = m_useBuffers ? NULL : reinterpret_cast<char const *>(m_frameIndices.constData());
+
+	if (m_useBuffers)
+	{
+		m_vertexBuffer.bind();
+		m_indexBuffer.bind();
+		m_indexBuffer.allocate(m_frameIndices.constData(), indexCount * sizeof(GLuint));
+	}
+
+	glEnableClientState(GL_VERTEX_ARRAY);
+	glVertexPointer(3, GL_FLOAT, sizeof(Vertex), vertexData + offsetof(Vertex, position));
+
+	// draw the terrain
+	//
+	glBindTexture(GL_TEXTURE_2D, m_texId);
+
+	glEnableClientState(GL_TEXTURE_COORD_ARRAY);
+	glTexCoordPointer(2, GL_FLOAT, sizeof(Vertex), vertexData + offsetof(Vertex, texCoord));
+
+	glDrawElements(GL_TRIANGLES, m_terrainIndexCount, GL_UNSIGNED_INT, indexData);
+
+	glDisableClientState(GL_TEXTURE_COORD_ARRAY);
+
+	// draw visible buildings
 	//
 	glDisable(GL_TEXTURE_2D);
 	glColor4f(0.8f, 0.8f, 0.8f, 0.6f);
-	foreach (core::VolumeBox building, m_buildings)
+
+	if (indexCount > m_terrainIndexCount)
 	{
-		// draw walls
-		//
-		glBegin(GL_QUADS);
-		foreach (core::VolumeBox::Quad quad, building.walls())
-		{
-			foreach (QVector3D v, quad)
-			{
-				glVertex3d(-0.5+v.x(), v.z(), 0.5-v.y());
-			}
-		}
-		glEnd();
+		glDrawElements(GL_TRIANGLES, indexCount - m_terrainIndexCount, GL_UNSIGNED_INT, indexData + m_terrainIndexCount * sizeof(GLuint));
+	}
 
-		// draw roof
-		//
-		glBegin(GL_POLYGON);
-		foreach (QVector3D v, building.roof())
-		{
-			glVertex3d(-0.5+v.x(), v.z(), 0.5-v.y());
-		}
-		glEnd();
+	glEnable(GL_TEXTURE_2D);
 
+	glDisableClientState(GL_VERTEX_ARRAY);
+
+	if (m_useBuffers)
+	{
+		m_indexBuffer.release();
+		m_vertexBuffer.release();
 	}
-	glEnable(GL_TEXTURE_2D);
 
 	glPopMatrix();
 
 	swapBuffers();
 }
+
+void GLWidget::uploadBuffers()
+{
+	PROFILE_SPAN("glwidget/uploadBuffers");
+
+	if (! m_vertexBuffer.isCreated())
+	{
+		// without buffer object support, e.g. on old software renderers,
+		// the same arrays are drawn from client memory
+		m_useBuffers = m_vertexBuffer.create() && m_indexBuffer.create();
+	}
+
+	if (m_useBuffers)
+	{
+		m_vertexBuffer.bind();
+		m_vertexBuffer.allocate(m_vertices.constData(), m_vertices.size() * sizeof(Vertex));
+		m_vertexBuffer.release();
+	}
+
+	m_buffersDirty = false;
+}
+
+int GLWidget::selectIndices(QVector3D const & eye, QMatrix4x4 const & view)
+{
+	PROFILE_SPAN("glwidget/selectIndices");
+
+	GLuint * out = m_frameIndices.data();
+	GLuint const * in = m_indices.constData();
+
+	qCopy(in, in + m_terrainIndexCount, out);
+	out += m_terrainIndexCount;
+
+	// view frustum in city coordinates, where the tree is built
+	//
+	static QMatrix4x4 const cityToWorld(
+		1.0f,  0.0f, 0.0f, -0.5f,
+		0.0f,  0.0f, 1.0f,  0.0f,
+		0.0f, -1.0f, 0.0f,  0.5f,
+		0.0f,  0.0f, 0.0f,  1.0f);
+
+	QMatrix4x4 clip = m_projection * view * cityToWorld;
+
+	QVector4D const planes[6] =
+	{
+		clip.row(3) + clip.row(0), // left
+		clip.row(3) - clip.row(0), // right
+		clip.row(3) + clip.row(1), // bottom
+		clip.row(3) - clip.row(1), // top
+		clip.row(3) + clip.row(2), // near
+		clip.row(3) - clip.row(2), // far
+	};
+
+	m_buildingTree.cull(planes, 6, m_visibleBuildings);
+
+	// level of detail by the projected size of the bounds
+	//
+	foreach (int i, m_visibleBuildings)
+	{
+		core::VolumeTree::Bounds const & bounds = m_buildingTree.bounds(i);
+
+		QVector3D center = cityToWorld.map((bounds.min + bounds.max) * 0.5f);
+		float radius = (bounds.max - bounds.min).length() * 0.5f;
+		float distance = (center - eye).length();
+
+		float pixels = distance > radius ? 2.0f * radius * m_pixelsPerUnit / distance : LOD_ROOF_PIXELS;
+
+		if (pixels < LOD_SKIP_PIXELS) continue;
+
+		BuildingRange const & range = m_buildingRanges[i];
+
+		if (pixels < LOD_ROOF_PIXELS)
+		{
+			out = qCopy(in + range.roofFirst, in + range.roofFirst + range.roofCount, out);
+		}
+		else
+		{
+			out = qCopy(in + range.prismFirst, in + range.prismFirst + range.prismCount, out);
+		}
+	}
+
+	return out - m_frameIndices.constData();
+}
@@ -20,10 +20,14 @@
 #define GLWIDGET_H_
 
 #include "core/volumebox.h"
+#include "core/volumetree.h"
 
 #include <QGLWidget>
+#include <QGLBuffer>
+#include <QVector>
 #include <QVector3D>
 #include <QQuaternion>
+#include <QMatrix4x4>
 
 
 //! Widget for displaying OpenGL context.
@@ -51,6 +55,12 @@ public:
 	void setTexture(QImage const & image);
 
 	//! Assigns list of buildings.
+	/*!
+	 * Terrain and building geometry is built into vertex and index arrays
+	 * here, and uploaded to the GL buffers on the next paint. Each building
+	 * gets a prism, of which only the roof is drawn in distant views, and a
+	 * place in the hierarchy used to cull buildings outside the view.
+	 */
 	void setBuildings(QVector<core::VolumeBox> const & buildings);
 
 public slots:
@@ -72,14 +82,69 @@ protected:
 	void paintGL();
 
 private:
+	//! Appends a prism over the outline to the vertex and index arrays.
+	/*!
+	 * The wall triangles are appended first, then the roof triangles.
+	 */
+	void appendPrism(QVector<math::Point2f> const & outline, float height);
+
+	//! Uploads the vertex array to the GL buffer.
+	void uploadBuffers();
+
+	//! Collects indices of the terrain and of the visible buildings into m_frameIndices.
+	/*!
+	 * \param eye eye position, in world coordinates
+	 * \param view viewing transformation
+	 * \return number of collected indices
+	 */
+	int selectIndices(QVector3D const & eye, QMatrix4x4 const & view);
+
+	//! Index ranges of one building in m_indices.
+	struct BuildingRange
+	{
+		int prismFirst, prismCount;
+		int roofFirst, roofCount;
+	};
+
+	//! Interleaved vertex attributes.
+	struct Vertex
+	{
+		GLfloat position[3];
+		GLfloat texCoord[2];
+	};
+
 	//! ID of the bound texture.
 	GLuint m_texId;
-	//! Assigned buildings.
-	QVector<core::VolumeBox> m_buildings;
+	//! Terrain and building vertices.
+	QVector<Vertex> m_vertices;
+	//! Triangle indices; terrain first, then buildings.
+	QVector<GLuint> m_indices;
+	//! Number of terrain indices.
+	int m_terrainIndexCount;
+	//! Index ranges, by building.
+	QVector<BuildingRange> m_buildingRanges;
+	//! Hierarchy over building bounds, in city coordinates.
+	core::VolumeTree m_buildingTree;
+	//! Scratch space for frustum culling.
+	QVector<int> m_visibleBuildings;
+	//! Indices drawn in the current frame; sized for the worst case.
+	QVector<GLuint> m_frameIndices;
+	//! GL copy of the vertex array.
+	QGLBuffer m_vertexBuffer;
+	//! GL buffer for the indices of each frame.
+	QGLBuffer m_indexBuffer;
+	//! Whether the arrays changed since they were uploaded.
+	bool m_buffersDirty;
+	//! Whether GL buffers are available; client-side arrays are drawn otherwise.
+	bool m_useBuffers;
 	//! Look-at vectors.
 	QVector3D m_lookAt[3];
 	//! Animation transformation.
 	QQuaternion m_quat;
+	//! Projection transformation, matching the GL one.
+	QMatrix4x4 m_projection;
+	//! Size in pixels of a unit length seen from a unit distance.
+	float m_pixelsPerUnit;
 };
 
 
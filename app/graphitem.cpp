@@ -83,6 +83,12 @@ core::Edge * EdgeGraphItem::edge() const
 	return m_edge;
 }
 
+void EdgeGraphItem::refresh()
+{
+	setPath();
+	setPen(hasFocus());
+}
+
 void EdgeGraphItem::setPath()
 {
 	QPainterPath path;
@@ -104,11 +110,11 @@ void EdgeGraphItem::setPath()
 	m_pathItem->setPath(path);
 }
 
-void EdgeGraphItem::setPen(bool focus)
+QPen EdgeGraphItem::pen(core::Edge::Types type, bool focus)
 {
 	QPen pen;
 
-	switch (edge()->type())
+	switch (type)
 	{
 	case core::Edge::TypeBridge:
 		pen.setWidth(4);
@@ -135,7 +141,12 @@ void EdgeGraphItem::setPen(bool focus)
 		pen.setColor(Qt::red);
 	}
 
-	m_pathItem->setPen(pen);
+	return pen;
+}
+
+void EdgeGraphItem::setPen(bool focus)
+{
+	m_pathItem->setPen(pen(edge()->type(), focus));
 }
 
 void EdgeGraphItem::focusInEvent(QFocusEvent * event)
@@ -157,13 +168,11 @@ void EdgeGraphItem::keyReleaseEvent(QKeyEvent * event)
 	switch (event->key())
 	{
 	case Qt::Key_B:
-		edge()->setType(shift ? core::Edge::TypeBridge : core::Edge::TypeBoundary);
-		setPen(hasFocus());
+		scene()->model().setEdgeType(edge(), shift ? core::Edge::TypeBridge : core::Edge::TypeBoundary);
 		event->accept();
 		break;
 	case Qt::Key_M:
-		edge()->setType(shift ? core::Edge::TypeMajorRoad : core::Edge::TypeMinorRoad);
-		setPen(hasFocus());
+		scene()->model().setEdgeType(edge(), shift ? core::Edge::TypeMajorRoad : core::Edge::TypeMinorRoad);
 		event->accept();
 		break;
 	default:
@@ -234,20 +243,32 @@ DistrictGraphItem::DistrictGraphItem(Scene * scene, core::District * district)
 {
 	setFlag(ItemIsFocusable);
 
-	QVector<math::Point2f> polygon = district->polygon().points();
+	QColor color = Qt::darkGray;
+	color.setAlphaF(0.5);
+
+	m_polyItem = new QGraphicsPolygonItem(this);
+	m_polyItem->setBrush(QBrush(color));
+	addToGroup(m_polyItem);
+
+	setPolygon();
+}
+
+void DistrictGraphItem::refresh()
+{
+	setPolygon();
+}
+
+void DistrictGraphItem::setPolygon()
+{
+	QVector<math::Point2f> polygon = district()->polygon().points();
 
 	QPolygonF qpolygon(polygon.size());
 	for (int i = 0; i < polygon.size(); ++i)
 	{
-		qpolygon[i] = scene->toSceneCoords(polygon[i].pos());
+		qpolygon[i] = scene()->toSceneCoords(polygon[i].pos());
 	}
 
-	QColor color = Qt::darkGray;
-	color.setAlphaF(0.5);
-
-	m_polyItem = new QGraphicsPolygonItem(qpolygon, this);
-	m_polyItem->setBrush(QBrush(color));
-	addToGroup(m_polyItem);
+	m_polyItem->setPolygon(qpolygon);
 }
 
 void DistrictGraphItem::focusInEvent(QFocusEvent * event)
@@ -20,8 +20,9 @@
 #define GRAPHITEM_H
 
 #include <QGraphicsItemGroup>
+#include <QPen>
 
-#include "core/edge.hh"
+#include "core/edge.h"
 #include "core/point.h"
 #include "core/district.hh"
 
@@ -55,6 +56,12 @@ public:
 	//! Returns the associated edge object.
 	core::Edge * edge() const;
 
+	//! Updates the item after the edge has been modified.
+	void refresh();
+
+	//! Returns the pen used to draw edges of the given type.
+	static QPen pen(core::Edge::Types type, bool focus = false);
+
 protected:
 	void focusInEvent(QFocusEvent * event);
 	void focusOutEvent(QFocusEvent * event);
@@ -101,6 +108,9 @@ public:
 
 	core::District * district() const { return m_district; }
 
+	//! Updates the item after the district's border has been modified.
+	void refresh();
+
 protected:
 	void focusInEvent(QFocusEvent * event);
 	void focusOutEvent(QFocusEvent * event);
@@ -111,6 +121,8 @@ protected:
 private:
 	core::District * m_district;
 	QGraphicsPolygonItem * m_polyItem;
+
+	void setPolygon();
 };
 
 
@@ -21,18 +21,23 @@
 #include "ui_mainwindow.h"
 #include "ui_fieldpainterview.h"
 #include "toolbox.h"
+#include "tracingdriver.h"
 #include "glwidget.h"
 #include "model.h"
 #include "view.h"
 #include "scene.h"
 #include "util.h"
 #include "core/fieldpainter.h"
+#include "core/heightmap.h"
+#include "base/profiler.h"
 
 #include <QtCore>
 #include <QtGui>
 #include <QTimer>
 #include <QProcessEnvironment>
 
+#include <stdio.h>
+
 
 MainWindow::MainWindow(QWidget *parent)
 	: QMainWindow(parent)
@@ -40,11 +45,12 @@ MainWindow::MainWindow(QWidget *parent)
 	, m_ui_fieldPainterView(new Ui_fieldPainterView)
 	, m_mdiArea(NULL)
 	, m_animationTimer(NULL)
-	, m_tracingTimer(NULL)
 	, m_previewAnimationTimer(NULL)
+	, m_tracing(NULL)
 	, m_fp(NULL)
 	, m_gl(NULL)
 	, m_view(NULL)
+	, m_toolBox(NULL)
 {
 	QSize fieldSize(257, 257);
 	QRect sceneRect(QPoint(0,0), fieldSize*3);
@@ -54,8 +60,11 @@ MainWindow::MainWindow(QWidget *parent)
 	m_model = new Model;
 	m_model->setObjectName("model");
 
-	// field painter
-	m_fp = new core::FieldPainter(fieldSize, m_model, this);
+	// tracing runs on a worker thread
+	m_tracing = new TracingDriver(m_model, this);
+
+	// field painter; the city-wide field does not change while the worker traces
+	m_fp = new core::FieldPainter(fieldSize, m_model->cityField(), this);
 
 	// OpenGL widget
 	m_gl = new GLWidget(QGLFormat(QGL::SampleBuffers), this);
@@ -64,7 +73,9 @@ MainWindow::MainWindow(QWidget *parent)
 	// field view
 	//
 	m_view = new View(this);
-	m_view->setScene(new Scene(m_model, this));
+	Scene * scene = new Scene(m_model, this);
+	scene->setChangeSource(m_tracing);
+	m_view->setScene(scene);
 	m_view->setSceneRect(sceneRect);
 	m_view->scene()->setSceneRect(sceneRect);
 	m_view->setWindowTitle("2D view");
@@ -86,17 +97,13 @@ MainWindow::MainWindow(QWidget *parent)
 	toolBoxDock->setObjectName("toolBoxDock");
 	ToolBox * toolBox = new ToolBox(toolBoxDock);
 	toolBoxDock->setWidget(toolBox);
+	m_toolBox = toolBox;
 
 	// timer for animating field flow
 	//
 	m_animationTimer = new QTimer(this);
 	m_animationTimer->setInterval(20);
 
-	// timer for animating road seeding
-	//
-	m_tracingTimer = new QTimer(this);
-	m_tracingTimer->setInterval(10);
-
 	// timer for animating road seeding
 	//
 	m_previewAnimationTimer = new QTimer(this);
@@ -117,7 +124,8 @@ MainWindow::MainWindow(QWidget *parent)
 	connect(m_ui->actionZoomOut, SIGNAL(triggered()), m_view, SLOT(zoomOut()));
 	connect(m_ui->actionZoomReset, SIGNAL(triggered()), m_view, SLOT(zoomReset()));
 	connect(m_animationTimer, SIGNAL(timeout()), this, SLOT(animationUpdate()));
-	connect(m_tracingTimer, SIGNAL(timeout()), this, SLOT(tracingUpdate()));
+	connect(m_tracing, SIGNAL(stateChanged()), this, SLOT(tracingStateChanged()));
+	connect(m_tracing, SIGNAL(batchPublished()), this, SLOT(tracingBatchPublished()));
 	connect(m_previewAnimationTimer, SIGNAL(timeout()), m_gl, SLOT(animate()));
 	connect(m_model, SIGNAL(fieldChanged()), this, SLOT(handleFieldChange()));
 	connect(toolBox, SIGNAL(toolSelected(QString)), m_view->scene(), SLOT(selectTool(QString)));
@@ -129,12 +137,15 @@ MainWindow::MainWindow(QWidget *parent)
 	on_actionViewToolbar_Tools_toggled(m_ui->actionViewToolbar_Tools->isChecked());
 
 	animationUpdate();
+	updateTracerStatistics();
 
 	resize(900,900);
 }
 
 MainWindow::~MainWindow()
 {
+	m_tracing->cancel();
+
 	delete m_ui; m_ui = NULL;
 	delete m_ui_fieldPainterView; m_ui_fieldPainterView = NULL;
 }
@@ -170,16 +181,40 @@ void MainWindow::animationUpdate()
 	}
 }
 
-void MainWindow::tracingUpdate()
+void MainWindow::tracingStateChanged()
 {
-	bool more = m_model->traceStep();
+	bool running = m_tracing->isRunning();
+
+	// scene tools would change the model under the worker thread
+	m_view->setInteractive(! running);
+	// switching road rendering reads the edges being traced
+	m_ui->actionViewTiledRoads->setEnabled(! running);
 
-	if (!more)
+	m_ui->actionBuild->setText(running ? "Pause" : m_tracing->isPaused() ? "Resume" : "Build");
+	m_ui->actionCancelTracing->setEnabled(m_tracing->isActive());
+
+	if (! running)
+	{
+		updateTracerStatistics();
+	}
+}
+
+void MainWindow::tracingBatchPublished()
+{
+	// the worker is held here, so the model can be read
+	//
+	if (m_statisticsTime.isNull() || m_statisticsTime.elapsed() >= 200)
 	{
-		m_tracingTimer->stop();
+		updateTracerStatistics();
 	}
 }
 
+void MainWindow::updateTracerStatistics()
+{
+	m_toolBox->showTracerStatistics(m_model->tracerStatistics());
+	m_statisticsTime.start();
+}
+
 void MainWindow::handleFieldChange()
 {
 	if (! m_ui->actionViewFieldEnabled->isChecked())
@@ -218,6 +253,7 @@ QImage MainWindow::boundaryImage() const
 
 void MainWindow::setBoundaryImage(QImage const & image)
 {
+	TracingDriver::Suspend suspend(m_tracing);
 	m_model->setBoundaryImage(image);
 	m_boundaryImage = image;
 	updateViewImage();
@@ -230,6 +266,7 @@ QImage MainWindow::heightMapImage() const
 
 void MainWindow::setHeightMapImage(QImage const & image)
 {
+	TracingDriver::Suspend suspend(m_tracing);
 	m_model->setHeightMapImage(image);
 	m_heightMapImage = image;
 	updateViewImage();
@@ -242,6 +279,7 @@ QImage MainWindow::populationMapImage() const
 
 void MainWindow::setPopulationMapImage(QImage const & image)
 {
+	TracingDriver::Suspend suspend(m_tracing);
 	m_model->setPopulationMapImage(image);
 	m_populationMapImage = image;
 	updateViewImage();
@@ -319,8 +357,11 @@ void MainWindow::on_toolBox_currentChanged(int index)
 
 	case 3:
 		subWindow = m_mdiArea->subWindowList()[0];
-		m_gl->setTexture(m_model->renderPreviewTexture(m_backgroundImage));
-		m_gl->setBuildings(m_model->buildings());
+		{
+			TracingDriver::Suspend suspend(m_tracing);
+			m_gl->setTexture(m_model->renderPreviewTexture(m_backgroundImage));
+			m_gl->setBuildings(m_model->buildings());
+		}
 		m_previewAnimationTimer->start();
 		break;
 	}
@@ -358,18 +399,44 @@ void MainWindow::on_toolBox_mapLoaded(QString const & name, QImage const & image
 	}
 }
 
+void MainWindow::on_toolBox_heightMapFileLoaded(QString const & path)
+{
+	core::HeightMap heightMap;
+	if (! heightMap.open(path))
+	{
+		statusBar()->showMessage(QString("Cannot load heightmap %1").arg(path), 2000);
+		return;
+	}
+
+	TracingDriver::Suspend suspend(m_tracing);
+	m_model->setHeightMap(heightMap);
+
+	// the model keeps a preview of the heights it loaded
+	m_heightMapImage = m_model->heightMapImage();
+	updateViewImage();
+}
+
 void MainWindow::on_toolBox_weightValueChanged(QString const & fieldName, float value)
 {
 	statusBar()->showMessage(QString("Set %1 weight to %2").arg(fieldName).arg(value), 2000);
+	TracingDriver::Suspend suspend(m_tracing);
 	m_model->setWeight(fieldName, value);
 }
 
 void MainWindow::on_toolBox_decayValueChanged(QString const & fieldName, float value)
 {
 	statusBar()->showMessage(QString("Set %1 decay to %2").arg(fieldName).arg(value), 2000);
+	TracingDriver::Suspend suspend(m_tracing);
 	m_model->setDecay(fieldName, value);
 }
 
+void MainWindow::on_toolBox_boundaryMethodChanged(bool distanceTransform)
+{
+	statusBar()->showMessage(distanceTransform ? "Boundary field by distance transform" : "Boundary field by radial basis", 2000);
+	TracingDriver::Suspend suspend(m_tracing);
+	m_model->setBoundaryMethod(distanceTransform ? core::BoundaryField::DistanceTransformMethod : core::BoundaryField::RadialBasisMethod);
+}
+
 void MainWindow::on_toolBox_viewingCoordsChanged(float radius, float azimuth)
 {
 	m_gl->setViewingCoords(radius, azimuth);
@@ -425,37 +492,61 @@ void MainWindow::on_actionViewFieldContinuous_toggled(bool checked)
 	}
 }
 
+void MainWindow::on_actionViewTiledRoads_toggled(bool checked)
+{
+	Scene * scene = dynamic_cast<Scene*>(m_view->scene());
+	scene->setTiledRoads(checked);
+}
+
 void MainWindow::on_actionBuild_triggered()
 {
-	if (! m_tracingTimer->isActive())
+	if (! m_tracing->isRunning())
 	{
-		m_tracingTimer->start();
+		m_tracing->start();
 	}
 	else
 	{
-		m_tracingTimer->stop();
+		m_tracing->pause();
 	}
 }
 
+void MainWindow::on_actionCancelTracing_triggered()
+{
+	m_tracing->cancel();
+}
+
+void MainWindow::on_actionTraceUnthrottled_toggled(bool checked)
+{
+	m_tracing->setPacing(checked ? TracingDriver::PacingUnthrottled : TracingDriver::PacingFrameBudget);
+}
+
 void MainWindow::on_actionRebuild_triggered()
 {
+	m_tracing->cancel();
 	m_model->clear();
-	m_tracingTimer->start();
+	updateTracerStatistics();
+	m_tracing->start();
 }
 
 void MainWindow::on_actionClear_triggered()
 {
+	m_tracing->cancel();
 	m_model->clear();
+	updateTracerStatistics();
 }
 
 void MainWindow::on_actionBuildComplete_triggered()
 {
-	m_model->traceComplete();
+	m_ui->actionTraceUnthrottled->setChecked(true);
+	m_tracing->start();
 }
 
 void MainWindow::on_actionSubregions_triggered()
 {
+	TracingDriver::Suspend suspend(m_tracing);
+
 	m_model->findSubregions();
+	updateTracerStatistics();
 }
 
 void MainWindow::on_actionExportStreetMap_triggered()
@@ -466,7 +557,29 @@ void MainWindow::on_actionExportStreetMap_triggered()
 	QString saveFile = QFileDialog::getSaveFileName(this, "Save street map", home);
 	if (! saveFile.isEmpty())
 	{
+		TracingDriver::Suspend suspend(m_tracing);
+
 		QImage streets = m_model->renderStreetMap();
 		streets.save(saveFile);
 	}
 }
+
+void MainWindow::on_actionExportProfile_triggered()
+{
+	QProcessEnvironment env = QProcessEnvironment::systemEnvironment();
+	QString home = env.value("HOME", "/home/edgy");
+
+	QString saveFile = QFileDialog::getSaveFileName(this, "Save profile", home, "Chrome trace (*.json)");
+	if (! saveFile.isEmpty())
+	{
+		base::Profiler * profiler = base::Profiler::instance();
+
+		QTextStream out(stdout);
+		profiler->writeSummary(out);
+
+		if (profiler->writeChromeTrace(saveFile))
+			statusBar()->showMessage(QString("Saved profile to %1").arg(saveFile), 2000);
+		else
+			statusBar()->showMessage(QString("Cannot save profile to %1").arg(saveFile), 2000);
+	}
+}
@@ -22,6 +22,7 @@
 #include "core/fieldpainter.hh"
 
 #include <QtGui/QMainWindow>
+#include <QtCore/QTime>
 
 class Ui_mainWindow;
 class Ui_fieldPainterView;
@@ -31,6 +32,8 @@ class QTimer;
 class GLWidget;
 class Model;
 class View;
+class ToolBox;
+class TracingDriver;
 
 
 class MainWindow : public QMainWindow
@@ -49,12 +52,14 @@ private:
 	Ui_fieldPainterView * m_ui_fieldPainterView;
 	QMdiArea * m_mdiArea;
 	QTimer * m_animationTimer;
-	QTimer * m_tracingTimer;
 	QTimer * m_previewAnimationTimer;
 	Model * m_model;
+	TracingDriver * m_tracing;
 	core::FieldPainter * m_fp;
 	GLWidget * m_gl;
 	View * m_view;
+	ToolBox * m_toolBox;
+	QTime m_statisticsTime;
 
 	QString m_currentPageName;
 	QString m_currentMapName;
@@ -75,15 +80,19 @@ private:
 	void setPopulationMapImage(QImage const & image);
 
 	void updateViewImage();
+	void updateTracerStatistics();
 						
 private slots:
 	void animationUpdate();
-	void tracingUpdate();
+	void tracingStateChanged();
+	void tracingBatchPublished();
 	void on_toolBox_currentChanged(int index);
 	void on_toolBox_mapSelected(QString const & name);
 	void on_toolBox_mapLoaded(QString const & name, QImage const & image);
+	void on_toolBox_heightMapFileLoaded(QString const & path);
 	void on_toolBox_weightValueChanged(QString const & fieldName, float value);
 	void on_toolBox_decayValueChanged(QString const & fieldName, float value);
+	void on_toolBox_boundaryMethodChanged(bool distanceTransform);
 	void on_toolBox_viewingCoordsChanged(float radius, float azimuth);
 	void on_actionQuit_triggered();
 	void on_actionViewFieldPainter_toggled(bool checked);
@@ -91,12 +100,16 @@ private slots:
 	void on_actionViewToolbar_Tools_toggled(bool checked);
 	void on_actionViewFieldContinuous_toggled(bool checked);
 	void on_actionViewFieldEnabled_toggled(bool checked);
+	void on_actionViewTiledRoads_toggled(bool checked);
 	void on_actionBuild_triggered();
+	void on_actionCancelTracing_triggered();
+	void on_actionTraceUnthrottled_toggled(bool checked);
 	void on_actionRebuild_triggered();
 	void on_actionClear_triggered();
 	void on_actionBuildComplete_triggered();
 	void on_actionSubregions_triggered();
 	void on_actionExportStreetMap_triggered();
+	void on_actionExportProfile_triggered();
 };
 
 
@@ -29,6 +29,8 @@
 #include "core/district.h"
 #include "core/block.h"
 #include "core/volumebox.h"
+#include "core/obstaclemask.h"
+#include "base/profiler.h"
 
 #include <QtCore>
 #include <QColor>
@@ -41,8 +43,8 @@ using math::Vector2f;
 
 Model::Model()
 	: core::City(NULL)
+	, m_cityField(this)
 	, m_heightField()
-	, m_discreteHeightField(20)
 	, m_boundaryField()
 	, m_discreteBoundaryField(256)
 	, m_basisSumField(DEFAULT_DECAY_USEREDIT)
@@ -54,35 +56,54 @@ Model::Model()
 	m_weights[1] = DEFAULT_WEIGHT_BOUNDARY;
 	m_weights[2] = DEFAULT_WEIGHT_USEREDIT;
 	
-	m_discreteHeightField.loadValues(m_heightField);
-	m_discreteBoundaryField.loadValues(m_boundaryField);
+	loadBoundaryValues();
 }
 
-Tensor Model::operator()(math::Vector2f const & p) const
+void Model::loadBoundaryValues()
 {
-	Tensor t;
+	// the distance-transform field is a bilinear raster already, and it is
+	// sampled directly
+	//
+	if (m_boundaryField.method() == core::BoundaryField::RadialBasisMethod)
+	{
+		m_discreteBoundaryField.loadValues(m_boundaryField);
+	}
+}
 
+Tensor Model::operator()(math::Vector2f const & p) const
+{
 	if (selectedDistrict() != NULL)
 	{
 		if (! selectedDistrict()->contains(p))
 		{
-			return t;
+			return Tensor();
 		}
 	}
 
-	if (! boundaryImage().isNull())
-	{
-		QPointF ip = boundaryImage().toImageCoords(p);
-		QRgb pixel = boundaryImage().pixel(ip.toPoint());
+	return cityTensor(p);
+}
 
-		if (QColor::fromRgba(pixel).hue() > 0)
+Tensor Model::cityTensor(math::Vector2f const & p) const
+{
+	Tensor t;
+
+	if (! m_obstacles.isNull())
+	{
+		if (m_obstacles->contains(p))
 		{
 			return t;
 		}
 	}
 
-	t += m_weights[0] * m_discreteHeightField(p);
-	t += m_weights[1] * m_discreteBoundaryField(p);
+	t += m_weights[0] * m_heightField(p);
+	if (m_boundaryField.method() == core::BoundaryField::DistanceTransformMethod)
+	{
+		t += m_weights[1] * m_boundaryField(p);
+	}
+	else
+	{
+		t += m_weights[1] * m_discreteBoundaryField(p);
+	}
 	t += m_weights[2] * m_basisSumField(p);
 
 	float n = t.value();
@@ -123,7 +144,21 @@ void Model::removeBasisField(core::BasisField * basisField)
 void Model::setBoundaryImage(QImage const & image)
 {
 	m_boundaryField.setImage(image);
-	m_discreteBoundaryField.loadValues(m_boundaryField);
+	loadBoundaryValues();
+
+	// decoded pixels of the field's image are those of the original map
+	//
+	m_obstacles.clear();
+	if (! image.isNull())
+	{
+		m_obstacles = QSharedPointer<core::ObstacleMask const>(new core::ObstacleMask(m_boundaryField.image()));
+	}
+	tracer().setObstacleMask(m_obstacles);
+	foreach (core::District * district, districts())
+	{
+		district->tracer().setObstacleMask(m_obstacles);
+	}
+
 	emit fieldChanged();
 	
 	seeder().setBoundaries(image);
@@ -133,7 +168,12 @@ void Model::setBoundaryImage(QImage const & image)
 void Model::setHeightMapImage(QImage const & image)
 {
 	m_heightField.setImage(image);
-	m_discreteHeightField.loadValues(m_heightField);
+	emit fieldChanged();
+}
+
+void Model::setHeightMap(core::HeightMap const & heightMap)
+{
+	m_heightField.setHeightMap(heightMap);
 	emit fieldChanged();
 }
 
@@ -151,7 +191,7 @@ void Model::setDecay(QString const & fieldName, float value)
 	else if (fieldName == "boundary")
 	{
 		m_boundaryField.setDecay(value);
-		m_discreteBoundaryField.loadValues(m_boundaryField);
+		loadBoundaryValues();
 	}
 	else if (fieldName == "userEdit")
 	{
@@ -165,6 +205,14 @@ void Model::setDecay(QString const & fieldName, float value)
 	emit fieldChanged();
 }
 
+void Model::setBoundaryMethod(core::BoundaryField::Method method)
+{
+	m_boundaryField.setMethod(method);
+	loadBoundaryValues();
+
+	emit fieldChanged();
+}
+
 void Model::setWeight(QString const & fieldName, float value)
 {
 	if (fieldName == "height")
@@ -225,9 +273,19 @@ void Model::removeEdge(core::Edge * edge)
 	}
 }
 
+void Model::setEdgeType(core::Edge * edge, core::Edge::Types type)
+{
+	ChangeBatch batch(this);
+
+	edge->setType(type);
+	changes().modifyEdge(edge);
+}
+
 
 void Model::traceInit()
 {
+	PROFILE_SPAN("model/traceInit");
+
 	// seeds from markers
 	//
 	foreach (core::Point seed, m_seedMarkers)
@@ -244,8 +302,8 @@ void Model::traceInit()
 	{
 		if (edge->parent() != NULL)
 		{
-			grapher().connect(edge->v1(), edge->v2());
-			emit edgeAdded(edge);
+			grapher().connect(edge);
+			changes().addEdge(edge);
 		}
 	}
 }
@@ -257,24 +315,13 @@ bool Model::traceStep()
 
 void Model::traceComplete()
 {
-	core::Tracer::EdgeList edges;
-
-	// signal all existing edges non-existant
-	//
-	edges = tracer().edges();
-	foreach (core::District * district, districts())
-	{
-		edges += district->tracer().edges();
-	}
-	foreach (core::Edge * edge, edges)
-	{
-		emit edgeRemoved(edge);
-	}
+	PROFILE_SPAN("model/traceComplete");
 
 	QTime swatch;
 	swatch.start();
 
-	blockSignals(true);
+	// views get all the new edges in one notification
+	ChangeBatch batch(this);
 
 	bool more;
 	do
@@ -283,21 +330,7 @@ void Model::traceComplete()
 	}
 	while (more);
 
- 	blockSignals(false);
-
-	qDebug() << "traced" << edges.size() << "edges in" << swatch.elapsed() << "ms";
-
-	// signal all edges as newly created
-	//
-	edges = tracer().edges();
-	foreach (core::District * district, districts())
-	{
-		edges += district->tracer().edges();
-	}
- 	foreach (core::Edge * edge, edges)
- 	{
- 		emit edgeAdded(edge);
- 	}
+	qDebug() << "traced" << changes().addedEdges().size() << "edges in" << swatch.elapsed() << "ms";
 }
 
 
@@ -326,6 +359,8 @@ QPainterPath makePath(core::Edge * edge, int width, int height)
 
 QImage Model::renderStreetMap()
 {
+	PROFILE_SPAN("model/renderStreetMap");
+
 	int width = 2048, height = 2048;
 
 	QImage image(width, height, QImage::Format_ARGB32);
@@ -396,6 +431,8 @@ QImage Model::renderStreetMap()
 
 QImage Model::renderPreviewTexture(QImage const & backgroundImage)
 {
+	PROFILE_SPAN("model/renderPreviewTexture");
+
 	int width = 2048, height = 2048;
 
 	QImage image(width, height, QImage::Format_ARGB32);
@@ -22,10 +22,11 @@
 #include "core/city.h"
 #include "core/field.h"
 #include "core/point.h"
-#include "core/edge.hh"
+#include "core/edge.h"
 #include "core/district.hh"
 #include "core/mapimage.hh"
 #include "core/volumebox.hh"
+#include "core/obstaclemask.hh"
 
 
 #define DEFAULT_DECAY_BOUNDARY    4.0f
@@ -41,8 +42,23 @@ class Model : public core::City, public virtual core::TensorField
 public:
 	Model();
 	
+	//! Returns the tensor at the specified point.
+	/*!
+	 * While a district is selected, the field is zero outside of it.
+	 */
 	math::Tensor operator()(math::Vector2f const & p) const;
 
+	//! Returns the tensor of the city-wide field, ignoring the selected district.
+	math::Tensor cityTensor(math::Vector2f const & p) const;
+
+	//! Returns the city-wide field.
+	/*!
+	 * The field does not depend on district selection, which traceStep()
+	 * changes, so it may be sampled from the GUI thread while a worker
+	 * thread traces.
+	 */
+	core::TensorField * cityField() { return &m_cityField; }
+
 //! \name Tensor field.
 //@{	
 	void addBasisField(core::BasisField * basisField);
@@ -53,6 +69,7 @@ public:
 
 	core::MapImage heightMapImage() const { return m_heightField.image(); }
 	void setHeightMapImage(QImage const & image);
+	void setHeightMap(core::HeightMap const & heightMap);
 
 	void setPopulationMapImage(QImage const & image);
 
@@ -61,6 +78,7 @@ public:
 	
 	void setDecay(QString const & fieldName, float value);
 	void setWeight(QString const & fieldName, float value);
+	void setBoundaryMethod(core::BoundaryField::Method method);
 //@}
 
 //! \name Street graph.
@@ -74,6 +92,12 @@ public:
 	 */
 	void removeEdge(core::Edge * edge);
 
+	//! Assigns the type of the specified edge.
+	/*!
+	 * The edge is reported as modified through the changed() signal.
+	 */
+	void setEdgeType(core::Edge * edge, core::Edge::Types type);
+
 	void traceInit();
 	bool traceStep();
 	void traceComplete();
@@ -89,15 +113,30 @@ signals:
 	void fieldChanged();
 
 private:
+	//! Field returned by cityField().
+	class CityField : public core::TensorField
+	{
+	public:
+		CityField(Model const * model) : m_model(model) {}
+		math::Tensor operator()(math::Vector2f const & p) const { return m_model->cityTensor(p); }
+	private:
+		Model const * m_model;
+	};
+
+	CityField m_cityField;
 	core::HeightField m_heightField;
-	core::DiscreteField m_discreteHeightField;
 	core::BoundaryField m_boundaryField;
+	//! Boundary field sampled on a lattice, used with the radial basis method.
 	core::DiscreteField m_discreteBoundaryField;
 	core::BasisSumField m_basisSumField;
 	bool m_normalize;
 	float m_weights[3];
 	QImage m_boundaryImage;
+	QSharedPointer<core::ObstacleMask const> m_obstacles;
 	QList<core::Point> m_seedMarkers;
+
+	//! Samples the boundary field into the lattice, if its method needs it.
+	void loadBoundaryValues();
 };
 
 
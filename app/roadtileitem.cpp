@@ -0,0 +1,450 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "roadtileitem.h"
+#include "app/scene.h"
+#include "app/graphitem.h"
+#include "core/edge.h"
+#include "core/point.h"
+
+#include <QtGui>
+
+#include <cmath>
+
+
+static qreal const TILE_SIZE = 64;       // in scene units
+static qreal const TILE_MARGIN = 4;      // covers half of the widest road pen
+static qreal const SIMPLE_LOD = 0.5;     // zoom below which thinned-out paths are drawn
+static qreal const SIMPLE_DISTANCE = 4;  // minimum point spacing of thinned-out paths
+static qreal const MINOR_ROAD_LOD = 0.25;
+
+
+static qreal segmentDistance(QPointF const & p, QPointF const & a, QPointF const & b)
+{
+	QPointF ab = b - a;
+	QPointF ap = p - a;
+
+	qreal len2 = ab.x()*ab.x() + ab.y()*ab.y();
+	qreal t = len2 > 0 ? (ap.x()*ab.x() + ap.y()*ab.y()) / len2 : 0;
+
+	QPointF d = ap - qBound(qreal(0), t, qreal(1)) * ab;
+
+	return std::sqrt(d.x()*d.x() + d.y()*d.y());
+}
+
+//! Appends the tiles the segment passes through, widened by the tile margin.
+/*!
+ * Walks the rows the segment spans, and in each row only the columns of the
+ * part of the segment inside the row.
+ */
+static void segmentTiles(QPointF const & a, QPointF const & b, QVector<QPoint> & tiles)
+{
+	qreal const dx = b.x() - a.x();
+	qreal const dy = b.y() - a.y();
+
+	int r0 = qFloor((qMin(a.y(), b.y()) - TILE_MARGIN) / TILE_SIZE);
+	int r1 = qFloor((qMax(a.y(), b.y()) + TILE_MARGIN) / TILE_SIZE);
+
+	for (int r = r0; r <= r1; ++r)
+	{
+		qreal x0 = qMin(a.x(), b.x());
+		qreal x1 = qMax(a.x(), b.x());
+
+		if (dy != 0)
+		{
+			// part of the segment inside the row band
+			//
+			qreal t0 = (r * TILE_SIZE - TILE_MARGIN - a.y()) / dy;
+			qreal t1 = ((r+1) * TILE_SIZE + TILE_MARGIN - a.y()) / dy;
+
+			if (t0 > t1) qSwap(t0, t1);
+
+			t0 = qMax(t0, qreal(0));
+			t1 = qMin(t1, qreal(1));
+
+			if (t0 > t1) continue;
+
+			x0 = qMin(a.x() + t0*dx, a.x() + t1*dx);
+			x1 = qMax(a.x() + t0*dx, a.x() + t1*dx);
+		}
+
+		int c0 = qFloor((x0 - TILE_MARGIN) / TILE_SIZE);
+		int c1 = qFloor((x1 + TILE_MARGIN) / TILE_SIZE);
+
+		for (int c = c0; c <= c1; ++c)
+		{
+			tiles.append(QPoint(c, r));
+		}
+	}
+}
+
+
+RoadTileItem::RoadTileItem(QRectF const & rect, QGraphicsItem * parent)
+	: QGraphicsItem(parent)
+	, m_rect(rect)
+	, m_dirty(false)
+{
+	setZValue(ZValue);
+	setCacheMode(DeviceCoordinateCache);
+}
+
+QRectF RoadTileItem::tileRect() const
+{
+	return m_rect.adjusted(-TILE_MARGIN, -TILE_MARGIN, TILE_MARGIN, TILE_MARGIN);
+}
+
+void RoadTileItem::setEdge(core::Edge * edge, core::Edge::Types type, QList<QPolygonF> const & parts)
+{
+	Road road;
+	road.type = type;
+	road.parts = parts;
+
+	m_roads.insert(edge, road);
+
+	m_dirty = true;
+	update();
+}
+
+void RoadTileItem::removeEdge(core::Edge * edge)
+{
+	if (m_roads.remove(edge) > 0)
+	{
+		m_dirty = true;
+		update();
+	}
+}
+
+bool RoadTileItem::isEmpty() const
+{
+	return m_roads.isEmpty();
+}
+
+core::Edge * RoadTileItem::edgeAt(QPointF const & pos, qreal tolerance, qreal * distance) const
+{
+	core::Edge * result = NULL;
+	qreal resultDistance = tolerance;
+
+	QHash<core::Edge *, Road>::const_iterator it;
+	for (it = m_roads.constBegin(); it != m_roads.constEnd(); ++it)
+	{
+		foreach (QPolygonF const & polyline, it.value().parts)
+		{
+			if (! polyline.boundingRect().adjusted(-tolerance, -tolerance, tolerance, tolerance).contains(pos))
+			{
+				continue;
+			}
+
+			for (int i = 1; i < polyline.size(); ++i)
+			{
+				qreal d = segmentDistance(pos, polyline[i-1], polyline[i]);
+
+				if (d <= resultDistance)
+				{
+					result = it.key();
+					resultDistance = d;
+				}
+			}
+		}
+	}
+
+	if (distance != NULL)
+	{
+		*distance = resultDistance;
+	}
+
+	return result;
+}
+
+QRectF RoadTileItem::boundingRect() const
+{
+	return tileRect();
+}
+
+void RoadTileItem::paint(QPainter * painter, QStyleOptionGraphicsItem const * /*option*/, QWidget * /*widget*/)
+{
+	if (m_roads.isEmpty()) return;
+
+	if (m_dirty)
+	{
+		rebuild();
+	}
+
+	qreal lod = QStyleOptionGraphicsItem::levelOfDetailFromTransform(painter->worldTransform());
+
+	QPainterPath const * paths = lod < SIMPLE_LOD ? m_simplePaths : m_paths;
+
+	// major roads and bridges are drawn over minor roads
+	//
+	static core::Edge::Types const order[] =
+	{
+		core::Edge::TypeZero,
+		core::Edge::TypeBoundary,
+		core::Edge::TypeMinorRoad,
+		core::Edge::TypeMajorRoad,
+		core::Edge::TypeBridge,
+	};
+
+	painter->save();
+	painter->setClipRect(tileRect(), Qt::IntersectClip);
+	painter->setBrush(Qt::NoBrush);
+
+	for (size_t i = 0; i < sizeof(order) / sizeof(order[0]); ++i)
+	{
+		core::Edge::Types type = order[i];
+
+		if (paths[type].isEmpty()) continue;
+		if (type == core::Edge::TypeMinorRoad && lod < MINOR_ROAD_LOD) continue;
+
+		painter->setPen(EdgeGraphItem::pen(type));
+		painter->drawPath(paths[type]);
+	}
+
+	painter->restore();
+}
+
+void RoadTileItem::rebuild()
+{
+	for (int i = 0; i < NumTypes; ++i)
+	{
+		m_paths[i] = QPainterPath();
+		m_simplePaths[i] = QPainterPath();
+	}
+
+	foreach (Road const & road, m_roads)
+	{
+		int type = road.type < NumTypes ? road.type : core::Edge::TypeZero;
+
+		foreach (QPolygonF const & polyline, road.parts)
+		{
+			if (polyline.isEmpty()) continue;
+
+			m_paths[type].addPolygon(polyline);
+
+			// keep the end points and drop trace points that are too close together
+			//
+			QPolygonF simple;
+
+			QPointF a = polyline.first();
+			simple.append(a);
+
+			for (int i = 1; i < polyline.size() - 1; ++i)
+			{
+				QPointF b = polyline[i];
+
+				if (QLineF(a, b).length() > SIMPLE_DISTANCE)
+				{
+					simple.append(b);
+					a = b;
+				}
+			}
+
+			simple.append(polyline.last());
+
+			m_simplePaths[type].addPolygon(simple);
+		}
+	}
+
+	m_dirty = false;
+}
+
+
+/////////////////////////////
+
+
+RoadTiles::RoadTiles(Scene * scene)
+	: m_scene(scene)
+{
+}
+
+RoadTiles::~RoadTiles()
+{
+	clear();
+}
+
+quint32 RoadTiles::tileKey(int column, int row)
+{
+	return (quint32(row & 0xffff) << 16) | quint32(column & 0xffff);
+}
+
+RoadTileItem * RoadTiles::tile(int column, int row)
+{
+	quint32 key = tileKey(column, row);
+
+	RoadTileItem * item = m_tiles.value(key, NULL);
+
+	if (item == NULL)
+	{
+		item = new RoadTileItem(QRectF(column * TILE_SIZE, row * TILE_SIZE, TILE_SIZE, TILE_SIZE));
+		m_scene->addItem(item);
+		m_tiles.insert(key, item);
+	}
+
+	return item;
+}
+
+QPolygonF RoadTiles::polyline(core::Edge * edge) const
+{
+	QPolygonF result;
+
+	result.append(m_scene->toSceneCoords(edge->v1().pos()));
+
+	foreach (core::Point const & sp, edge->trace())
+	{
+		result.append(m_scene->toSceneCoords(sp.pos()));
+	}
+
+	result.append(m_scene->toSceneCoords(edge->v2().pos()));
+
+	return result;
+}
+
+void RoadTiles::addEdge(core::Edge * edge)
+{
+	QPolygonF line = polyline(edge);
+
+	// split the polyline into runs of consecutive segments per tile
+	//
+	QHash<quint32, QList<QPolygonF> > parts;
+	QHash<quint32, int> lastSegment;
+	QVector<QPoint> crossed;
+
+	for (int i = 1; i < line.size(); ++i)
+	{
+		crossed.clear();
+		segmentTiles(line[i-1], line[i], crossed);
+
+		foreach (QPoint const & t, crossed)
+		{
+			quint32 key = tileKey(t.x(), t.y());
+			QList<QPolygonF> & tileParts = parts[key];
+
+			if (lastSegment.value(key, -1) == i-1)
+			{
+				tileParts.last().append(line[i]);
+			}
+			else
+			{
+				tileParts.append(QPolygonF() << line[i-1] << line[i]);
+			}
+
+			lastSegment.insert(key, i);
+		}
+	}
+
+	QList<RoadTileItem *> & tiles = m_edgeTiles[edge];
+
+	QHash<quint32, QList<QPolygonF> >::const_iterator it;
+	for (it = parts.constBegin(); it != parts.constEnd(); ++it)
+	{
+		// tile keys hold signed 16-bit coordinates
+		RoadTileItem * item = tile(qint16(it.key() & 0xffff), qint16(it.key() >> 16));
+		item->setEdge(edge, edge->type(), it.value());
+		tiles.append(item);
+	}
+}
+
+void RoadTiles::removeEdge(core::Edge * edge)
+{
+	pruneTiles(detachEdge(edge));
+}
+
+void RoadTiles::updateEdge(core::Edge * edge)
+{
+	if (m_edgeTiles.contains(edge))
+	{
+		// tiles the edge still crosses are kept
+		QList<RoadTileItem *> tiles = detachEdge(edge);
+		addEdge(edge);
+		pruneTiles(tiles);
+	}
+}
+
+QList<RoadTileItem *> RoadTiles::detachEdge(core::Edge * edge)
+{
+	QList<RoadTileItem *> tiles = m_edgeTiles.take(edge);
+
+	foreach (RoadTileItem * item, tiles)
+	{
+		item->removeEdge(edge);
+	}
+
+	return tiles;
+}
+
+void RoadTiles::pruneTiles(QList<RoadTileItem *> const & tiles)
+{
+	foreach (RoadTileItem * item, tiles)
+	{
+		if (! item->isEmpty()) continue;
+
+		QPointF center = item->tileRect().center();
+		m_tiles.remove(tileKey(qFloor(center.x() / TILE_SIZE), qFloor(center.y() / TILE_SIZE)));
+
+		m_scene->removeItem(item);
+		delete item;
+	}
+}
+
+core::Edge * RoadTiles::edgeAt(QPointF const & pos, qreal tolerance) const
+{
+	core::Edge * result = NULL;
+	qreal resultDistance = tolerance;
+
+	int c0 = qFloor((pos.x() - tolerance) / TILE_SIZE);
+	int c1 = qFloor((pos.x() + tolerance) / TILE_SIZE);
+	int r0 = qFloor((pos.y() - tolerance) / TILE_SIZE);
+	int r1 = qFloor((pos.y() + tolerance) / TILE_SIZE);
+
+	for (int r = r0; r <= r1; ++r)
+	{
+		for (int c = c0; c <= c1; ++c)
+		{
+			RoadTileItem * item = m_tiles.value(tileKey(c, r), NULL);
+			if (item == NULL) continue;
+
+			qreal d;
+			core::Edge * edge = item->edgeAt(pos, resultDistance, &d);
+
+			if (edge != NULL)
+			{
+				result = edge;
+				resultDistance = d;
+			}
+		}
+	}
+
+	return result;
+}
+
+QList<core::Edge *> RoadTiles::edges() const
+{
+	return m_edgeTiles.keys();
+}
+
+void RoadTiles::clear()
+{
+	foreach (RoadTileItem * item, m_tiles)
+	{
+		m_scene->removeItem(item);
+		delete item;
+	}
+
+	m_tiles.clear();
+	m_edgeTiles.clear();
+}
@@ -0,0 +1,135 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef ROADTILEITEM_H_
+#define ROADTILEITEM_H_
+
+#include "core/edge.h"
+
+#include <QGraphicsItem>
+#include <QHash>
+#include <QList>
+#include <QPainterPath>
+#include <QPolygonF>
+
+
+class Scene;
+
+
+//! Draws all roads passing through one square tile of the scene.
+/*!
+ * The tile keeps its own copy of the parts of each edge polyline that cross
+ * it, in scene coordinates, so painting never reads the street graph. Polylines are aggregated into one
+ * path per edge type, rebuilt only after one of the tile's edges changed, and
+ * the painted tile is cached as a pixmap in device coordinates.
+ *
+ * Zoomed out, the tile draws paths with thinned-out trace points, and leaves
+ * out minor roads once they are narrower than a quarter of a pixel.
+ */
+class RoadTileItem : public QGraphicsItem
+{
+public:
+	enum { ZValue = 1 };
+
+	RoadTileItem(QRectF const & rect, QGraphicsItem * parent = NULL);
+
+	//! Returns the tile area, including the margin for road width.
+	QRectF tileRect() const;
+
+	//! Adds the edge to the tile, or replaces its type and polyline parts.
+	void setEdge(core::Edge * edge, core::Edge::Types type, QList<QPolygonF> const & parts);
+	//! Removes the edge from the tile.
+	void removeEdge(core::Edge * edge);
+
+	//! Tests whether the tile has no edges left.
+	bool isEmpty() const;
+
+	//! Returns the edge closest to \a pos, or NULL if none is within \a tolerance.
+	/*!
+	 * \param distance receives the distance to the returned edge
+	 */
+	core::Edge * edgeAt(QPointF const & pos, qreal tolerance, qreal * distance) const;
+
+	QRectF boundingRect() const;
+	void paint(QPainter * painter, QStyleOptionGraphicsItem const * option, QWidget * widget);
+
+private:
+	struct Road
+	{
+		core::Edge::Types type;
+		QList<QPolygonF> parts;
+	};
+
+	enum { NumTypes = core::Edge::TypeBridge + 1 };
+
+	QRectF m_rect;
+	QHash<core::Edge *, Road> m_roads;
+	QPainterPath m_paths[NumTypes];
+	QPainterPath m_simplePaths[NumTypes];
+	bool m_dirty;
+
+	void rebuild();
+};
+
+
+//! Grid of road tiles covering a scene.
+/*!
+ * Tiles are created on demand, and deleted once their last edge is removed.
+ * An edge belongs to the tiles its polyline segments pass through, and each
+ * tile gets only the runs of segments that cross it.
+ */
+class RoadTiles
+{
+public:
+	RoadTiles(Scene * scene);
+	~RoadTiles();
+
+	//! Adds the edge to all tiles it passes through.
+	void addEdge(core::Edge * edge);
+	//! Removes the edge from its tiles; the edge object itself is not accessed.
+	void removeEdge(core::Edge * edge);
+	//! Picks up the current type and geometry of the edge.
+	void updateEdge(core::Edge * edge);
+
+	//! Returns the edge closest to \a pos, or NULL if none is within \a tolerance.
+	core::Edge * edgeAt(QPointF const & pos, qreal tolerance) const;
+
+	//! Returns all edges in the tiles.
+	QList<core::Edge *> edges() const;
+
+	//! Removes all edges and deletes the tiles.
+	void clear();
+
+private:
+	Scene * m_scene;
+	QHash<quint32, RoadTileItem *> m_tiles;
+	QHash<core::Edge *, QList<RoadTileItem *> > m_edgeTiles;
+
+	static quint32 tileKey(int column, int row);
+	RoadTileItem * tile(int column, int row);
+
+	//! Removes the edge from its tiles and returns them.
+	QList<RoadTileItem *> detachEdge(core::Edge * edge);
+	//! Deletes those of the specified tiles that have no edges left.
+	void pruneTiles(QList<RoadTileItem *> const & tiles);
+
+	QPolygonF polyline(core::Edge * edge) const;
+};
+
+
+#endif // ifndef ROADTILEITEM_H_
@@ -21,10 +21,12 @@
 #include "model.h"
 #include "app/fielditem.h"
 #include "app/graphitem.h"
+#include "app/roadtileitem.h"
 #include "core/point.h"
 #include "core/tracer.h"
 #include "core/seeder.h"
 #include "core/district.h"
+#include "core/changeset.h"
 #include "math/vector2f.h"
 #include "math/funcs.h"
 
@@ -38,20 +40,31 @@ Scene::Scene(Model * model, QObject * parent)
 	, m_model(model)
 	, m_lastKeyPress(Qt::Key_unknown)
 	, m_selectedToolName("pointerTool")
+	, m_changeSource(NULL)
+	, m_roadTiles(NULL)
+	, m_pickedEdge(NULL)
 {
 	m_cursorItem = new FieldItem_Cursor;
 	addItem(m_cursorItem);
 
-	connect(model, SIGNAL(edgeAdded(core::Edge*)), this, SLOT(on_model_edgeAdded(core::Edge*)));
-	connect(model, SIGNAL(edgeRemoved(core::Edge*)), this, SLOT(on_model_edgeRemoved(core::Edge*)));
-	connect(model, SIGNAL(seedAdded(core::Point)), this, SLOT(on_model_seedAdded(core::Point)));
-	connect(model, SIGNAL(seedRemoved(core::Point)), this, SLOT(on_model_seedRemoved(core::Point)));
-	connect(model, SIGNAL(districtAdded(core::District*)), this, SLOT(on_model_districtAdded(core::District*)));
-	connect(model, SIGNAL(districtRemoved(core::District*)), this, SLOT(on_model_districtRemoved(core::District*)));
+	setChangeSource(model);
+}
+
+void Scene::setChangeSource(QObject * source)
+{
+	if (m_changeSource != NULL)
+	{
+		disconnect(m_changeSource, NULL, this, NULL);
+	}
+
+	m_changeSource = source;
+
+	connect(source, SIGNAL(changed(core::ChangeSet)), this, SLOT(applyChanges(core::ChangeSet)));
 }
 
 Scene::~Scene()
 {
+	delete m_roadTiles;
 }
 
 
@@ -96,61 +109,28 @@ QPointF Scene::toSceneCoords(Vector2f const & fieldCoords)
 
 EdgeGraphItem * Scene::findItem(core::Edge * edge) const
 {
-	foreach (QGraphicsItem * item, items())
-	{
-		EdgeGraphItem * edgeItem = dynamic_cast<EdgeGraphItem*>(item);
-
-		if (edgeItem)
-		{
-			if (edgeItem->edge() == edge)
-			{
-				return edgeItem;
-			}
-		}
-	}
-
-	return NULL;
+	return m_edgeItems.value(edge, NULL);
 }
 
 SeedGraphItem * Scene::findItem(core::Point const & p) const
 {
-	foreach (QGraphicsItem * item, items())
-	{
-		SeedGraphItem * seedItem = dynamic_cast<SeedGraphItem*>(item);
-
-		if (seedItem)
-		{
-			if (seedItem->location() == p)
-			{
-				return seedItem;
-			}
-		}
-	}
-
-	return NULL;
+	return m_seedItems.value(p, NULL);
 }
 
 DistrictGraphItem * Scene::findItem(core::District * district) const
 {
-	foreach (QGraphicsItem * item, items())
-	{
-		DistrictGraphItem * districtItem = dynamic_cast<DistrictGraphItem*>(item);
-
-		if (districtItem)
-		{
-			if (districtItem->district() == district)
-			{
-				return districtItem;
-			}
-		}
-	}
-
-	return NULL;
+	return m_districtItems.value(district, NULL);
 }
 
 
 void Scene::clearField()
 {
+	if (m_roadTiles != NULL)
+	{
+		m_roadTiles->clear();
+	}
+	m_pickedEdge = NULL;
+
 	// remove all non-toplevel items
 	//
 	foreach (QGraphicsItem * item, items())
@@ -171,6 +151,75 @@ void Scene::clearField()
 			delete item;
 		}
 	}
+
+	m_edgeItems.clear();
+	m_seedItems.clear();
+	m_districtItems.clear();
+}
+
+void Scene::deleteItems(QList<QGraphicsItem *> const & items)
+{
+	if (items.isEmpty()) return;
+
+	// Removing items one by one from the BSP index costs a tree walk per item;
+	// for large batches it is cheaper to drop the index and let it be rebuilt.
+	//
+	ItemIndexMethod indexMethod = itemIndexMethod();
+	bool reindex = indexMethod != NoIndex && items.size() > 1000;
+
+	if (reindex) setItemIndexMethod(NoIndex);
+
+	foreach (QGraphicsItem * item, items)
+	{
+		removeItem(item);
+		delete item;
+	}
+
+	if (reindex) setItemIndexMethod(indexMethod);
+}
+
+void Scene::setTiledRoads(bool enabled)
+{
+	if (enabled == tiledRoads()) return;
+
+	if (enabled)
+	{
+		QList<QGraphicsItem *> items;
+		foreach (EdgeGraphItem * item, m_edgeItems)
+		{
+			items.append(item);
+		}
+
+		m_roadTiles = new RoadTiles(this);
+
+		foreach (core::Edge * edge, m_edgeItems.keys())
+		{
+			m_roadTiles->addEdge(edge);
+		}
+
+		m_edgeItems.clear();
+		deleteItems(items);
+	}
+	else
+	{
+		// the picked edge already has its item
+		foreach (core::Edge * edge, m_roadTiles->edges())
+		{
+			if (! m_edgeItems.contains(edge))
+			{
+				m_edgeItems.insert(edge, new EdgeGraphItem(this, edge));
+			}
+		}
+
+		delete m_roadTiles;
+		m_roadTiles = NULL;
+		m_pickedEdge = NULL;
+	}
+}
+
+bool Scene::tiledRoads() const
+{
+	return m_roadTiles != NULL;
 }
 
 void Scene::selectTool(QString const & name)
@@ -215,10 +264,70 @@ void Scene::mousePressEvent(QGraphicsSceneMouseEvent * mouseEvent)
 {
 	if (m_selectedToolName == "pointerTool")
 	{
+		if (m_roadTiles != NULL && pickEdge(mouseEvent))
+		{
+			mouseEvent->accept();
+			return;
+		}
+
 		return QGraphicsScene::mousePressEvent(mouseEvent);
 	}
 }
 
+bool Scene::pickEdge(QGraphicsSceneMouseEvent * mouseEvent)
+{
+	QPointF pos = mouseEvent->scenePos();
+
+	// items stacked above the roads, such as seeds, take precedence
+	//
+	foreach (QGraphicsItem * item, items(pos))
+	{
+		QGraphicsItem * top = item->topLevelItem();
+
+		if (top == m_cursorItem) continue;
+		if (top->zValue() > RoadTileItem::ZValue) return false;
+		break;
+	}
+
+	// pick within a few pixels of the road, whatever the zoom
+	//
+	qreal tolerance = 4;
+
+	QGraphicsView * view = mouseEvent->widget() ? qobject_cast<QGraphicsView *>(mouseEvent->widget()->parentWidget()) : NULL;
+	if (view != NULL)
+	{
+		tolerance /= QStyleOptionGraphicsItem::levelOfDetailFromTransform(view->transform());
+	}
+
+	core::Edge * edge = m_roadTiles->edgeAt(pos, tolerance);
+
+	if (edge == NULL) return false;
+
+	// only the most recently picked edge keeps its item
+	//
+	if (m_pickedEdge != NULL && m_pickedEdge != edge)
+	{
+		if (EdgeGraphItem * item = m_edgeItems.take(m_pickedEdge))
+		{
+			removeItem(item);
+			delete item;
+		}
+	}
+
+	EdgeGraphItem * item = findItem(edge);
+
+	if (item == NULL)
+	{
+		item = new EdgeGraphItem(this, edge);
+		m_edgeItems.insert(edge, item);
+	}
+
+	m_pickedEdge = edge;
+	item->setFocus();
+
+	return true;
+}
+
 void Scene::mouseReleaseEvent(QGraphicsSceneMouseEvent * mouseEvent)
 {
 	QPointF sp0 = mouseEvent->buttonDownScenePos(Qt::LeftButton);
@@ -315,63 +424,72 @@ void Scene::traceStream(math::Vector2f const & p0, math::Vector2f const & dir, b
 	model().traceField(model(), p0, dir, major);
 }
 
-void Scene::on_model_edgeAdded(core::Edge * edge)
+void Scene::applyChanges(core::ChangeSet const & changes)
 {
-	new EdgeGraphItem(this, edge);
-}
+	// removals go first, as additions may reuse addresses of deleted objects
+	//
+	QList<QGraphicsItem *> removed;
 
-void Scene::on_model_edgeRemoved(core::Edge * edge)
-{
-	EdgeGraphItem * item = findItem(edge);
+	foreach (core::Edge * edge, changes.removedEdges())
+	{
+		if (m_roadTiles != NULL) m_roadTiles->removeEdge(edge);
+		if (m_pickedEdge == edge) m_pickedEdge = NULL;
 
-	if (item != NULL)
+		if (EdgeGraphItem * item = m_edgeItems.take(edge)) removed.append(item);
+	}
+	core::ChangeSet::PointCounts::const_iterator seed;
+	for (seed = changes.removedSeeds().constBegin(); seed != changes.removedSeeds().constEnd(); ++seed)
 	{
-		removeItem(item);
-		delete item;
+		// one item per seed, each region's seed at a point is removed on its own
+		for (int i = 0; i < seed.value(); ++i)
+		{
+			if (SeedGraphItem * item = m_seedItems.take(seed.key())) removed.append(item);
+		}
 	}
-	else
+	foreach (core::District * district, changes.removedDistricts())
 	{
-		qDebug() << "no item associated with this edge";
+		if (DistrictGraphItem * item = m_districtItems.take(district)) removed.append(item);
 	}
-}
 
-void Scene::on_model_seedAdded(core::Point const & p)
-{
-	new SeedGraphItem(this, p);
-}
+	deleteItems(removed);
 
-void Scene::on_model_seedRemoved(core::Point const & p)
-{
-	SeedGraphItem * item = findItem(p);
-
-	if (item != NULL)
+	foreach (core::Edge * edge, changes.addedEdges())
 	{
-		removeItem(item);
-		delete item;
+		if (m_roadTiles != NULL)
+		{
+			m_roadTiles->addEdge(edge);
+		}
+		else
+		{
+			m_edgeItems.insert(edge, new EdgeGraphItem(this, edge));
+		}
 	}
-	else
+	for (seed = changes.addedSeeds().constBegin(); seed != changes.addedSeeds().constEnd(); ++seed)
 	{
-		qDebug() << "no item associated with this seed point";
+		for (int i = 0; i < seed.value(); ++i)
+		{
+			m_seedItems.insert(seed.key(), new SeedGraphItem(this, seed.key()));
+		}
+	}
+	foreach (core::District * district, changes.addedDistricts())
+	{
+		m_districtItems.insert(district, new DistrictGraphItem(this, district));
 	}
-}
-
-
-void Scene::on_model_districtAdded(core::District * district)
-{
-	new DistrictGraphItem(this, district);
-}
-
-void Scene::on_model_districtRemoved(core::District * district)
-{
-	DistrictGraphItem * item = findItem(district);
 
-	if (item != NULL)
+	foreach (core::Edge * edge, changes.modifiedEdges())
 	{
-		removeItem(item);
-		delete item;
+		if (m_roadTiles != NULL) m_roadTiles->updateEdge(edge);
+
+		if (EdgeGraphItem * item = findItem(edge))
+		{
+			item->refresh();
+		}
 	}
-	else
+	foreach (core::District * district, changes.modifiedDistricts())
 	{
-		qDebug() << "no item associated with this district";
+		if (DistrictGraphItem * item = findItem(district))
+		{
+			item->refresh();
+		}
 	}
 }
@@ -22,9 +22,12 @@
 #include "math/vector2f.hh"
 #include "core/point.hh"
 #include "core/edge.hh"
+#include "core/changeset.hh"
 #include "model.h"
 
 #include <QGraphicsScene>
+#include <QHash>
+#include <QMultiHash>
 
 
 class Model;
@@ -32,6 +35,7 @@ class FieldItem;
 class EdgeGraphItem;
 class SeedGraphItem;
 class DistrictGraphItem;
+class RoadTiles;
 
 
 class Scene : public QGraphicsScene
@@ -49,10 +53,23 @@ public:
 	math::Vector2f toFieldCoords(QPointF        const & sceneCoords);
 	QPointF        toSceneCoords(math::Vector2f const & fieldCoords);
 
+	//! Returns the item showing the specified edge, or NULL if there is none.
 	EdgeGraphItem * findItem(core::Edge * edge) const;
 	SeedGraphItem * findItem(core::Point const & p) const;
 	DistrictGraphItem * findItem(core::District * district) const;
 
+	//! Takes network changes from an object with the model's changed() signal, such as TracingDriver.
+	void setChangeSource(QObject * source);
+
+	//! Switches between per-edge items and tile-aggregated road rendering.
+	/*!
+	 * With tiled roads, edges are drawn by RoadTileItem tiles, and an edge
+	 * item is created only for the edge picked with the pointer tool.
+	 * Edge geometry is read, so the street graph must not change meanwhile.
+	 */
+	void setTiledRoads(bool enabled);
+	bool tiledRoads() const;
+
 public slots:
 	void clearField();
 	void selectTool(QString const & toolName);
@@ -69,17 +86,26 @@ private:
 	int m_lastKeyPress;
 	FieldItem * m_cursorItem;
 	QString m_selectedToolName;
+	QObject * m_changeSource;
+
+	// graph items by the objects they show, so that lookup does not have to scan the scene
+	QHash<core::Edge *, EdgeGraphItem *> m_edgeItems;
+	QMultiHash<core::Point, SeedGraphItem *> m_seedItems;
+	QHash<core::District *, DistrictGraphItem *> m_districtItems;
+
+	// tile-aggregated roads, or NULL if each edge has its own item
+	RoadTiles * m_roadTiles;
+	core::Edge * m_pickedEdge;
 
 	void traceLine(math::Vector2f const & p0, math::Vector2f const & p1);
 	void traceStream(math::Vector2f const & p0, math::Vector2f const & dir, bool major);
 
+	void deleteItems(QList<QGraphicsItem *> const & items);
+
+	bool pickEdge(QGraphicsSceneMouseEvent * mouseEvent);
+
 private slots:
-	void on_model_edgeAdded(core::Edge * edge);
-	void on_model_edgeRemoved(core::Edge * edge);
-	void on_model_seedAdded(core::Point const & p);
-	void on_model_seedRemoved(core::Point const & p);
-	void on_model_districtAdded(core::District * district);
-	void on_model_districtRemoved(core::District * district);
+	void applyChanges(core::ChangeSet const & changes);
 };
 
 
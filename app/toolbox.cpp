@@ -20,6 +20,7 @@
 #include "ui_toolbox.h"
 #include "model.h"
 #include "core/parameters.h"
+#include "core/heightmap.h"
 
 #include <QtGui>
 
@@ -38,6 +39,8 @@ ToolBox::ToolBox(QWidget * parent, Qt::WindowFlags flags)
 	//m_ui->heightDecay->setValue(DEFAULT_DECAY_HEIGHT);
 	m_ui->boundaryDecay->setValue(DEFAULT_DECAY_BOUNDARY);
 	m_ui->userEditDecay->setValue(DEFAULT_DECAY_USEREDIT);
+
+	m_ui->boundaryDistanceTransform->setChecked(core::Parameters::instance()->get("boundaryField/distanceTransform", false).toBool());
 	
 	connect(m_ui->heightWeight, SIGNAL(valueChanged(int)), this, SLOT(weightValueChanged(int)));
 	connect(m_ui->boundaryWeight, SIGNAL(valueChanged(int)), this, SLOT(weightValueChanged(int)));
@@ -89,6 +92,52 @@ void ToolBox::selectDefaultTool()
 }
 
 
+void ToolBox::showTracerStatistics(core::Tracer::Statistics const & statistics)
+{
+	typedef core::Tracer::Statistics Statistics;
+
+	QList< QPair<QString, QString> > rows;
+
+	rows << qMakePair(tr("RK4 steps"),           QString::number(statistics.rk4Steps));
+	rows << qMakePair(tr("Field evaluations"),   QString::number(statistics.fieldEvaluations));
+	rows << qMakePair(tr("Traces"),              QString::number(statistics.traces));
+	rows << qMakePair(tr("Sample-points"),       QString::number(statistics.samples));
+	rows << qMakePair(tr("Samples per edge"),    QString::number(statistics.samplesPerEdge(), 'f', 1));
+	rows << qMakePair(tr("Grid queries"),        QString::number(statistics.gridQueries));
+	rows << qMakePair(tr("Grid candidates"),     QString::number(statistics.gridCandidates));
+
+	for (int i = 0; i < Statistics::NumOutcomes; ++i)
+	{
+		Statistics::Outcome outcome = Statistics::Outcome(i);
+		rows << qMakePair(QString(Statistics::outcomeName(outcome)), QString::number(statistics.outcomes[i]));
+	}
+
+	rows << qMakePair(tr("Seeds consumed"),      QString::number(statistics.seedsConsumed));
+	rows << qMakePair(tr("Seeds productive"),    QString::number(statistics.seedsProductive));
+
+	QTreeWidget * tree = m_ui->statisticsTree;
+
+	// reuse existing items so that the view does not flicker while tracing
+	//
+	while (tree->topLevelItemCount() > rows.size())
+	{
+		delete tree->takeTopLevelItem(tree->topLevelItemCount() - 1);
+	}
+	while (tree->topLevelItemCount() < rows.size())
+	{
+		QTreeWidgetItem * item = new QTreeWidgetItem(tree);
+		item->setTextAlignment(1, Qt::AlignRight | Qt::AlignVCenter);
+	}
+
+	for (int i = 0; i < rows.size(); ++i)
+	{
+		QTreeWidgetItem * item = tree->topLevelItem(i);
+		item->setText(0, rows[i].first);
+		item->setText(1, rows[i].second);
+	}
+}
+
+
 void ToolBox::on_mapButtons_buttonClicked(QAbstractButton * button)
 {
 	m_currentMapName = button->objectName();
@@ -122,6 +171,14 @@ void ToolBox::on_loadMapButton_clicked()
 
 	QString path = QFileDialog::getOpenFileName();
 	if (path.isEmpty()) return;
+
+	// high-precision heightmaps are not images
+	//
+	if (button->objectName() == "heightMap" && core::HeightMap::isHeightMapFile(path))
+	{
+		emit heightMapFileLoaded(path);
+		return;
+	}
 	
 	QImage image(path);
 	if (! image.isNull())
@@ -155,6 +212,12 @@ void ToolBox::decayValueChanged(int value)
 	emit decayValueChanged(name, value);
 }
 
+void ToolBox::on_boundaryDistanceTransform_toggled(bool checked)
+{
+	core::Parameters::instance()->set("boundaryField/distanceTransform", checked);
+	emit boundaryMethodChanged(checked);
+}
+
 
 void ToolBox::on_viewingRadiusSlider_valueChanged(int value)
 {
@@ -19,6 +19,8 @@
 #ifndef TOOLBOX_H_
 #define TOOLBOX_H_
 
+#include "core/tracer.h"
+
 #include <QtGui/QToolBox>
 
 class Ui_toolBox;
@@ -34,13 +36,16 @@ public:
 
 public slots:
 	void selectDefaultTool();
+	void showTracerStatistics(core::Tracer::Statistics const & statistics);
 
 signals:
 	void toolSelected(QString const & name);
 	void mapSelected(QString const & name);
 	void mapLoaded(QString const & name, QImage const & image);
+	void heightMapFileLoaded(QString const & path);
 	void weightValueChanged(QString const & fieldName, float value);
 	void decayValueChanged(QString const & fieldName, float value);
+	void boundaryMethodChanged(bool distanceTransform);
 	void viewingCoordsChanged(float radius, float azimuth);
 	
 protected:
@@ -61,6 +66,7 @@ private slots:
 
 	virtual void weightValueChanged(int value);
 	virtual void decayValueChanged(int value);
+	virtual void on_boundaryDistanceTransform_toggled(bool checked);
 
 	virtual void on_viewingRadiusSlider_valueChanged(int value);
 	virtual void on_viewingAzimuthSlider_valueChanged(int value);
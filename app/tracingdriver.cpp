@@ -0,0 +1,274 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "tracingdriver.h"
+#include "model.h"
+#include "core/changeset.h"
+#include "core/parameters.h"
+#include "base/profiler.h"
+
+#include <QThread>
+#include <QTimer>
+#include <QTime>
+#include <QMutexLocker>
+#include <QCoreApplication>
+
+
+// interval between published batches, in milliseconds
+#define FRAME_INTERVAL 33
+
+
+//! Worker thread running TracingDriver::work().
+class TracingDriver::Thread : public QThread
+{
+public:
+	Thread(TracingDriver * driver) : QThread(driver), m_driver(driver) {}
+
+protected:
+	void run() { m_driver->work(); }
+
+private:
+	TracingDriver * m_driver;
+};
+
+
+TracingDriver::Suspend::Suspend(TracingDriver * driver)
+	: m_driver(driver)
+	, m_resume(driver->isRunning())
+{
+	if (m_resume)
+	{
+		m_driver->stopWorker();
+	}
+}
+
+TracingDriver::Suspend::~Suspend()
+{
+	if (m_resume && m_driver->isActive())
+	{
+		m_driver->startWorker();
+	}
+}
+
+
+TracingDriver::TracingDriver(Model * model, QObject * parent)
+	: QObject(parent)
+	, m_model(model)
+	, m_thread(NULL)
+	, m_frameTimer(NULL)
+	, m_pacing(PacingUnthrottled)
+	, m_frameBudget(0)
+	, m_active(false)
+	, m_collecting(false)
+	, m_finished(false)
+{
+	Q_ASSERT(model->parent() == NULL);
+
+	m_thread = new Thread(this);
+	connect(m_thread, SIGNAL(finished()), this, SLOT(onThreadFinished()));
+
+	m_frameTimer = new QTimer(this);
+	m_frameTimer->setInterval(FRAME_INTERVAL);
+	connect(m_frameTimer, SIGNAL(timeout()), this, SLOT(publish()));
+
+	// the model does not emit while the worker runs, as it is kept in a change batch
+	connect(model, SIGNAL(changed(core::ChangeSet)), this, SIGNAL(changed(core::ChangeSet)));
+}
+
+TracingDriver::~TracingDriver()
+{
+	cancel();
+}
+
+
+void TracingDriver::setPacing(Pacing pacing)
+{
+	QMutexLocker locker(&m_mutex);
+
+	m_pacing = pacing;
+	m_wake.wakeAll();
+}
+
+TracingDriver::Pacing TracingDriver::pacing() const
+{
+	return m_pacing;
+}
+
+
+bool TracingDriver::isActive() const
+{
+	return m_active;
+}
+
+bool TracingDriver::isRunning() const
+{
+	return m_collecting;
+}
+
+bool TracingDriver::isPaused() const
+{
+	return m_active && !m_collecting;
+}
+
+
+void TracingDriver::start()
+{
+	if (isRunning()) return;
+
+	m_active = true;
+	startWorker();
+
+	emit stateChanged();
+}
+
+void TracingDriver::pause()
+{
+	if (! isRunning()) return;
+
+	stopWorker();
+
+	emit stateChanged();
+}
+
+void TracingDriver::cancel()
+{
+	if (! isActive()) return;
+
+	if (isRunning())
+	{
+		stopWorker();
+	}
+
+	m_active = false;
+
+	emit stateChanged();
+}
+
+
+void TracingDriver::startWorker()
+{
+	Q_ASSERT(! m_thread->isRunning());
+
+	m_frameBudget = core::Parameters::instance()->get("tracing/frameBudget", 8).toInt();
+	m_finished = false;
+	m_stopRequest = 0;
+	m_publishRequest = 0;
+	m_collecting = true;
+
+	// changes made by the worker are taken out by publish()
+	m_model->beginChanges();
+
+	// objects the worker creates are parented to the model, so it has to live there
+	m_model->moveToThread(m_thread);
+
+	m_thread->start();
+	m_frameTimer->start();
+}
+
+void TracingDriver::stopWorker()
+{
+	m_stopRequest = 1;
+	{
+		QMutexLocker locker(&m_mutex);
+		m_wake.wakeAll();
+	}
+
+	m_thread->wait();
+	m_frameTimer->stop();
+
+	publish();
+	m_model->endChanges();
+	m_collecting = false;
+
+	if (m_finished)
+	{
+		// the worker got to the end before it was asked to stop
+		m_active = false;
+		emit stateChanged();
+	}
+}
+
+void TracingDriver::work()
+{
+	QMutexLocker locker(&m_mutex);
+
+	QTime frame;
+	frame.start();
+
+	while (! m_stopRequest)
+	{
+		if (m_publishRequest)
+		{
+			// let the GUI thread have the model
+			m_wake.wait(&m_mutex);
+			continue;
+		}
+
+		if (m_pacing == PacingFrameBudget && frame.elapsed() >= m_frameBudget)
+		{
+			// woken up by the next publishing
+			m_wake.wait(&m_mutex);
+			frame.restart();
+			continue;
+		}
+
+		if (! m_model->traceStep())
+		{
+			m_finished = true;
+			break;
+		}
+	}
+
+	m_model->moveToThread(QCoreApplication::instance()->thread());
+}
+
+void TracingDriver::onThreadFinished()
+{
+	// the worker may have been stopped and started again meanwhile
+	if (! m_collecting || m_thread->isRunning() || ! m_finished) return;
+
+	m_frameTimer->stop();
+
+	publish();
+	m_model->endChanges();
+	m_collecting = false;
+	m_active = false;
+
+	emit stateChanged();
+}
+
+
+void TracingDriver::publish()
+{
+	PROFILE_SPAN("tracing/publish");
+
+	m_publishRequest = 1;
+	QMutexLocker locker(&m_mutex);
+
+	core::ChangeSet changes = m_model->takeChanges();
+	if (! changes.isEmpty())
+	{
+		emit changed(changes);
+	}
+
+	emit batchPublished();
+
+	m_publishRequest = 0;
+	m_wake.wakeAll();
+}
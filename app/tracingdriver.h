@@ -0,0 +1,168 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef TRACINGDRIVER_H_
+#define TRACINGDRIVER_H_
+
+#include "core/changeset.hh"
+
+#include <QObject>
+#include <QMutex>
+#include <QWaitCondition>
+#include <QAtomicInt>
+
+
+class Model;
+class QThread;
+class QTimer;
+
+
+//! Runs road network tracing on a worker thread.
+/*!
+ * The worker calls Model::traceStep() until the network is complete. The
+ * model is kept in a change batch meanwhile, and the changes collected in it
+ * are published once per frame from the GUI thread by the changed() signal.
+ *
+ * While the worker runs, the model is moved to the worker thread and must not
+ * be touched from the GUI thread; wrap such changes in a Suspend object.
+ * Outside of tracing, changed() signals of the model are forwarded as they come.
+ */
+class TracingDriver : public QObject
+{
+	Q_OBJECT
+public:
+	//! Pacing of the worker thread.
+	enum Pacing
+	{
+		PacingUnthrottled, //!< Trace as fast as possible.
+		PacingFrameBudget  //!< Trace for at most "tracing/frameBudget" milliseconds per frame.
+	};
+
+	//! Pauses the worker for the lifetime of the object.
+	/*!
+	 * The model is back in the GUI thread while the object exists, and
+	 * the worker is resumed on its destruction if it was running before.
+	 */
+	class Suspend
+	{
+	public:
+		//! Pauses the worker of the specified driver.
+		explicit Suspend(TracingDriver * driver);
+		//! Resumes the worker, if it was running.
+		~Suspend();
+
+	private:
+		Q_DISABLE_COPY(Suspend)
+
+		TracingDriver * m_driver;
+		bool m_resume;
+	};
+
+public:
+	//! Constructs the object.
+	/*!
+	 * \param model model to trace, must have no parent object
+	 * \param parent parent object
+	 */
+	explicit TracingDriver(Model * model, QObject * parent = NULL);
+	//! Destroys the object, cancelling tracing first.
+	virtual ~TracingDriver();
+
+	//! Assigns the pacing of the worker thread.
+	void setPacing(Pacing pacing);
+	//! Returns the pacing of the worker thread.
+	Pacing pacing() const;
+
+	//! Returns whether tracing was started and neither finished nor cancelled.
+	bool isActive() const;
+	//! Returns whether the worker thread is tracing.
+	bool isRunning() const;
+	//! Returns whether tracing is active, but the worker is paused.
+	bool isPaused() const;
+
+public slots:
+	//! Starts tracing, or resumes it if paused.
+	void start();
+	//! Pauses tracing; the model is left as it is.
+	void pause();
+	//! Stops tracing; the model is left as it is.
+	void cancel();
+
+signals:
+	//! Emitted when tracing is started, paused, resumed, finished or cancelled.
+	void stateChanged();
+	//! Forwarded Region::changed signal.
+	void changed(core::ChangeSet const & changes);
+
+	//! Emitted after a batch of changes has been published.
+	/*!
+	 * The worker is held while this signal is delivered, so directly
+	 * connected receivers may read the model.
+	 */
+	void batchPublished();
+
+private:
+	Q_DISABLE_COPY(TracingDriver)
+
+	class Thread;
+	friend class Thread;
+
+	//! Traced model.
+	Model * m_model;
+	//! Worker thread.
+	Thread * m_thread;
+	//! Timer that publishes batches at frame rate.
+	QTimer * m_frameTimer;
+
+	//! Pacing of the worker thread, guarded by m_mutex.
+	Pacing m_pacing;
+	//! Tracing time per frame with PacingFrameBudget, in milliseconds.
+	int m_frameBudget;
+	//! Whether tracing is active.
+	bool m_active;
+	//! Whether the worker is tracing, and the model is held in a change batch.
+	bool m_collecting;
+	//! Whether the worker has traced everything.
+	bool m_finished;
+
+	//! Guards the model while the worker runs.
+	QMutex m_mutex;
+	//! Wakes the worker waiting for a frame or for publishing to finish.
+	QWaitCondition m_wake;
+	//! Set when the GUI thread wants the worker to wait for publishing.
+	QAtomicInt m_publishRequest;
+	//! Set when the GUI thread wants the worker to stop.
+	QAtomicInt m_stopRequest;
+
+	//! Body of the worker thread.
+	void work();
+
+	//! Starts the worker thread.
+	void startWorker();
+	//! Stops the worker thread, and publishes what it left.
+	void stopWorker();
+
+private slots:
+	//! Publishes the changes collected so far.
+	void publish();
+	//! Handles the worker thread stopping.
+	void onThreadFinished();
+};
+
+
+#endif // TRACINGDRIVER_H_
@@ -26,6 +26,10 @@
 #include <cstdlib>
 #include <cstring>
 
+#if defined(__SSE2__)
+#include <emmintrin.h>
+#endif
+
 
 using namespace base;
 
@@ -33,6 +37,7 @@ using namespace base;
 BitMatrix::BitMatrix(int rows, int cols)
 	: m_array(NULL)
 	, m_rows(rows), m_cols(cols)
+	, m_stride((cols + bitsPerBlock - 1) / bitsPerBlock)
 {
 	allocBlocks();
 }
@@ -40,6 +45,7 @@ BitMatrix::BitMatrix(int rows, int cols)
 BitMatrix::BitMatrix(int rows, int cols, bool fillValue)
 	: m_array(NULL)
 	, m_rows(rows), m_cols(cols)
+	, m_stride((cols + bitsPerBlock - 1) / bitsPerBlock)
 {
 	allocBlocks();
 	fill(fillValue);
@@ -48,6 +54,7 @@ BitMatrix::BitMatrix(int rows, int cols, bool fillValue)
 BitMatrix::BitMatrix(BitMatrix const & other)
 	: m_array(NULL)
 	, m_rows(other.m_rows), m_cols(other.m_cols)
+	, m_stride(other.m_stride)
 {
 	allocBlocks();
 	memcpy(m_array, other.m_array, numBlocks()*sizeof(Block));
@@ -65,6 +72,7 @@ BitMatrix & BitMatrix::operator=(BitMatrix const & other)
 
 	m_rows = other.m_rows;
 	m_cols = other.m_cols;
+	m_stride = other.m_stride;
 	allocBlocks();
 
 	memcpy(m_array, other.m_array, numBlocks()*sizeof(Block));
@@ -74,7 +82,8 @@ BitMatrix & BitMatrix::operator=(BitMatrix const & other)
 
 void BitMatrix::allocBlocks()
 {
-	m_array = new Block[(m_rows*m_cols)/bitsPerBlock + 1];
+	// zero-initialized, so that padding bits at row ends are clear
+	m_array = new Block[numBlocks()]();
 }
 
 
@@ -95,10 +104,13 @@ BitMatrix::Block & BitMatrix::getBlock(int row, int col, int & shift) const
 	if (row < 0 || row >= rows()) throw std::out_of_range("row index out of range");
 	if (col < 0 || col >= cols()) throw std::out_of_range("column index out of range");
 #endif
-	int bitIndex = row*cols() + col;
-	int blockIndex = bitIndex / bitsPerBlock;
-	shift = bitIndex % bitsPerBlock;
-	return m_array[blockIndex];
+	shift = col % bitsPerBlock;
+	return rowBlocks(row)[col / bitsPerBlock];
+}
+
+BitMatrix::Block * BitMatrix::rowBlocks(int row) const
+{
+	return m_array + row*m_stride;
 }
 
 void BitMatrix::set(int row, int col, bool value)
@@ -106,7 +118,7 @@ void BitMatrix::set(int row, int col, bool value)
 	int shift;
 	Block & block = getBlock(row, col, shift);
 
-	Block mask = 0x1 << shift;
+	Block mask = Block(1) << shift;
 	if (value)
 		block |= mask;
 	else
@@ -118,13 +130,150 @@ bool BitMatrix::get(int row, int col) const
 	int shift;
 	Block const & block = getBlock(row, col, shift);
 
-	Block mask = 0x1 << shift;
-	return block & mask;
+	Block mask = Block(1) << shift;
+	return (block & mask) != 0;
 }
 
 void BitMatrix::fill(bool value)
 {
-	memset(m_array, value?~0u:0u, numBlocks()*sizeof(Block));
+	memset(m_array, value?0xff:0x00, numBlocks()*sizeof(Block));
+
+	// keep the padding bits clear, row operations rely on that
+	//
+	int tailBits = m_cols % bitsPerBlock;
+	if (value && tailBits != 0)
+	{
+		Block mask = (Block(1) << tailBits) - 1;
+
+		for (int row = 0; row < m_rows; ++row)
+		{
+			rowBlocks(row)[m_stride-1] &= mask;
+		}
+	}
+}
+
+
+//! Returns the parity of the number of set bits in the block.
+static inline
+bool parity(uint64_t block)
+{
+#if defined(__GNUC__)
+	return __builtin_parityll(block);
+#else
+	block ^= block >> 32;
+	block ^= block >> 16;
+	block ^= block >> 8;
+	block ^= block >> 4;
+	block ^= block >> 2;
+	block ^= block >> 1;
+	return block & 1;
+#endif
+}
+
+//! Returns the index of the least significant set bit in a non-zero block.
+static inline
+int countTrailingZeros(uint64_t block)
+{
+#if defined(__GNUC__)
+	return __builtin_ctzll(block);
+#else
+	int n = 0;
+	while ((block & 1) == 0) { block >>= 1; ++n; }
+	return n;
+#endif
+}
+
+void BitMatrix::checkRows(int row, BitMatrix const & other, int otherRow) const
+{
+#if !defined(OMIT_BOUNDARY_CHECKS)
+	if (row < 0 || row >= rows()) throw std::out_of_range("row index out of range");
+	if (otherRow < 0 || otherRow >= other.rows()) throw std::out_of_range("row index out of range");
+	if (cols() != other.cols()) throw std::runtime_error("column count mismatch");
+#else
+	Q_UNUSED(row); Q_UNUSED(other); Q_UNUSED(otherRow);
+#endif
+}
+
+void BitMatrix::addRow(int row, BitMatrix const & src, int srcRow)
+{
+	checkRows(row, src, srcRow);
+
+	Block * a = rowBlocks(row);
+	Block const * b = src.rowBlocks(srcRow);
+
+	int i = 0;
+#if defined(__SSE2__)
+	for (; i+2 <= m_stride; i += 2)
+	{
+		__m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a+i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b+i));
+		_mm_storeu_si128(reinterpret_cast<__m128i *>(a+i), _mm_xor_si128(va, vb));
+	}
+#endif
+	for (; i < m_stride; ++i)
+	{
+		a[i] ^= b[i];
+	}
+}
+
+bool BitMatrix::innerProduct(int row, BitMatrix const & other, int otherRow) const
+{
+	checkRows(row, other, otherRow);
+
+	Block const * a = rowBlocks(row);
+	Block const * b = other.rowBlocks(otherRow);
+
+	// the parity of a sum of popcounts is the parity of the XOR of the words,
+	// so the words are folded first and only one parity is taken at the end
+	//
+	Block acc = 0;
+
+	int i = 0;
+#if defined(__SSE2__)
+	__m128i vacc = _mm_setzero_si128();
+	for (; i+2 <= m_stride; i += 2)
+	{
+		__m128i va = _mm_loadu_si128(reinterpret_cast<__m128i const *>(a+i));
+		__m128i vb = _mm_loadu_si128(reinterpret_cast<__m128i const *>(b+i));
+		vacc = _mm_xor_si128(vacc, _mm_and_si128(va, vb));
+	}
+	Block lanes[2];
+	_mm_storeu_si128(reinterpret_cast<__m128i *>(lanes), vacc);
+	acc = lanes[0] ^ lanes[1];
+#endif
+	for (; i < m_stride; ++i)
+	{
+		acc ^= a[i] & b[i];
+	}
+
+	return parity(acc);
+}
+
+int BitMatrix::firstSetBit(int row, int fromCol) const
+{
+#if !defined(OMIT_BOUNDARY_CHECKS)
+	if (row < 0 || row >= rows()) throw std::out_of_range("row index out of range");
+	if (fromCol < 0 || fromCol > cols()) throw std::out_of_range("column index out of range");
+#endif
+	if (fromCol >= cols()) return -1;
+
+	Block const * a = rowBlocks(row);
+
+	int i = fromCol / bitsPerBlock;
+	Block block = a[i] & (~Block(0) << (fromCol % bitsPerBlock));
+
+	for (;;)
+	{
+		if (block != 0)
+		{
+			return i*bitsPerBlock + countTrailingZeros(block);
+		}
+
+		if (++i >= m_stride) break;
+		block = a[i];
+	}
+
+	return -1;
 }
 
 
@@ -21,10 +21,15 @@
 
 #include "base/bitmatrix.hh"
 
+#include <stdint.h>
+
 
 //! A boolean-valued matrix.
 /*!
- * Internally, boolen values are packed as individual bits.
+ * Internally, boolen values are packed as individual bits. Each row
+ * starts at a word boundary, so that whole rows can be processed a word
+ * at a time by the row operations, which treat rows as vectors over the
+ * field F_2.
  */
 struct base::BitMatrix
 {
@@ -108,8 +113,43 @@ struct base::BitMatrix
 	void fill(bool value);
 //@}
 
+//! \name Row operations.
+//@{
+	//! Adds a row of another matrix to the specified row, i.e. R_row = R_row + S_srcRow.
+	/*!
+	 * The addition is done in the field F_2, i.e. it is a bitwise XOR.
+	 * Both matrices must have the same number of columns.
+	 *
+	 * \param row index of the row to be modified
+	 * \param src matrix containing the added row (can be this matrix)
+	 * \param srcRow index of the added row
+	 */
+	void addRow(int row, BitMatrix const & src, int srcRow);
+
+	//! Computes the inner (dot) product of a row and a row of another matrix.
+	/*!
+	 * The product is done in the field F_2, i.e. it is the parity of the
+	 * number of columns set in both rows. Both matrices must have the same
+	 * number of columns.
+	 *
+	 * \param row index of the row in this matrix
+	 * \param other matrix containing the second row (can be this matrix)
+	 * \param otherRow index of the second row
+	 * \return true if the product is 1
+	 */
+	bool innerProduct(int row, BitMatrix const & other, int otherRow) const;
+
+	//! Returns the index of the first set column in the specified row.
+	/*!
+	 * \param row row index
+	 * \param fromCol index of the column where the search starts
+	 * \return column index, or -1 if no column is set
+	 */
+	int firstSetBit(int row, int fromCol = 0) const;
+//@}
+
 private:
-	typedef unsigned int Block;
+	typedef uint64_t Block;
 	static const int bitsPerBlock = sizeof(Block)*8;
 
 	//! Memory for elements.
@@ -118,9 +158,17 @@ private:
 	int m_rows;
 	//! Number of columns.
 	int m_cols;
+	//! Number of blocks in one row.
+	int m_stride;
 
 	//! Returns the number of blocks needed for storage.
-	int numBlocks() const { return (m_rows*m_cols)/bitsPerBlock + 1; }
+	int numBlocks() const { return m_rows*m_stride + 1; }
+
+	//! Returns the pointer to the first block of the specified row.
+	Block * rowBlocks(int row) const;
+
+	//! Checks that the row of another matrix can be combined with the specified row.
+	void checkRows(int row, BitMatrix const & other, int otherRow) const;
 
 	//! Allocates enough blocks for storage.
 	void allocBlocks();
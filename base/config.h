@@ -21,4 +21,7 @@
 
 #undef OMIT_BOUNDARY_CHECKS
 
+// ENABLE_PROFILER compiles in the PROFILE_SPAN instrumentation of base/profiler.h,
+// it is defined by building with "qmake CONFIG+=profiler"
+
 #endif // ifndef BASE_CONFIG_H
@@ -0,0 +1,356 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "base/profiler.h"
+
+#include <QFile>
+#include <QHash>
+#include <QMap>
+#include <QMutexLocker>
+#include <QSet>
+#include <QThread>
+#include <QCoreApplication>
+#include <QVector>
+#include <QtAlgorithms>
+
+using namespace base;
+
+
+//! Maximum number of span events kept per thread; counters are always kept.
+static int const maxEventsPerThread = 1 << 20;
+
+
+//! A finished span.
+struct Profiler::Event
+{
+	char const * name;
+	//! Start time in nanoseconds.
+	qint64 start;
+	//! Duration in nanoseconds.
+	qint64 duration;
+};
+
+//! An open span.
+struct Profiler::Frame
+{
+	//! Total time of finished nested spans.
+	qint64 children;
+};
+
+//! Statistics of one span name on one thread.
+struct Profiler::ThreadCounter
+{
+	qint64 calls, total, self, max;
+
+	ThreadCounter() : calls(0), total(0), self(0), max(0) {}
+};
+
+//! Everything recorded by one thread.
+/*!
+ * Open spans are touched only by the owning thread. Finished spans are
+ * guarded by the mutex, so they can be read while the thread records.
+ */
+struct Profiler::ThreadBuffer
+{
+	//! Sequential thread number.
+	int index;
+	//! Human-readable thread name.
+	QString name;
+	//! Open spans, innermost last.
+	QVector<Frame> stack;
+
+	//! Guards the members below.
+	QMutex mutex;
+	//! Finished spans, in order of completion.
+	QVector<Event> events;
+	//! Number of spans not kept in events.
+	qint64 dropped;
+	//! Statistics keyed by span name.
+	QHash<char const *, ThreadCounter> counters;
+};
+
+//! Per-thread reference to a buffer.
+/*!
+ * QThreadStorage deletes its data when the thread exits, but recordings
+ * must outlive pooled threads, so the buffer itself is owned by the profiler.
+ */
+struct Profiler::BufferRef
+{
+	ThreadBuffer * buffer;
+};
+
+
+Profiler * Profiler::instance()
+{
+	// spans are opened from worker threads, so the instance is created on first
+	// use with thread-safe static initialization, and never destroyed
+	//
+	static Profiler * s_instance = new Profiler();
+
+	return s_instance;
+}
+
+bool Profiler::isAvailable()
+{
+#ifdef ENABLE_PROFILER
+	return true;
+#else
+	return false;
+#endif
+}
+
+Profiler::Profiler()
+	: m_enabled(true)
+{
+	m_clock.start();
+}
+
+Profiler::~Profiler()
+{
+	qDeleteAll(m_buffers);
+}
+
+Profiler::ThreadBuffer * Profiler::buffer()
+{
+	if (m_local.hasLocalData())
+	{
+		return m_local.localData()->buffer;
+	}
+
+	ThreadBuffer * buffer = new ThreadBuffer;
+	buffer->dropped = 0;
+
+	QCoreApplication * app = QCoreApplication::instance();
+	bool isMain = (app != NULL && app->thread() == QThread::currentThread());
+
+	{
+		QMutexLocker locker(&m_mutex);
+
+		buffer->index = m_buffers.size() + 1;
+		buffer->name = isMain ? QString("main") : QString("worker %1").arg(buffer->index);
+		m_buffers.append(buffer);
+	}
+
+	BufferRef * ref = new BufferRef;
+	ref->buffer = buffer;
+	m_local.setLocalData(ref);
+
+	return buffer;
+}
+
+qint64 Profiler::begin(ThreadBuffer * buffer)
+{
+	Frame frame;
+	frame.children = 0;
+	buffer->stack.append(frame);
+
+	return m_clock.nsecsElapsed();
+}
+
+void Profiler::end(ThreadBuffer * buffer, char const * name, qint64 start)
+{
+	qint64 duration = m_clock.nsecsElapsed() - start;
+
+	qint64 self = duration - buffer->stack.last().children;
+	buffer->stack.pop_back();
+	if (! buffer->stack.empty())
+	{
+		buffer->stack.last().children += duration;
+	}
+
+	QMutexLocker locker(&buffer->mutex);
+
+	ThreadCounter & counter = buffer->counters[name];
+	counter.calls += 1;
+	counter.total += duration;
+	counter.self  += self;
+	counter.max    = qMax(counter.max, duration);
+
+	if (buffer->events.size() < maxEventsPerThread)
+	{
+		Event event = { name, start, duration };
+		buffer->events.append(event);
+	}
+	else
+	{
+		buffer->dropped += 1;
+	}
+}
+
+void Profiler::clear()
+{
+	QMutexLocker locker(&m_mutex);
+
+	foreach (ThreadBuffer * buffer, m_buffers)
+	{
+		QMutexLocker bufferLocker(&buffer->mutex);
+
+		buffer->events.clear();
+		buffer->dropped = 0;
+		buffer->counters.clear();
+	}
+}
+
+//! Orders counters by decreasing self time.
+static
+bool bySelfTime(Profiler::Counter const & a, Profiler::Counter const & b)
+{
+	return a.self > b.self;
+}
+
+QList<Profiler::Counter> Profiler::counters() const
+{
+	// the same name may be recorded from several copies of a string literal,
+	// so counters are merged by name, not by pointer
+	//
+	QMap<QString, Counter> merged;
+
+	QMutexLocker locker(&m_mutex);
+
+	foreach (ThreadBuffer * buffer, m_buffers)
+	{
+		QMutexLocker bufferLocker(&buffer->mutex);
+
+		QSet<QString> seen;
+
+		QHash<char const *, ThreadCounter>::const_iterator it;
+		for (it = buffer->counters.constBegin(); it != buffer->counters.constEnd(); ++it)
+		{
+			QString name = QString::fromLatin1(it.key());
+
+			Counter & counter = merged[name];
+			counter.name   = name;
+			counter.calls += it.value().calls;
+			counter.total += it.value().total;
+			counter.self  += it.value().self;
+			counter.max    = qMax(counter.max, it.value().max);
+
+			if (! seen.contains(name))
+			{
+				seen.insert(name);
+				counter.threads += 1;
+			}
+		}
+	}
+
+	QList<Counter> result = merged.values();
+	qSort(result.begin(), result.end(), bySelfTime);
+
+	return result;
+}
+
+void Profiler::writeSummary(QTextStream & out) const
+{
+	if (! isAvailable())
+	{
+		out << "profiler not compiled in, rebuild with CONFIG+=profiler" << endl;
+		return;
+	}
+
+	out << qSetFieldWidth(28) << left << "span"
+		<< qSetFieldWidth(10) << right << "calls"
+		<< qSetFieldWidth(12) << "total [ms]" << "self [ms]" << "mean [us]" << "max [ms]"
+		<< qSetFieldWidth(9) << "threads"
+		<< qSetFieldWidth(0) << endl;
+
+	foreach (Counter const & counter, counters())
+	{
+		out << qSetFieldWidth(28) << left << counter.name
+			<< qSetFieldWidth(10) << right << counter.calls
+			<< qSetFieldWidth(12)
+			<< QString::number(counter.total * 1e-6, 'f', 2)
+			<< QString::number(counter.self * 1e-6, 'f', 2)
+			<< QString::number(counter.total * 1e-3 / qMax(counter.calls, qint64(1)), 'f', 1)
+			<< QString::number(counter.max * 1e-6, 'f', 2)
+			<< qSetFieldWidth(9) << counter.threads
+			<< qSetFieldWidth(0) << endl;
+	}
+}
+
+bool Profiler::writeChromeTrace(QString const & path) const
+{
+	QFile file(path);
+	if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		return false;
+	}
+
+	QTextStream out(&file);
+	bool first = true;
+
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[";
+
+	QMutexLocker locker(&m_mutex);
+
+	foreach (ThreadBuffer * buffer, m_buffers)
+	{
+		QMutexLocker bufferLocker(&buffer->mutex);
+
+		// thread name metadata
+		//
+		out << (first ? "\n" : ",\n")
+			<< "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":1,\"tid\":" << buffer->index
+			<< ",\"args\":{\"name\":\"" << buffer->name << "\"}}";
+		first = false;
+
+		// complete events, timestamps in microseconds
+		//
+		foreach (Event const & event, buffer->events)
+		{
+			out << ",\n{\"name\":\"" << event.name
+				<< "\",\"ph\":\"X\",\"pid\":1,\"tid\":" << buffer->index
+				<< ",\"ts\":" << QString::number(event.start * 1e-3, 'f', 3)
+				<< ",\"dur\":" << QString::number(event.duration * 1e-3, 'f', 3)
+				<< "}";
+		}
+
+		if (buffer->dropped > 0)
+		{
+			qWarning("profiler: %lld events of thread %d were not kept", buffer->dropped, buffer->index);
+		}
+	}
+
+	out << "\n]}\n";
+	out.flush();
+
+	return file.error() == QFile::NoError;
+}
+
+
+ProfileSpan::ProfileSpan(char const * name)
+	: m_name(name)
+	, m_buffer(NULL)
+	, m_start(0)
+{
+	Profiler * profiler = Profiler::instance();
+
+	if (profiler->isEnabled())
+	{
+		m_buffer = profiler->buffer();
+		m_start = profiler->begin(m_buffer);
+	}
+}
+
+ProfileSpan::~ProfileSpan()
+{
+	if (m_buffer != NULL)
+	{
+		Profiler::instance()->end(m_buffer, m_name, m_start);
+	}
+}
@@ -0,0 +1,166 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BASE_PROFILER_H
+#define BASE_PROFILER_H
+
+#include "base/profiler.hh"
+#include "base/config.h"
+
+#include <QElapsedTimer>
+#include <QList>
+#include <QMutex>
+#include <QString>
+#include <QTextStream>
+#include <QThreadStorage>
+
+
+//! Marks the rest of the enclosing scope as a named profiler span.
+/*!
+ * The name must be a string literal. Spans are compiled out unless
+ * ENABLE_PROFILER is defined, see base/config.h.
+ */
+#ifdef ENABLE_PROFILER
+#define PROFILE_SPAN(name) base::ProfileSpan PROFILE_SPAN_VAR(__LINE__)(name)
+#define PROFILE_SPAN_VAR(line) PROFILE_SPAN_VAR2(line)
+#define PROFILE_SPAN_VAR2(line) profileSpan_##line
+#else
+#define PROFILE_SPAN(name) ((void)0)
+#endif
+
+
+//! Collects timed spans of the program's phases.
+/*!
+ * Every thread records into its own buffer, so threads do not contend
+ * with one another. Per thread and per span name, the profiler counts
+ * calls, total time and self time, which is the total time less the
+ * time of nested spans. Individual span events are kept as well, up to
+ * a limit, for export in the Chrome trace-event format.
+ */
+class base::Profiler
+{
+public:
+	//! Aggregated statistics of one span name.
+	struct Counter
+	{
+		//! Span name.
+		QString name;
+		//! Number of finished spans.
+		qint64 calls;
+		//! Total time in nanoseconds.
+		qint64 total;
+		//! Total time less the time of nested spans.
+		qint64 self;
+		//! Longest span.
+		qint64 max;
+		//! Number of threads that recorded the span.
+		int threads;
+
+		Counter() : calls(0), total(0), self(0), max(0), threads(0) {}
+	};
+
+	//! Returns the global instance.
+	static Profiler * instance();
+
+	//! Tests whether the profiler was compiled in.
+	static bool isAvailable();
+
+	//! Turns recording on or off, it is on initially.
+	void setEnabled(bool enabled) { m_enabled = enabled; }
+
+	//! Tests whether recording is on.
+	bool isEnabled() const { return m_enabled; }
+
+	//! Discards everything recorded so far.
+	void clear();
+
+	//! Returns counters of all span names, summed over threads.
+	QList<Counter> counters() const;
+
+	//! Writes a table of counters, ordered by self time.
+	void writeSummary(QTextStream & out) const;
+
+	//! Writes recorded span events as Chrome trace-event JSON.
+	/*!
+	 * The file can be opened in chrome://tracing or Perfetto.
+	 *
+	 * \return whether the file was written successfully
+	 */
+	bool writeChromeTrace(QString const & path) const;
+
+private:
+	struct Event;
+	struct Frame;
+	struct ThreadCounter;
+	struct ThreadBuffer;
+	struct BufferRef;
+
+	friend class ProfileSpan;
+
+	//! Recording switch.
+	volatile bool m_enabled;
+	//! Clock of all timestamps.
+	QElapsedTimer m_clock;
+	//! Buffers of all threads that ever recorded, owned by the profiler.
+	QList<ThreadBuffer *> m_buffers;
+	//! Guards m_buffers.
+	mutable QMutex m_mutex;
+	//! Buffer of the current thread.
+	QThreadStorage<BufferRef *> m_local;
+
+	Profiler();
+	~Profiler();
+
+	//! Returns the buffer of the current thread, creating it if needed.
+	ThreadBuffer * buffer();
+
+	//! Opens a span on the current thread, returns its start time.
+	qint64 begin(ThreadBuffer * buffer);
+	//! Closes the innermost span of the current thread.
+	void end(ThreadBuffer * buffer, char const * name, qint64 start);
+
+private:
+	Profiler(Profiler const &);
+	Profiler & operator=(Profiler const &);
+};
+
+
+//! A profiler span that lasts for the lifetime of the object.
+/*!
+ * Use the PROFILE_SPAN macro instead of this class directly, so spans
+ * are compiled out when profiling is disabled.
+ */
+class base::ProfileSpan
+{
+public:
+	//! Opens the span.
+	explicit ProfileSpan(char const * name);
+	//! Closes the span.
+	~ProfileSpan();
+
+private:
+	char const * m_name;
+	Profiler::ThreadBuffer * m_buffer;
+	qint64 m_start;
+
+	ProfileSpan(ProfileSpan const &);
+	ProfileSpan & operator=(ProfileSpan const &);
+};
+
+
+#endif // ifndef BASE_PROFILER_H
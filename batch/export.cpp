@@ -0,0 +1,145 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "export.h"
+#include "app/model.h"
+#include "core/edge.h"
+#include "core/tracer.h"
+#include "core/district.h"
+#include "core/block.h"
+#include "math/polygon.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+
+//! Returns the GeoJSON position of the specified point.
+static
+QString position(core::Point const & p)
+{
+	return QString("[%1,%2]").arg(p.x(), 0, 'g', 7).arg(p.y(), 0, 'g', 7);
+}
+
+//! Returns the GeoJSON coordinates of the specified polygon's outer ring.
+static
+QString ring(math::Polygon const & polygon)
+{
+	QVector<core::Point> points = polygon.points();
+	QStringList positions;
+
+	foreach (core::Point const & p, points)
+	{
+		positions << position(p);
+	}
+	if (! points.empty())
+	{
+		// rings are explicitly closed
+		positions << position(points.first());
+	}
+
+	return QString("[[%1]]").arg(positions.join(","));
+}
+
+//! Returns the GeoJSON coordinates of the specified edge.
+static
+QString lineString(core::Edge const * edge)
+{
+	QStringList positions;
+
+	positions << position(edge->v1());
+	foreach (core::Point const & p, edge->trace())
+	{
+		positions << position(p);
+	}
+	positions << position(edge->v2());
+
+	return QString("[%1]").arg(positions.join(","));
+}
+
+//! Writes one feature.
+static
+void writeFeature(QTextStream & out, bool & first, QString const & geometry, QString const & coordinates, QString const & properties)
+{
+	out << (first ? "\n" : ",\n")
+		<< "{\"type\":\"Feature\",\"geometry\":{\"type\":\"" << geometry
+		<< "\",\"coordinates\":" << coordinates
+		<< "},\"properties\":{" << properties << "}}";
+
+	first = false;
+}
+
+bool writeGeoJson(Model const & model, QString const & path)
+{
+	QFile file(path);
+	if (! file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text))
+	{
+		qWarning() << "cannot write" << path;
+		return false;
+	}
+
+	QTextStream out(&file);
+	bool first = true;
+
+	out << "{\"type\":\"FeatureCollection\",\"features\":[";
+
+	// roads
+	//
+	core::Tracer::EdgeList edges = model.tracer().edges();
+	foreach (core::District * district, model.districts())
+	{
+		edges += district->tracer().edges();
+	}
+
+	foreach (core::Edge * edge, edges)
+	{
+		QString type;
+		switch (edge->type())
+		{
+		case core::Edge::TypeMajorRoad: type = "major";  break;
+		case core::Edge::TypeMinorRoad: type = "minor";  break;
+		case core::Edge::TypeBridge:    type = "bridge"; break;
+		default:
+			continue;
+		}
+
+		writeFeature(out, first, "LineString", lineString(edge), QString("\"kind\":\"road\",\"type\":\"%1\"").arg(type));
+	}
+
+	// districts and their blocks
+	//
+	int districtIndex = 0;
+	foreach (core::District * district, model.districts())
+	{
+		writeFeature(out, first, "Polygon", ring(district->polygon()), QString("\"kind\":\"district\",\"id\":%1").arg(districtIndex));
+
+		foreach (core::Block * block, district->blocks())
+		{
+			writeFeature(out, first, "Polygon", ring(block->polygon()), QString("\"kind\":\"block\",\"district\":%1").arg(districtIndex));
+		}
+
+		++districtIndex;
+	}
+
+	out << "\n]}\n";
+	out.flush();
+
+	return file.error() == QFile::NoError;
+}
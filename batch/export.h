@@ -0,0 +1,40 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BATCH_EXPORT_H_
+#define BATCH_EXPORT_H_
+
+#include <QString>
+
+class Model;
+
+
+//! Writes the street network, districts and blocks as a GeoJSON file.
+/*!
+ * Roads are LineString features whose "type" property is "major", "minor"
+ * or "bridge". Districts and blocks are Polygon features. Coordinates are
+ * in field units, with the origin in the lower left corner.
+ *
+ * \param model model to export
+ * \param path file to write
+ * \return whether the file was written successfully
+ */
+bool writeGeoJson(Model const & model, QString const & path);
+
+
+#endif // ifndef BATCH_EXPORT_H_
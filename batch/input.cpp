@@ -0,0 +1,171 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input.h"
+#include "core/field.h"
+#include "core/parameters.h"
+#include "math/vector2f.h"
+
+#include <QDebug>
+#include <QFile>
+#include <QStringList>
+#include <QTextStream>
+
+
+using math::Vector2f;
+
+
+//! Returns the singularity type with the specified name, or 0 if unknown.
+static
+core::BasisField::SingularityType singularityType(QString const & name)
+{
+	static char const * names[] =
+	{
+		"center", "wedge", "node", "trisector", "saddle", "focus"
+	};
+	static core::BasisField::SingularityType const types[] =
+	{
+		core::BasisField::SingularityType_Center,
+		core::BasisField::SingularityType_Wedge,
+		core::BasisField::SingularityType_Node,
+		core::BasisField::SingularityType_Trisector,
+		core::BasisField::SingularityType_Saddle,
+		core::BasisField::SingularityType_Focus
+	};
+
+	for (unsigned int i = 0; i < sizeof(types)/sizeof(types[0]); ++i)
+	{
+		if (name == names[i])
+		{
+			return types[i];
+		}
+	}
+
+	return (core::BasisField::SingularityType)0;
+}
+
+//! Parses all tokens as floats.
+static
+bool toFloats(QStringList const & tokens, QList<float> & values)
+{
+	foreach (QString const & token, tokens)
+	{
+		bool ok;
+		values.append(token.toFloat(&ok));
+
+		if (!ok) return false;
+	}
+
+	return true;
+}
+
+bool loadBasisDefinitions(QString const & path, BasisDefinitions & defs)
+{
+	QFile file(path);
+	if (! file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning() << "cannot open basis file" << path;
+		return false;
+	}
+
+	QTextStream in(&file);
+
+	for (int lineNumber = 1; !in.atEnd(); ++lineNumber)
+	{
+		QString line = in.readLine().trimmed();
+		if (line.isEmpty() || line.startsWith('#'))
+		{
+			continue;
+		}
+
+		QStringList tokens = line.split(QRegExp("\\s+"));
+		QString kind = tokens.takeFirst().toLower();
+
+		QList<float> v;
+		if (! toFloats(tokens, v))
+		{
+			qWarning() << path << lineNumber << ": invalid number";
+			return false;
+		}
+
+		if (kind == "seed" && v.size() == 2)
+		{
+			defs.seeds.append(core::Point(v[0], v[1]));
+		}
+		else if (kind == "regular" && v.size() == 5)
+		{
+			defs.fields.append(new core::BasisField(Vector2f(v[0], v[1]), v[2], Vector2f(v[3], v[4])));
+		}
+		else if (singularityType(kind) != 0 && v.size() == 3)
+		{
+			defs.fields.append(new core::BasisField(Vector2f(v[0], v[1]), v[2], singularityType(kind)));
+		}
+		else
+		{
+			qWarning() << path << lineNumber << ": invalid definition" << line;
+			return false;
+		}
+	}
+
+	return true;
+}
+
+bool assignParameter(QString const & assignment)
+{
+	int eq = assignment.indexOf('=');
+	if (eq <= 0)
+	{
+		qWarning() << "invalid parameter assignment" << assignment;
+		return false;
+	}
+
+	QString key = assignment.left(eq).trimmed();
+	QString value = assignment.mid(eq+1).trimmed();
+
+	core::Parameters::instance()->set(key, value);
+	return true;
+}
+
+bool loadParameters(QString const & path)
+{
+	QFile file(path);
+	if (! file.open(QIODevice::ReadOnly | QIODevice::Text))
+	{
+		qWarning() << "cannot open parameter file" << path;
+		return false;
+	}
+
+	QTextStream in(&file);
+
+	while (! in.atEnd())
+	{
+		QString line = in.readLine().trimmed();
+		if (line.isEmpty() || line.startsWith('#'))
+		{
+			continue;
+		}
+
+		if (! assignParameter(line))
+		{
+			return false;
+		}
+	}
+
+	return true;
+}
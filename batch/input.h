@@ -0,0 +1,71 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BATCH_INPUT_H_
+#define BATCH_INPUT_H_
+
+#include "core/field.hh"
+#include "core/point.h"
+
+#include <QList>
+#include <QString>
+
+
+//! Tensor field elements and seeds read from a basis-field file.
+struct BasisDefinitions
+{
+	//! Basis fields, owned by the caller.
+	QList<core::BasisField *> fields;
+	//! Seed markers.
+	QList<core::Point> seeds;
+};
+
+//! Reads basis-field definitions from a text file.
+/*!
+ * Each line defines one element, in field coordinates:
+ *
+ * \code
+ * regular x y scale dx dy
+ * center|wedge|node|trisector|saddle|focus x y scale
+ * seed x y
+ * \endcode
+ *
+ * Empty lines and lines starting with '#' are ignored.
+ *
+ * \param path file to read
+ * \param defs receives the definitions
+ * \return whether the whole file was read successfully
+ */
+bool loadBasisDefinitions(QString const & path, BasisDefinitions & defs);
+
+//! Assigns a global parameter from a "key=value" string.
+/*!
+ * \return whether the string was a valid assignment
+ */
+bool assignParameter(QString const & assignment);
+
+//! Assigns global parameters from a file of "key=value" lines.
+/*!
+ * Empty lines and lines starting with '#' are ignored.
+ *
+ * \return whether the whole file was read successfully
+ */
+bool loadParameters(QString const & path);
+
+
+#endif // ifndef BATCH_INPUT_H_
@@ -0,0 +1,336 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "input.h"
+#include "export.h"
+#include "phasetimer.h"
+#include "app/model.h"
+#include "core/field.h"
+#include "core/heightmap.h"
+#include "base/profiler.h"
+
+#include <QtGui/QApplication>
+#include <QDebug>
+#include <QDir>
+#include <QImage>
+#include <QStringList>
+#include <QTextStream>
+
+#include <stdio.h>
+
+
+//! Command line options.
+struct Options
+{
+	//! Input map files.
+	QString boundaryFile, heightFile, populationFile;
+	//! Basis-field definitions file.
+	QString basisFile;
+	//! Directory the results are written to.
+	QString outputDir;
+	//! Chrome trace file of profiler spans, empty if not wanted.
+	QString profileFile;
+	//! Field weights and decays, as "name=value" strings.
+	QStringList weights, decays;
+};
+
+
+//! Prints command line usage.
+static
+void usage()
+{
+	QTextStream err(stderr);
+
+	err << "usage: newtown-batch [options] OUTPUT_DIR" << endl
+		<< endl
+		<< "  --boundary FILE      boundary map image" << endl
+		<< "  --height FILE        height map image, or PGM/PFM/raw height map" << endl
+		<< "  --population FILE    population density image" << endl
+		<< "  --basis FILE         basis-field and seed definitions" << endl
+		<< "  --params FILE        file of KEY=VALUE parameter lines" << endl
+		<< "  --set KEY=VALUE      parameter, e.g. tracer/major/distSep=0.05" << endl
+		<< "  --weight FIELD=VALUE weight of the height, boundary or userEdit field" << endl
+		<< "  --decay FIELD=VALUE  decay of the boundary or userEdit field" << endl
+		<< "  --profile FILE       write profiler spans as Chrome trace JSON" << endl;
+}
+
+//! Parses the command line, assigning parameters as they are encountered.
+static
+bool parseArguments(QStringList args, Options & options)
+{
+	args.removeFirst();
+
+	while (! args.empty())
+	{
+		QString arg = args.takeFirst();
+
+		if (! arg.startsWith("--"))
+		{
+			if (! options.outputDir.isEmpty()) return false;
+			options.outputDir = arg;
+			continue;
+		}
+
+		if (args.empty())
+		{
+			qWarning() << "missing value for" << arg;
+			return false;
+		}
+
+		QString value = args.takeFirst();
+
+		if      (arg == "--boundary")   options.boundaryFile = value;
+		else if (arg == "--height")     options.heightFile = value;
+		else if (arg == "--population") options.populationFile = value;
+		else if (arg == "--basis")      options.basisFile = value;
+		else if (arg == "--weight")     options.weights << value;
+		else if (arg == "--decay")      options.decays << value;
+		else if (arg == "--profile")    options.profileFile = value;
+		else if (arg == "--params")
+		{
+			if (! loadParameters(value)) return false;
+		}
+		else if (arg == "--set")
+		{
+			if (! assignParameter(value)) return false;
+		}
+		else
+		{
+			qWarning() << "unknown option" << arg;
+			return false;
+		}
+	}
+
+	return ! options.outputDir.isEmpty();
+}
+
+//! Loads an image, reporting failure.
+static
+bool loadImage(QString const & path, QImage & image)
+{
+	if (! image.load(path))
+	{
+		qWarning() << "cannot load image" << path;
+		return false;
+	}
+
+	return true;
+}
+
+//! Applies "name=value" settings through the specified model setter.
+static
+bool applyFieldSettings(Model & model, QStringList const & settings, void (Model::*setter)(QString const &, float))
+{
+	foreach (QString const & setting, settings)
+	{
+		QStringList parts = setting.split('=');
+		bool ok = parts.size() == 2;
+		float value = ok ? parts[1].toFloat(&ok) : 0.0f;
+
+		if (!ok)
+		{
+			qWarning() << "invalid field setting" << setting;
+			return false;
+		}
+
+		(model.*setter)(parts[0].trimmed(), value);
+	}
+
+	return true;
+}
+
+//! Sets up the model inputs.
+static
+bool loadInputs(Model & model, Options const & options, BasisDefinitions & defs)
+{
+	QImage image;
+
+	if (! options.boundaryFile.isEmpty())
+	{
+		if (! loadImage(options.boundaryFile, image)) return false;
+		model.setBoundaryImage(image);
+	}
+
+	if (! options.heightFile.isEmpty())
+	{
+		if (core::HeightMap::isHeightMapFile(options.heightFile))
+		{
+			core::HeightMap heightMap;
+			if (! heightMap.open(options.heightFile))
+			{
+				qWarning() << "cannot load height map" << options.heightFile;
+				return false;
+			}
+			model.setHeightMap(heightMap);
+		}
+		else
+		{
+			if (! loadImage(options.heightFile, image)) return false;
+			model.setHeightMapImage(image);
+		}
+	}
+
+	if (! options.populationFile.isEmpty())
+	{
+		if (! loadImage(options.populationFile, image)) return false;
+		model.setPopulationMapImage(image);
+	}
+
+	if (! applyFieldSettings(model, options.weights, &Model::setWeight)) return false;
+	if (! applyFieldSettings(model, options.decays, &Model::setDecay)) return false;
+
+	if (! options.basisFile.isEmpty())
+	{
+		if (! loadBasisDefinitions(options.basisFile, defs)) return false;
+
+		foreach (core::BasisField * field, defs.fields)
+		{
+			model.addBasisField(field);
+		}
+		foreach (core::Point const & seed, defs.seeds)
+		{
+			model.addSeedMarker(seed);
+		}
+	}
+
+	return true;
+}
+
+
+//! Prints counters of the tracing work done.
+static
+void writeTracerStatistics(QTextStream & out, core::Tracer::Statistics const & statistics)
+{
+	typedef core::Tracer::Statistics Statistics;
+
+	out << qSetFieldWidth(24) << left << "tracer counter"
+		<< qSetFieldWidth(12) << right << "value"
+		<< qSetFieldWidth(0) << endl;
+
+	out << qSetFieldWidth(24) << left << "rk4 steps"         << qSetFieldWidth(12) << right << statistics.rk4Steps         << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "field evaluations" << qSetFieldWidth(12) << right << statistics.fieldEvaluations << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "traces"            << qSetFieldWidth(12) << right << statistics.traces           << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "sample-points"     << qSetFieldWidth(12) << right << statistics.samples          << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "samples per edge"  << qSetFieldWidth(12) << right << statistics.samplesPerEdge() << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "grid queries"      << qSetFieldWidth(12) << right << statistics.gridQueries      << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "grid candidates"   << qSetFieldWidth(12) << right << statistics.gridCandidates   << qSetFieldWidth(0) << endl;
+
+	for (int i = 0; i < Statistics::NumOutcomes; ++i)
+	{
+		out << qSetFieldWidth(24) << left << Statistics::outcomeName(Statistics::Outcome(i))
+			<< qSetFieldWidth(12) << right << statistics.outcomes[i]
+			<< qSetFieldWidth(0) << endl;
+	}
+
+	out << qSetFieldWidth(24) << left << "seeds consumed"    << qSetFieldWidth(12) << right << statistics.seedsConsumed    << qSetFieldWidth(0) << endl;
+	out << qSetFieldWidth(24) << left << "seeds productive"  << qSetFieldWidth(12) << right << statistics.seedsProductive  << qSetFieldWidth(0) << endl;
+}
+
+
+int main(int argc, char ** argv)
+{
+	// images are decoded and painted, but there is no display
+	QApplication app(argc, argv, false);
+
+	Options options;
+	if (! parseArguments(app.arguments(), options))
+	{
+		usage();
+		return 1;
+	}
+
+	if (! QDir().mkpath(options.outputDir))
+	{
+		qWarning() << "cannot create output directory" << options.outputDir;
+		return 1;
+	}
+	QDir outputDir(options.outputDir);
+
+	PhaseTimer timer;
+	BasisDefinitions defs;
+	int status = 0;
+
+	timer.start("load inputs");
+
+	Model model;
+
+	if (loadInputs(model, options, defs))
+	{
+		timer.start("trace major roads");
+		model.traceInit();
+		while (model.core::Region::traceField(model))
+			;
+
+		timer.start("simplify");
+		model.simplifyGraph();
+
+		timer.start("find districts");
+		model.findSubregions();
+
+		timer.start("trace local streets");
+		while (model.traceStep())
+			;
+
+		timer.start("find blocks");
+		model.findSubregions();
+
+		timer.start("write results");
+		if (! writeGeoJson(model, outputDir.filePath("city.geojson")))
+		{
+			status = 1;
+		}
+		if (! model.renderStreetMap().save(outputDir.filePath("streets.png")))
+		{
+			qWarning() << "cannot write street map";
+			status = 1;
+		}
+
+		timer.stop();
+	}
+	else
+	{
+		status = 1;
+	}
+
+	QTextStream out(stdout);
+	timer.report(out);
+
+	out << endl;
+	writeTracerStatistics(out, model.tracerStatistics());
+
+	if (! options.profileFile.isEmpty())
+	{
+		out << endl;
+		base::Profiler::instance()->writeSummary(out);
+
+		if (! base::Profiler::instance()->writeChromeTrace(options.profileFile))
+		{
+			qWarning() << "cannot write profile" << options.profileFile;
+			status = 1;
+		}
+	}
+
+	foreach (core::BasisField * field, defs.fields)
+	{
+		model.removeBasisField(field);
+	}
+	qDeleteAll(defs.fields);
+
+	return status;
+}
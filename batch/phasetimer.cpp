@@ -0,0 +1,129 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "phasetimer.h"
+
+#include <QFile>
+
+#ifdef Q_OS_UNIX
+#include <sys/resource.h>
+#endif
+
+
+PhaseTimer::PhaseTimer()
+	: m_perPhase(true)
+{
+}
+
+void PhaseTimer::start(QString const & name)
+{
+	stop();
+
+	m_perPhase = resetPeakRss() && m_perPhase;
+	m_current = name;
+	m_time.start();
+}
+
+void PhaseTimer::stop()
+{
+	if (m_current.isEmpty())
+	{
+		return;
+	}
+
+	Phase phase;
+	phase.name = m_current;
+	phase.elapsed = m_time.elapsed();
+	phase.peakRss = peakRss();
+	m_phases.append(phase);
+
+	m_current.clear();
+}
+
+void PhaseTimer::report(QTextStream & out) const
+{
+	int total = 0;
+
+	out << qSetFieldWidth(24) << left << "phase"
+		<< qSetFieldWidth(12) << right << "wall [ms]"
+		<< (m_perPhase ? "peak [MB]" : "max [MB]")
+		<< qSetFieldWidth(0) << endl;
+
+	foreach (Phase const & phase, m_phases)
+	{
+		out << qSetFieldWidth(24) << left << phase.name
+			<< qSetFieldWidth(12) << right << phase.elapsed;
+
+		if (phase.peakRss >= 0)
+			out << QString::number(phase.peakRss / 1024.0, 'f', 1);
+		else
+			out << "-";
+
+		out << qSetFieldWidth(0) << endl;
+
+		total += phase.elapsed;
+	}
+
+	out << qSetFieldWidth(24) << left << "total"
+		<< qSetFieldWidth(12) << right << total
+		<< qSetFieldWidth(0) << endl;
+}
+
+long PhaseTimer::peakRss()
+{
+	// the kernel's high-water mark follows resets, ru_maxrss does not
+	//
+	QFile status("/proc/self/status");
+	if (status.open(QIODevice::ReadOnly))
+	{
+		QList<QByteArray> lines = status.readAll().split('\n');
+		foreach (QByteArray const & line, lines)
+		{
+			if (line.startsWith("VmHWM:"))
+			{
+				return line.mid(6).trimmed().split(' ').first().toLong();
+			}
+		}
+	}
+
+#ifdef Q_OS_UNIX
+	struct rusage usage;
+	if (getrusage(RUSAGE_SELF, &usage) == 0)
+	{
+#ifdef Q_OS_MAC
+		return usage.ru_maxrss / 1024;
+#else
+		return usage.ru_maxrss;
+#endif
+	}
+#endif
+
+	return -1;
+}
+
+bool PhaseTimer::resetPeakRss()
+{
+	QFile clearRefs("/proc/self/clear_refs");
+	if (! clearRefs.open(QIODevice::WriteOnly))
+	{
+		return false;
+	}
+
+	return clearRefs.write("5") == 1;
+}
@@ -0,0 +1,83 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BATCH_PHASETIMER_H_
+#define BATCH_PHASETIMER_H_
+
+#include <QList>
+#include <QString>
+#include <QTime>
+#include <QTextStream>
+
+
+//! Measures wall time and peak memory use of the batch pipeline phases.
+/*!
+ * Phases are consecutive; starting a phase stops the previous one.
+ *
+ * Where the kernel allows it (Linux), the resident set high-water mark
+ * is reset at the start of each phase, so the reported peak belongs to
+ * that phase alone. Elsewhere it is the peak of the process so far.
+ */
+class PhaseTimer
+{
+public:
+	//! Constructs the object.
+	PhaseTimer();
+
+	//! Starts timing the named phase.
+	void start(QString const & name);
+
+	//! Stops timing the current phase.
+	void stop();
+
+	//! Writes a table of finished phases to the specified stream.
+	void report(QTextStream & out) const;
+
+	//! Returns the peak resident set size in kilobytes, or -1 if unknown.
+	static long peakRss();
+
+	//! Resets the peak resident set size.
+	/*!
+	 * \return whether the reset is supported
+	 */
+	static bool resetPeakRss();
+
+private:
+	//! Record of a finished phase.
+	struct Phase
+	{
+		//! Phase name.
+		QString name;
+		//! Wall time in milliseconds.
+		int elapsed;
+		//! Peak resident set size in kilobytes.
+		long peakRss;
+	};
+
+	//! Finished phases.
+	QList<Phase> m_phases;
+	//! Name of the current phase, empty if none.
+	QString m_current;
+	//! Wall clock of the current phase.
+	QTime m_time;
+	//! Whether peak RSS values are per phase.
+	bool m_perPhase;
+};
+
+
+#endif // ifndef BATCH_PHASETIMER_H_
@@ -0,0 +1,104 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.h"
+
+
+Report::Report(QTextStream & out, QString const & filter, double minSeconds)
+	: m_out(out)
+	, m_filter(filter)
+	, m_minSeconds(minSeconds)
+{
+}
+
+bool Report::enabled(QString const & name) const
+{
+	return m_filter.isEmpty() || name.contains(m_filter);
+}
+
+void Report::write(QString const & name, int param, QString const & unit, int iterations, double seconds, double work)
+{
+	double rate = (seconds > 0) ? work / seconds : 0;
+
+	m_out << "{\"name\":\"" << name << "\""
+		<< ",\"param\":" << param
+		<< ",\"iterations\":" << iterations
+		<< ",\"seconds\":" << QString::number(seconds, 'g', 6)
+		<< ",\"work\":" << QString::number(work, 'g', 10)
+		<< ",\"unit\":\"" << unit << "\""
+		<< ",\"rate\":" << QString::number(rate, 'g', 6)
+		<< "}" << endl;
+}
+
+
+Measurement::Measurement(Report & report, QString const & name, int param, QString const & unit)
+	: m_report(report)
+	, m_name(name)
+	, m_param(param)
+	, m_unit(unit)
+	, m_iterations(0)
+	, m_nsecs(0)
+	, m_work(0)
+	, m_running(false)
+{
+}
+
+Measurement::~Measurement()
+{
+	pause();
+	m_report.write(m_name, m_param, m_unit, m_iterations, m_nsecs * 1e-9, m_work);
+}
+
+bool Measurement::next()
+{
+	if (m_iterations == 0)
+	{
+		// the first iteration starts the clock
+		resume();
+	}
+	else
+	{
+		qint64 nsecs = m_nsecs + (m_running ? m_timer.nsecsElapsed() : 0);
+		if (nsecs >= m_report.minSeconds() * 1e9)
+		{
+			return false;
+		}
+	}
+
+	++m_iterations;
+	return true;
+}
+
+void Measurement::pause()
+{
+	if (m_running)
+	{
+		m_nsecs += m_timer.nsecsElapsed();
+		m_running = false;
+	}
+}
+
+void Measurement::resume()
+{
+	if (! m_running)
+	{
+		m_timer.start();
+		m_running = true;
+	}
+}
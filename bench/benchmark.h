@@ -0,0 +1,123 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BENCH_BENCHMARK_H_
+#define BENCH_BENCHMARK_H_
+
+#include <QElapsedTimer>
+#include <QString>
+#include <QTextStream>
+
+
+//! Destination of benchmark results.
+/*!
+ * Each result is written as one line of JSON, so results of different
+ * commits can be collected and compared by scripts.
+ */
+class Report
+{
+public:
+	//! Constructs the object.
+	/*!
+	 * \param out stream results are written to
+	 * \param filter only benchmarks whose name contains this string are run
+	 * \param minSeconds minimum measured time of each benchmark
+	 */
+	Report(QTextStream & out, QString const & filter, double minSeconds);
+
+	//! Tests whether the named benchmark should be run.
+	bool enabled(QString const & name) const;
+
+	//! Returns the minimum measured time of each benchmark, in seconds.
+	double minSeconds() const { return m_minSeconds; }
+
+	//! Writes one result.
+	/*!
+	 * \param name benchmark name
+	 * \param param size parameter of the benchmark
+	 * \param unit unit of the work done, e.g. "eval"
+	 * \param iterations number of times the benchmark body was run
+	 * \param seconds measured time
+	 * \param work amount of work done in all iterations
+	 */
+	void write(QString const & name, int param, QString const & unit, int iterations, double seconds, double work);
+
+private:
+	QTextStream & m_out;
+	QString m_filter;
+	double m_minSeconds;
+};
+
+
+//! A single timed benchmark.
+/*!
+ * The body is repeated while next() returns true:
+ *
+ * \code
+ * Measurement m(report, "basisSum/eval", n, "eval");
+ * while (m.next())
+ * {
+ *     ...
+ *     m.addWork(count);
+ * }
+ * \endcode
+ *
+ * The result is written to the report when the object is destroyed.
+ * Setup that must not be measured is bracketed by pause() and resume().
+ */
+class Measurement
+{
+public:
+	//! Constructs the object, see Report::write() for parameters.
+	Measurement(Report & report, QString const & name, int param, QString const & unit);
+
+	//! Writes the result.
+	~Measurement();
+
+	//! Starts the next iteration, returns false when enough time was measured.
+	bool next();
+
+	//! Adds to the amount of work done.
+	void addWork(double work) { m_work += work; }
+
+	//! Stops the clock.
+	void pause();
+
+	//! Restarts the clock.
+	void resume();
+
+private:
+	Report & m_report;
+	QString m_name;
+	int m_param;
+	QString m_unit;
+
+	//! Number of started iterations.
+	int m_iterations;
+	//! Measured time in nanoseconds, not counting the running interval.
+	qint64 m_nsecs;
+	//! Amount of work done.
+	double m_work;
+	//! Clock of the running interval.
+	QElapsedTimer m_timer;
+	//! Whether the clock is running.
+	bool m_running;
+};
+
+
+#endif // ifndef BENCH_BENCHMARK_H_
@@ -0,0 +1,303 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "benchmark.h"
+#include "scene.h"
+#include "app/model.h"
+#include "core/field.h"
+#include "core/border.h"
+#include "core/tracer.h"
+#include "math/graph.h"
+#include "math/vector2f.h"
+#include "math/funcs.h"
+
+#include <QtGui/QApplication>
+#include <QStringList>
+#include <QTextStream>
+
+#include <stdio.h>
+
+
+//! Number of basis fields in scenes that are not about basis fields.
+static int const sceneBasisFields = 16;
+//! Boundary complexity of scenes that are not about boundaries.
+static int const sceneComplexity = 8;
+
+//! Receives results that are computed only to be timed.
+/*!
+ * Being volatile, stores to it cannot be optimized away, and neither can the
+ * computations they depend on.
+ */
+static volatile float resultSink = 0;
+
+
+//! Model with synthetic inputs.
+struct Scene
+{
+	Model model;
+	QList<core::BasisField *> fields;
+
+	Scene(int complexity, quint32 seed)
+	{
+		model.setBoundaryImage(makeBoundaryImage(1024, complexity, seed));
+
+		fields = makeBasisFields(sceneBasisFields, seed);
+		foreach (core::BasisField * field, fields)
+		{
+			model.addBasisField(field);
+		}
+	}
+
+	~Scene()
+	{
+		foreach (core::BasisField * field, fields)
+		{
+			model.removeBasisField(field);
+		}
+		qDeleteAll(fields);
+	}
+};
+
+
+static
+void benchBasisSum(Report & report, int n, quint32 seed)
+{
+	QList<core::BasisField *> fields = makeBasisFields(n, seed);
+	QVector<math::Vector2f> points = makePoints(4096, seed);
+
+	core::BasisSumField sum(DEFAULT_DECAY_USEREDIT);
+	foreach (core::BasisField * field, fields)
+	{
+		sum += field;
+	}
+
+	float checksum = 0;
+	{
+		Measurement m(report, "basisSum/eval", n, "eval");
+		while (m.next())
+		{
+			foreach (math::Vector2f const & p, points)
+			{
+				checksum += sum(p).value();
+			}
+			m.addWork(points.size());
+		}
+	}
+
+	foreach (core::BasisField * field, fields)
+	{
+		sum -= field;
+	}
+	qDeleteAll(fields);
+
+	resultSink = checksum;
+}
+
+static
+void benchLoadValues(Report & report, int n, quint32 seed)
+{
+	QList<core::BasisField *> fields = makeBasisFields(n, seed);
+
+	core::BasisSumField sum(DEFAULT_DECAY_USEREDIT);
+	foreach (core::BasisField * field, fields)
+	{
+		sum += field;
+	}
+
+	int const dim = 256;
+	core::DiscreteField discrete(dim);
+	{
+		Measurement m(report, "discreteField/loadValues", n, "sample");
+		while (m.next())
+		{
+			discrete.loadValues(sum);
+			m.addWork((dim+1) * (dim+1));
+		}
+	}
+
+	foreach (core::BasisField * field, fields)
+	{
+		sum -= field;
+	}
+	qDeleteAll(fields);
+}
+
+static
+void benchIntegration(Report & report, quint32 seed)
+{
+	Scene scene(sceneComplexity, seed);
+
+	QVector<math::Vector2f> points = makePoints(1024, seed);
+	QVector<math::Vector2f> directions = makePoints(1024, seed + 1);
+
+	Measurement m(report, "tracer/rk4", sceneBasisFields, "step");
+	while (m.next())
+	{
+		for (int i = 0; i < points.size(); ++i)
+		{
+			math::Vector2f p = points[i];
+			math::Vector2f d = directions[i] - math::Vector2f(0.5f, 0.5f);
+
+			int steps = 0;
+			core::Tracer::integrate(scene.model, i % 2 == 0, p, d, 0.01f, &steps);
+			m.addWork(steps);
+		}
+	}
+}
+
+static
+void benchTraceComplete(Report & report, int complexity, quint32 seed)
+{
+	Measurement m(report, "model/traceComplete", complexity, "edge");
+	while (m.next())
+	{
+		m.pause();
+		Scene * scene = new Scene(complexity, seed);
+		m.resume();
+
+		scene->model.traceComplete();
+
+		m.pause();
+		m.addWork(scene->model.tracer().edgesCount());
+		delete scene;
+		m.resume();
+	}
+}
+
+static
+void benchFindRegions(Report & report, int complexity, quint32 seed)
+{
+	int const size = 1024;
+	QImage image = makeBoundaryImage(size, complexity, seed);
+
+	Measurement m(report, "border/findRegions", complexity, "pixel");
+	while (m.next())
+	{
+		core::border::Regions regions;
+		core::border::findRegions(regions, image);
+		m.addWork(size * size);
+	}
+}
+
+static
+void benchCycleBasis(Report & report, int side, quint32 seed)
+{
+	math::Graph graph = makeGridGraph(side, seed);
+
+	Measurement m(report, "graph/minimumCycleBasis", graph.numVertices(), "cycle");
+	while (m.next())
+	{
+		m.addWork(graph.minimumCycleBasis().size());
+	}
+}
+
+static
+void benchRenderStreetMap(Report & report, quint32 seed)
+{
+	Scene scene(sceneComplexity, seed);
+	scene.model.traceComplete();
+
+	Measurement m(report, "model/renderStreetMap", scene.model.tracer().edgesCount(), "image");
+	while (m.next())
+	{
+		scene.model.renderStreetMap();
+		m.addWork(1);
+	}
+}
+
+
+//! Prints command line usage.
+static
+void usage()
+{
+	QTextStream err(stderr);
+
+	err << "usage: newtown-bench [options]" << endl
+		<< endl
+		<< "  --filter TEXT     run only benchmarks whose name contains TEXT" << endl
+		<< "  --min-time SECS   minimum measured time of each benchmark (default 1)" << endl
+		<< "  --seed N          seed of the synthetic scenes (default 1)" << endl
+		<< endl
+		<< "Results are printed one JSON object per line." << endl;
+}
+
+
+int main(int argc, char ** argv)
+{
+	// scenes are painted into images, but there is no display
+	QApplication app(argc, argv, false);
+
+	QString filter;
+	double minSeconds = 1.0;
+	quint32 seed = 1;
+
+	QStringList args = app.arguments();
+	args.removeFirst();
+
+	while (! args.empty())
+	{
+		QString arg = args.takeFirst();
+		bool ok = !args.empty();
+
+		if (ok && arg == "--filter")        filter = args.takeFirst();
+		else if (ok && arg == "--min-time") minSeconds = args.takeFirst().toDouble(&ok);
+		else if (ok && arg == "--seed")     seed = args.takeFirst().toUInt(&ok);
+		else                                ok = false;
+
+		if (!ok)
+		{
+			usage();
+			return 1;
+		}
+	}
+
+	QTextStream out(stdout);
+	Report report(out, filter, minSeconds);
+
+	if (report.enabled("basisSum/eval"))
+	{
+		for (int n = 4; n <= 64; n *= 4) benchBasisSum(report, n, seed);
+	}
+	if (report.enabled("discreteField/loadValues"))
+	{
+		for (int n = 4; n <= 64; n *= 4) benchLoadValues(report, n, seed);
+	}
+	if (report.enabled("tracer/rk4"))
+	{
+		benchIntegration(report, seed);
+	}
+	if (report.enabled("model/traceComplete"))
+	{
+		for (int c = 2; c <= 32; c *= 4) benchTraceComplete(report, c, seed);
+	}
+	if (report.enabled("border/findRegions"))
+	{
+		for (int c = 2; c <= 128; c *= 4) benchFindRegions(report, c, seed);
+	}
+	if (report.enabled("graph/minimumCycleBasis"))
+	{
+		for (int side = 4; side <= 16; side += 4) benchCycleBasis(report, side, seed);
+	}
+	if (report.enabled("model/renderStreetMap"))
+	{
+		benchRenderStreetMap(report, seed);
+	}
+
+	return 0;
+}
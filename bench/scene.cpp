@@ -0,0 +1,170 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "scene.h"
+#include "core/field.h"
+
+#include <math.h>
+
+#include <QColor>
+#include <QPainter>
+#include <QPolygonF>
+
+
+using math::Vector2f;
+
+
+Random::Random(quint32 seed)
+	: m_state(seed ? seed : 0x9e3779b9u)
+{
+}
+
+quint32 Random::next()
+{
+	// xorshift32
+	m_state ^= m_state << 13;
+	m_state ^= m_state >> 17;
+	m_state ^= m_state << 5;
+	return m_state;
+}
+
+float Random::uniform()
+{
+	return (next() >> 8) * (1.0f / 16777216.0f);
+}
+
+
+QVector<Vector2f> makePoints(int n, quint32 seed)
+{
+	Random random(seed);
+	QVector<Vector2f> points(n);
+
+	for (int i = 0; i < n; ++i)
+	{
+		points[i] = Vector2f(random.uniform(), random.uniform());
+	}
+
+	return points;
+}
+
+QList<core::BasisField *> makeBasisFields(int n, quint32 seed)
+{
+	Random random(seed);
+	QList<core::BasisField *> fields;
+
+	for (int i = 0; i < n; ++i)
+	{
+		Vector2f p0(random.uniform(0.05f, 0.95f), random.uniform(0.05f, 0.95f));
+		float scale = random.uniform(0.5f, 2.0f);
+
+		if (i % 4 == 3)
+		{
+			int type = 1 + random.next() % (core::BasisField::NumSingularityTypes - 1);
+			fields.append(new core::BasisField(p0, scale, (core::BasisField::SingularityType)type));
+		}
+		else
+		{
+			float angle = random.uniform(0.0f, (float)M_PI);
+			fields.append(new core::BasisField(p0, scale, Vector2f(cosf(angle), sinf(angle))));
+		}
+	}
+
+	return fields;
+}
+
+QImage makeBoundaryImage(int size, int complexity, quint32 seed)
+{
+	Random random(seed);
+
+	QImage image(size, size, QImage::Format_RGB32);
+	image.fill(QColor(Qt::white).rgb());
+
+	QColor water = QColor::fromHsv(220, 200, 220);
+
+	QPainter painter(&image);
+	painter.setRenderHint(QPainter::Antialiasing, false);
+
+	for (int i = 0; i < complexity; ++i)
+	{
+		if (i % 3 == 2)
+		{
+			// river
+			//
+			QPolygonF river;
+			float x = random.uniform(0, size), y = random.uniform(0, size);
+			float angle = random.uniform(0.0f, 2.0f * (float)M_PI);
+
+			for (int k = 0; k < 16; ++k)
+			{
+				river << QPointF(x, y);
+				angle += random.uniform(-0.5f, 0.5f);
+				x += cosf(angle) * size / 32;
+				y += sinf(angle) * size / 32;
+			}
+
+			QPen pen(water);
+			pen.setWidthF(random.uniform(0.005f, 0.02f) * size);
+			painter.setPen(pen);
+			painter.setBrush(Qt::NoBrush);
+			painter.drawPolyline(river);
+		}
+		else
+		{
+			// lake
+			//
+			QPolygonF lake;
+			float cx = random.uniform(0, size), cy = random.uniform(0, size);
+			float radius = random.uniform(0.02f, 0.08f) * size;
+
+			for (int k = 0; k < 32; ++k)
+			{
+				float angle = 2.0f * (float)M_PI * k / 32;
+				float r = radius * random.uniform(0.7f, 1.3f);
+				lake << QPointF(cx + r*cosf(angle), cy + r*sinf(angle));
+			}
+
+			painter.setPen(Qt::NoPen);
+			painter.setBrush(QBrush(water));
+			painter.drawPolygon(lake);
+		}
+	}
+
+	return image;
+}
+
+math::Graph makeGridGraph(int side, quint32 seed)
+{
+	Random random(seed);
+	math::Graph graph(side * side);
+
+	for (int y = 0; y < side; ++y)
+	{
+		for (int x = 0; x < side; ++x)
+		{
+			math::Graph::Vertex v = 1 + y*side + x;
+
+			// about one edge in ten is missing
+			//
+			if (x+1 < side && random.next() % 10 != 0) graph.connect(v, v+1);
+			if (y+1 < side && random.next() % 10 != 0) graph.connect(v, v+side);
+		}
+	}
+
+	return graph;
+}
@@ -0,0 +1,76 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef BENCH_SCENE_H_
+#define BENCH_SCENE_H_
+
+#include "core/field.hh"
+#include "math/graph.h"
+#include "math/vector2f.h"
+
+#include <QImage>
+#include <QList>
+#include <QVector>
+
+
+//! Deterministic random number generator.
+/*!
+ * Synthetic scenes must be identical on every platform and Qt version,
+ * so qrand() is not used.
+ */
+class Random
+{
+public:
+	//! Constructs the generator with the specified seed.
+	explicit Random(quint32 seed);
+
+	//! Returns the next 32-bit value.
+	quint32 next();
+
+	//! Returns a value uniformly distributed in [0,1).
+	float uniform();
+
+	//! Returns a value uniformly distributed in [a,b).
+	float uniform(float a, float b) { return a + (b - a) * uniform(); }
+
+private:
+	quint32 m_state;
+};
+
+
+//! Returns points uniformly distributed over the field domain.
+QVector<math::Vector2f> makePoints(int n, quint32 seed);
+
+//! Returns basis fields, a mix of regular elements and singularities.
+/*!
+ * The caller takes ownership of the returned objects.
+ */
+QList<core::BasisField *> makeBasisFields(int n, quint32 seed);
+
+//! Returns a boundary map with the specified number of water bodies.
+/*!
+ * Water bodies are irregular polygons and thick river polylines, all
+ * painted with the same hue, so overlapping shapes merge into one region.
+ */
+QImage makeBoundaryImage(int size, int complexity, quint32 seed);
+
+//! Returns a grid graph with side*side vertices and some edges removed.
+math::Graph makeGridGraph(int side, quint32 seed);
+
+
+#endif // ifndef BENCH_SCENE_H_
@@ -0,0 +1,15 @@
+
+# settings shared by all Newtown sub-projects
+
+INCLUDEPATH = $$PWD
+
+# profiler spans are compiled in with "qmake CONFIG+=profiler"
+profiler: DEFINES += ENABLE_PROFILER
+
+OBJECTS_DIR = ./build/$$TARGET
+MOC_DIR = ./build/$$TARGET
+RCC_DIR = ./build/$$TARGET
+UI_DIR = ./build/$$TARGET
+
+CORE_LIB_DIR = $$OUT_PWD/build
+CORE_LIB_NAME = newtown-core
@@ -34,6 +34,12 @@ Block::Block(QVector<Point> const & base, QVector<Point> const & border, QObject
 {
 }
 
+void Block::setBorder(QVector<Point> const & base, QVector<Point> const & border)
+{
+	m_polygon = math::Polygon(border);
+	m_parcel = math::Polygon(base);
+}
+
 math::Polygon Block::polygon() const
 {
 	return m_polygon;
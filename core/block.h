@@ -49,6 +49,13 @@ public:
 	 */
 	Block(QVector<Point> const & base, QVector<Point> const & border, QObject * parent = NULL);
 
+	//! Replaces the block's polygons after its border has changed.
+	/*!
+	 * \param base the base polygon on which the block is located
+	 * \param border polygon enclosing the area of the block
+	 */
+	void setBorder(QVector<Point> const & base, QVector<Point> const & border);
+
 	//! Returns the polygon that limits the block area.
 	math::Polygon polygon() const;
 
@@ -18,34 +18,26 @@
  */
 
 #include "core/border.h"
+#include "core/parameters.h"
 
 #include <QImage>
 #include <QColor>
 #include <QtCore>
+#include <QtConcurrentMap>
 
 using namespace core::border;
 
 
-//! Returns the label of the specified pixel.
+//! Returns the label of the specified pixel value.
 /*!
  * Currently the pixel's hue value is used as label value.
  *
- * \param image image containing the pixel
- * \param p position of the pixel inside the image
+ * \param rgb pixel value
  */
 inline
-Label getLabel(QImage const & image, QPoint const & p)
+Label getLabel(QRgb rgb)
 {
-	static Label background = -1;
-	
-	if (image.rect().contains(p))
-	{
-		return QColor::fromRgba(image.pixel(p)).hue();
-	}
-	else
-	{
-		return background;
-	}
+	return QColor::fromRgba(rgb).hue();
 }
 
 //! Tests whether the supplied label is the special value for background pixels.
@@ -59,217 +51,353 @@ bool isBackground(Label l)
 	return l < 0;
 }
 
-//! Returns a list of neighborhood pixels.
+//! Horizontal offsets of the eight neighbours, clockwise starting from the east.
+static int const neighbourDx[8] = { 1, 1, 0,-1,-1,-1, 0, 1 };
+//! Vertical offsets of the eight neighbours, clockwise starting from the east.
+static int const neighbourDy[8] = { 0, 1, 1, 1, 0,-1,-1,-1 };
+
+//! State of a pixel during contour tracing.
+enum PixelState
+{
+	InteriorPixel = 0,
+	BorderPixel,
+	VisitedPixel
+};
+
+//! Follows a chain of border pixels with the same label.
 /*!
- * \param image image containing the specified pixel
- * \param p position of the pixel inside the image
- * \param label label of the specified pixel
- * \return list of neighboring pixels
+ * At each step the Moore neighbourhood of the current pixel is searched
+ * clockwise, starting next to the direction of the previous step, so the
+ * chain hugs the region contour.
+ *
+ * \param labels pixel labels
+ * \param state pixel states, visited pixels are marked
+ * \param x column of the starting pixel
+ * \param y row of the starting pixel
+ * \param dir direction of the first step
+ * \param[out] chain where the pixels are appended, starting pixel excluded
  */
-inline
-QVector<QPoint> getNeighbours(QImage const & image, QPoint  const & p, Label label)
+static
+void followChain(LabelImage const & labels, QVector<char> & state, int x, int y, int dir, BoundarySegment & chain)
 {
-	QVector<QPoint> n;
+	int const w = labels.width;
+	Label const label = labels.label(x,y);
 
-	for (int x = -1; x < 2; ++x)
+	for (;;)
 	{
-		for (int y = -1; y < 2; ++y)
-		{
-			if (x == 0 && y == 0) continue;
+		bool moved = false;
 
-			QPoint q = p + QPoint(x,y);
+		for (int i = 0; i < 8; ++i)
+		{
+			int k = (dir + 6 + i) % 8;
+			int nx = x + neighbourDx[k];
+			int ny = y + neighbourDy[k];
+			int ni = ny*w + nx;
 
-			if (label == getLabel(image, q))
+			if (labels.labels[ni] == label && state[ni] == BorderPixel)
 			{
-				n.append(q);
+				state[ni] = VisitedPixel;
+				chain.append(QPoint(nx,ny));
+
+				x = nx;
+				y = ny;
+				dir = k;
+				moved = true;
+				break;
 			}
 		}
+
+		if (!moved) break;
 	}
-	
-	return n;
 }
 
-//! Tests whether two pixels are neighbors.
+//! Traces the segment of border pixels through the specified starting pixel.
 /*!
- * \param p1 position of the first pixel within the image
- * \param p2 position of the second pixel within the image
- * \retval true pixels are neighbors
- * \retval false pixels are not neighbors
+ * The contour is followed both ways from the starting pixel, which must be
+ * an unvisited border pixel.
+ *
+ * \param labels pixel labels
+ * \param state pixel states, visited pixels are marked
+ * \param x column of the starting pixel
+ * \param y row of the starting pixel
  */
-inline
-bool neighbours(QPoint const & p1, QPoint const & p2)
+static
+BoundarySegment traceSegment(LabelImage const & labels, QVector<char> & state, int x, int y)
 {
-	QPoint d = p1 - p2;
+	state[y*labels.width + x] = VisitedPixel;
 
-	return (qAbs(d.x()) <= 1 && qAbs(d.y()) <= 1);
+	BoundarySegment forward, backward;
+	followChain(labels, state, x, y, 0, forward);
+	followChain(labels, state, x, y, 4, backward);
+
+	BoundarySegment segment;
+	for (int i = backward.size()-1; i >= 0; --i)
+	{
+		segment.append(backward[i]);
+	}
+	segment.append(QPoint(x,y));
+	segment += forward;
+
+	return segment;
 }
 
-//! Tests whether the specified pixel is a border pixel.
+//! Marks the border pixels in the specified rows.
 /*!
- * \param p position of the pixel within the image
- * \param neigbours list of neighborhood pixels
+ * \param labels pixel labels
+ * \param state pixel states, border pixels are marked
+ * \param y0 first row
+ * \param y1 one past the last row
+ * \param[out] starts if not NULL, indices of found border pixels are appended here, by label
  */
-inline
-bool isBorderPixel(QPoint const & /*p*/, QVector<QPoint> const & neighbours)
+static
+void markBorder(LabelImage const & labels, QVector<char> & state, int y0, int y1, QMap< Label, QVector<int> > * starts)
 {
-	return neighbours.size() < 8;
+	int const w = labels.width;
+
+	for (int y = y0; y < y1; ++y)
+	{
+		for (int x = 1; x < w-1; ++x)
+		{
+			Label label = labels.label(x,y);
+			if (isBackground(label)) continue;
+
+			for (int k = 0; k < 8; ++k)
+			{
+				if (labels.label(x + neighbourDx[k], y + neighbourDy[k]) != label)
+				{
+					state[y*w + x] = BorderPixel;
+					if (starts) (*starts)[label].append(y*w + x);
+					break;
+				}
+			}
+		}
+	}
 }
 
-//! Tests whether the specified pixel is an edge pixel.
-/*!
- * \param p position of the pixel within the image
- * \param image image containing the pixel
- */
-inline
-bool isEdgePixel(QPoint const & p, QImage const & image)
+//! Returns the number of tasks for an image with the specified number of rows.
+static
+int numBands(int rows)
 {
-	return p.x() == 0 || p.x() == image.width()-1 || p.y() == 0 || p.y() == image.height()-1;
+	return qMax(1, qMin(rows, QThread::idealThreadCount() * 4));
 }
 
-//! Reverses pixel withing the boundary segment.
-void reverse(BoundarySegment & b)
+//! Labels a band of image rows.
+struct LabelBandTask
 {
-	if (b.isEmpty()) return;
-	
-	BoundarySegment::iterator fwd, bck;
-	for (fwd = b.begin(), bck = b.end()-1; fwd < bck; fwd++, bck--)
-	{
-		qSwap(*fwd, *bck);
-	}
-}
+	//! Input image, in ARGB32 format.
+	QImage const * image;
+	//! Output labels.
+	LabelImage * labels;
+	//! First row.
+	int y0;
+	//! One past the last row.
+	int y1;
 
-//! Tries to connect individual segments of the region boundary.
-/*!
- * If two segments share end-point pixels they will be replaced by a single segment.
- */
-void connectBoundarySegments(Boundary & boundary)
+	//! Runs the task.
+	void run();
+};
+
+void LabelBandTask::run()
 {
-	// make sure segments go from left to right
-	//
-	for (Boundary::iterator i = boundary.begin(); i != boundary.end(); ++i)
-	{
-		BoundarySegment & b = *i;
+	int const w = labels->width;
 
-		if (b.first().x() > b.last().x())
-		{
-			reverse(b);
-		}
-	}
+	// label images use a handful of colours, so the last one is remembered
+	//
+	QRgb lastRgb = 0;
+	Label lastLabel = getLabel(lastRgb);
 
-	for (Boundary::iterator i = boundary.begin(); i != boundary.end(); ++i)
+	for (int y = y0; y < y1; ++y)
 	{
-		BoundarySegment & b1 = *i;
-		if (b1.isEmpty()) continue;
+		QRgb const * line = reinterpret_cast<QRgb const *>(image->constScanLine(y));
+		Label * out = labels->labels.data() + y*w;
 
-		for (Boundary::iterator j = i+1; j != boundary.end(); ++j)
+		for (int x = 0; x < w; ++x)
 		{
-			BoundarySegment & b2 = *j;
-			if (b2.isEmpty()) continue;
-			
-			if (neighbours(b1.last(), b2.first()))
-			{
-				b1 += b2;
-				b2.clear();
-			}
-			else if (neighbours(b1.first(), b2.last()))
-			{
-				b2 += b1;
-				b1.clear();
-				break;
-			}
-			else if (neighbours(b1.first(), b2.first()))
-			{
-				reverse(b1);
-				Q_ASSERT(neighbours(b1.last(), b2.first()));
-				b1 += b2;
-				b2.clear();
-			}
-			else if (neighbours(b1.last(), b2.last()))
+			if (line[x] != lastRgb)
 			{
-				reverse(b2);
-				Q_ASSERT(neighbours(b1.last(), b2.first()));
-				b1 += b2;
-				b2.clear();
-			}
-			else if (neighbours(b1.first(), b2.first()) && neighbours(b1.last(), b2.last()))
-			{
-				reverse(b2);
-				b1 += b2;
-				b2.clear();
+				lastRgb = line[x];
+				lastLabel = getLabel(lastRgb);
 			}
+
+			out[x] = lastLabel;
 		}
 	}
+}
+
+//! Marks border pixels in a band of rows.
+struct BorderBandTask
+{
+	//! Pixel labels.
+	LabelImage const * labels;
+	//! Pixel states, shared by all bands.
+	QVector<char> * state;
+	//! First row.
+	int y0;
+	//! One past the last row.
+	int y1;
+	//! Indices of border pixels in the band, by label, in scan order.
+	QMap< Label, QVector<int> > starts;
+
+	//! Runs the task.
+	void run() { markBorder(*labels, *state, y0, y1, &starts); }
+};
 
-	for (Boundary::iterator i = boundary.begin(); i != boundary.end(); )
+//! Chains the border pixels of one label.
+/*!
+ * Chains only step onto pixels with their own label, so tasks of different
+ * labels never touch the same pixel state.
+ */
+struct ChainLabelTask
+{
+	//! Pixel labels.
+	LabelImage const * labels;
+	//! Pixel states, shared by all labels.
+	QVector<char> * state;
+	//! The label.
+	Label label;
+	//! Indices of border pixels with the label, in scan order.
+	QVector<int> starts;
+	//! Found boundary.
+	Boundary boundary;
+
+	//! Runs the task.
+	void run();
+};
+
+void ChainLabelTask::run()
+{
+	int const w = labels->width;
+
+	foreach (int i, starts)
 	{
-		BoundarySegment & b = *i;
+		if ((*state)[i] != BorderPixel) continue;
 
-		if (b.isEmpty())
-		{
-			i = boundary.erase(i);
-		}
-		else
-		{
-			++i;
-		}
+		boundary.append(traceSegment(*labels, *state, i % w, i / w));
 	}
 }
 
-//! Tries to connect individual segments of all boundaries.
-void connectBoundarySegments(Regions & regions)
+void core::border::labelImage(LabelImage & labels, QImage const & image)
 {
-	for (Regions::iterator it = regions.begin(); it != regions.end(); ++it)
+	int const w = image.width();
+	int const h = image.height();
+
+	labels.width = w;
+	labels.height = h;
+	labels.labels.resize(w*h);
+
+	QImage argb = image.convertToFormat(QImage::Format_ARGB32);
+
+	int const n = numBands(h);
+
+	QVector<LabelBandTask> tasks(n);
+	for (int t = 0; t < n; ++t)
 	{
-		Boundary & boundary = *it;
-		
-		connectBoundarySegments(boundary);
+		tasks[t].image = &argb;
+		tasks[t].labels = &labels;
+		tasks[t].y0 = (h * t) / n;
+		tasks[t].y1 = (h * (t+1)) / n;
 	}
+
+	QtConcurrent::blockingMap(tasks, &LabelBandTask::run);
 }
 
 void core::border::findRegions(Regions & regions, QImage const & image)
 {
-	for (int y = 0; y < image.height(); ++y)
+	LabelImage labels;
+	labelImage(labels, image);
+
+	findRegions(regions, labels);
+}
+
+void core::border::findRegions(Regions & regions, LabelImage const & labels)
+{
+	if (core::Parameters::instance()->get("border/parallel", true).toBool())
 	{
-		for (int x = 0; x < image.width(); ++x)
+		findRegionsParallel(regions, labels);
+		return;
+	}
+
+	int const w = labels.width;
+	int const h = labels.height;
+
+	// mark border pixels
+	//
+	QVector<char> state(w*h, InteriorPixel);
+
+	markBorder(labels, state, 1, h-1, NULL);
+
+	// chain them into segments
+	//
+	for (int y = 1; y < h-1; ++y)
+	{
+		for (int x = 1; x < w-1; ++x)
 		{
-			QPoint p(x,y);
-			
-			Label label = getLabel(image, p);
-			if (isBackground(label)) continue;
-			if (isEdgePixel(p, image)) continue;
+			if (state[y*w + x] != BorderPixel) continue;
 
-			QVector<QPoint> neighbours = getNeighbours(image, p, label);
-			if (isBorderPixel(p, neighbours))
-			{
-				Boundary & boundary = regions[label];
-				
-				bool appended = false;
-				foreach (QPoint const & n, neighbours)
-				{
-					for (Boundary::iterator it = boundary.begin(); it != boundary.end(); ++it)
-					{
-						BoundarySegment & segment = *it;
-						if (n == segment.last())
-						{
-							segment.append(p);
-							appended = true;
-							break;
-						}
-					}
-				}
-				
-				if (!appended)
-				{
-					// create new boundary segment
-					
-					BoundarySegment segment;
-					segment.append(p);
+			regions[labels.label(x,y)].append(traceSegment(labels, state, x, y));
+		}
+	}
+}
 
-					boundary.append(segment);
-				}
-			}
+void core::border::findRegionsParallel(Regions & regions, LabelImage const & labels)
+{
+	int const w = labels.width;
+	int const h = labels.height;
+
+	if (h < 3) return;
+
+	QVector<char> state(w*h, InteriorPixel);
+
+	// mark border pixels, by row bands
+	//
+	int const n = numBands(h-2);
+
+	QVector<BorderBandTask> bands(n);
+	for (int t = 0; t < n; ++t)
+	{
+		bands[t].labels = &labels;
+		bands[t].state = &state;
+		bands[t].y0 = 1 + ((h-2) * t) / n;
+		bands[t].y1 = 1 + ((h-2) * (t+1)) / n;
+	}
+
+	QtConcurrent::blockingMap(bands, &BorderBandTask::run);
+
+	// stitch the bands, in band order, so each label gets its border pixels in scan order
+	//
+	QMap< Label, QVector<int> > starts;
+
+	foreach (BorderBandTask const & band, bands)
+	{
+		QMap< Label, QVector<int> >::const_iterator it;
+		for (it = band.starts.begin(); it != band.starts.end(); ++it)
+		{
+			starts[it.key()] += it.value();
 		}
+	}
+
+	bands.clear();
 
-		connectBoundarySegments(regions);
+	// chain them into segments, by labels
+	//
+	QVector<ChainLabelTask> chains;
+	chains.reserve(starts.size());
+
+	QMap< Label, QVector<int> >::const_iterator it;
+	for (it = starts.begin(); it != starts.end(); ++it)
+	{
+		ChainLabelTask task;
+		task.labels = &labels;
+		task.state = &state;
+		task.label = it.key();
+		task.starts = it.value();
+		chains.append(task);
+	}
+
+	QtConcurrent::blockingMap(chains, &ChainLabelTask::run);
+
+	foreach (ChainLabelTask const & chain, chains)
+	{
+		regions[chain.label] += chain.boundary;
 	}
 }
@@ -21,6 +21,7 @@
 
 #include <QList>
 #include <QMap>
+#include <QVector>
 #include <QPoint>
 
 class QImage;
@@ -44,17 +45,66 @@ namespace core
 		//! Region boundaries, keyed by label.
 		typedef QMap<Label, Boundary> Regions;
 
-		//! Located region boundaries in the specified image.
+		//! Buffer of pixel labels.
+		struct LabelImage
+		{
+			//! Image width.
+			int width;
+			//! Image height.
+			int height;
+			//! Pixel labels, row by row.
+			QVector<Label> labels;
+
+			//! Returns the label of the specified pixel.
+			Label label(int x, int y) const { return labels[y*width + x]; }
+		};
+
+		//! Computes the label of every pixel of the specified image.
 		/*!
-		 * Runs the "border" algorithm on the previously labeled image.
+		 * Currently the hue value of each pixel is used as label value,
+		 * achromatic pixels are background. To use some other value as label
+		 * modify the getLabel function in border.cpp.
 		 *
-		 * Currently the hue value of each pixel is used as label value.
-		 * To use some other value as label modify the getLabel function in border.cpp.
+		 * \param[out] labels where the labels will be saved
+		 * \param[in] image labeled input image
+		 */
+		void labelImage(LabelImage & labels, QImage const & image);
+
+		//! Located region boundaries in the specified image.
+		/*!
+		 * Labels the image and calls findRegions(Regions &, LabelImage const &).
 		 *
 		 * \param[out] regions where the found regions will be saved
 		 * \param[in] image labeled input image
 		 */
 		void findRegions(Regions & regions, QImage const & image);
+
+		//! Located region boundaries in the specified label buffer.
+		/*!
+		 * Border pixels are the pixels that have at least one of their eight
+		 * neighbours labeled differently, pixels on the edge of the image excluded.
+		 * They are chained into ordered segments by Moore-neighbour tracing, in one
+		 * pass over the buffer.
+		 *
+		 * \param[out] regions where the found regions will be saved
+		 * \param[in] labels labeled pixels
+		 */
+		void findRegions(Regions & regions, LabelImage const & labels);
+
+		//! Parallel version of findRegions(Regions &, LabelImage const &).
+		/*!
+		 * Border pixels are marked in horizontal bands of rows, and the bands are
+		 * stitched into per-label lists of pixels in scan order. Chains never leave
+		 * their own label, so each label is then traced by a separate task.
+		 * The result is the same as with the serial version.
+		 *
+		 * findRegions(Regions &, LabelImage const &) calls this version unless the
+		 * "border/parallel" parameter is turned off.
+		 *
+		 * \param[out] regions where the found regions will be saved
+		 * \param[in] labels labeled pixels
+		 */
+		void findRegionsParallel(Regions & regions, LabelImage const & labels);
 	};
 };
 
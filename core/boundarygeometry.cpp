@@ -0,0 +1,131 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/boundarygeometry.h"
+#include "core/mapimage.h"
+#include "math/funcs.h"
+
+#include <QMutexLocker>
+#include <QDebug>
+#include <QTime>
+
+
+using namespace core;
+using math::Vector2f;
+
+
+//! Number of cached images.
+static int const cacheSize = 4;
+
+
+QSharedPointer<BoundaryGeometry const> BoundaryGeometry::fromImage(core::MapImage const & image)
+{
+	static QMutex mutex;
+	static QList< QPair<qint64, QSharedPointer<BoundaryGeometry const> > > cache;
+
+	QMutexLocker locker(&mutex);
+
+	qint64 key = image.cacheKey();
+
+	for (int i = 0; i < cache.size(); ++i)
+	{
+		if (cache[i].first == key)
+		{
+			// most recently used goes first
+			cache.move(i, 0);
+			return cache.first().second;
+		}
+	}
+
+	QSharedPointer<BoundaryGeometry const> geometry(new BoundaryGeometry(image));
+
+	cache.prepend(qMakePair(key, geometry));
+	while (cache.size() > cacheSize)
+	{
+		cache.removeLast();
+	}
+
+	return geometry;
+}
+
+
+BoundaryGeometry::BoundaryGeometry(core::MapImage const & image)
+{
+	if (image.isNull()) return;
+
+	QTime swatch;
+	swatch.start();
+
+	border::findRegions(m_regions, image);
+
+	foreach (border::Boundary const & boundary, m_regions)
+	{
+		foreach (border::BoundarySegment const & segment, boundary)
+		{
+			Polyline polyline(segment.size());
+
+			for (int i = 0; i < segment.size(); ++i)
+			{
+				polyline[i] = image.toFieldCoords(segment[i]);
+			}
+
+			m_polylines.append(polyline);
+		}
+	}
+
+	qDebug() << "extracted" << m_polylines.size() << "boundary polylines in" << swatch.elapsed() << "ms";
+}
+
+BoundaryGeometry::PolylineList BoundaryGeometry::simplified(float minDist) const
+{
+	QMutexLocker locker(&m_mutex);
+
+	QMap<float, PolylineList>::const_iterator it = m_simplified.find(minDist);
+	if (it != m_simplified.end())
+	{
+		return it.value();
+	}
+
+	PolylineList result;
+
+	foreach (Polyline const & polyline, m_polylines)
+	{
+		if (polyline.isEmpty()) continue;
+
+		Polyline simple;
+
+		Vector2f a = polyline.first();
+		simple.append(a);
+
+		foreach (Vector2f const & b, polyline)
+		{
+			if ((b - a).norm() > minDist)
+			{
+				simple.append(b);
+				a = b;
+			}
+		}
+
+		result.append(simple);
+	}
+
+	m_simplified.insert(minDist, result);
+
+	return result;
+}
@@ -0,0 +1,94 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_BOUNDARYGEOMETRY_H_
+#define CORE_BOUNDARYGEOMETRY_H_
+
+#include "core/boundarygeometry.hh"
+#include "core/border.h"
+#include "core/mapimage.hh"
+#include "math/vector2f.h"
+
+#include <QList>
+#include <QMap>
+#include <QVector>
+#include <QMutex>
+#include <QSharedPointer>
+
+
+//! Geometry of natural boundaries found in a boundary map image.
+/*!
+ * Boundary extraction is done once per image. Objects are shared through
+ * fromImage(), which caches them by image key, so the boundary field, the
+ * seeder and the tracer all read the same result.
+ *
+ * Boundaries are available at full resolution and as simplified polylines
+ * of any resolution, each computed on first request.
+ */
+class core::BoundaryGeometry
+{
+public:
+	//! Polyline in field coordinates.
+	typedef QVector<math::Vector2f> Polyline;
+	//! List of polylines.
+	typedef QList<Polyline> PolylineList;
+
+	//! Returns the shared geometry of the specified boundary map image.
+	/*!
+	 * The geometry is cached by QImage::cacheKey(), so copies of the same
+	 * image share the same object.
+	 */
+	static QSharedPointer<BoundaryGeometry const> fromImage(core::MapImage const & image);
+
+	//! Extracts boundaries from the specified image.
+	explicit BoundaryGeometry(core::MapImage const & image);
+
+	//! Returns the found region boundaries, in image coordinates.
+	border::Regions const & regions() const { return m_regions; }
+
+	//! Returns boundary polylines at full resolution.
+	PolylineList const & polylines() const { return m_polylines; }
+
+	//! Returns simplified boundary polylines.
+	/*!
+	 * Each polyline starts with the first boundary pixel, and a following pixel is
+	 * kept when it is farther than the specified distance from the last kept one.
+	 *
+	 * \param minDist minimum distance between consecutive polyline vertices, in field units
+	 */
+	PolylineList simplified(float minDist) const;
+
+private:
+	//! Region boundaries, in image coordinates.
+	border::Regions m_regions;
+	//! Boundary polylines, in field coordinates.
+	PolylineList m_polylines;
+
+	//! Simplified polylines, keyed by resolution.
+	mutable QMap<float, PolylineList> m_simplified;
+	//! Guards m_simplified.
+	mutable QMutex m_mutex;
+
+	//! Non-copyable.
+	BoundaryGeometry(BoundaryGeometry const &);
+	//! Non-copyable.
+	BoundaryGeometry & operator=(BoundaryGeometry const &);
+};
+
+
+#endif // ifndef CORE_BOUNDARYGEOMETRY_H_
@@ -0,0 +1,118 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/changeset.h"
+
+using namespace core;
+
+
+ChangeSet::ChangeSet()
+{
+}
+
+
+void ChangeSet::addEdge(core::Edge * edge)
+{
+	m_addedEdges.insert(edge);
+}
+
+void ChangeSet::removeEdge(core::Edge * edge)
+{
+	m_modifiedEdges.remove(edge);
+
+	if (! m_addedEdges.remove(edge))
+	{
+		m_removedEdges.insert(edge);
+	}
+}
+
+void ChangeSet::modifyEdge(core::Edge * edge)
+{
+	if (! m_addedEdges.contains(edge))
+	{
+		m_modifiedEdges.insert(edge);
+	}
+}
+
+
+void ChangeSet::addSeed(core::Point const & p)
+{
+	++m_addedSeeds[p];
+}
+
+void ChangeSet::removeSeed(core::Point const & p)
+{
+	PointCounts::iterator it = m_addedSeeds.find(p);
+
+	if (it != m_addedSeeds.end())
+	{
+		if (--it.value() == 0)
+		{
+			m_addedSeeds.erase(it);
+		}
+	}
+	else
+	{
+		++m_removedSeeds[p];
+	}
+}
+
+
+void ChangeSet::addDistrict(core::District * district)
+{
+	m_addedDistricts.insert(district);
+}
+
+void ChangeSet::removeDistrict(core::District * district)
+{
+	m_modifiedDistricts.remove(district);
+
+	if (! m_addedDistricts.remove(district))
+	{
+		m_removedDistricts.insert(district);
+	}
+}
+
+void ChangeSet::modifyDistrict(core::District * district)
+{
+	if (! m_addedDistricts.contains(district))
+	{
+		m_modifiedDistricts.insert(district);
+	}
+}
+
+
+bool ChangeSet::isEmpty() const
+{
+	return m_addedEdges.isEmpty() && m_removedEdges.isEmpty() && m_modifiedEdges.isEmpty()
+		&& m_addedSeeds.isEmpty() && m_removedSeeds.isEmpty()
+		&& m_addedDistricts.isEmpty() && m_removedDistricts.isEmpty() && m_modifiedDistricts.isEmpty();
+}
+
+void ChangeSet::clear()
+{
+	m_addedEdges.clear();
+	m_removedEdges.clear();
+	m_modifiedEdges.clear();
+	m_addedSeeds.clear();
+	m_removedSeeds.clear();
+	m_addedDistricts.clear();
+	m_removedDistricts.clear();
+	m_modifiedDistricts.clear();
+}
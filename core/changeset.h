@@ -0,0 +1,114 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_CHANGESET_H_
+#define CORE_CHANGESET_H_
+
+#include "core/changeset.hh"
+#include "core/point.h"
+#include "core/edge.hh"
+#include "core/district.hh"
+
+#include <QSet>
+#include <QHash>
+
+
+//! Changes made to a road network.
+/*!
+ * Collects edges, seed-points and districts that were added, removed or
+ * modified, so that they can be delivered to the views all at once.
+ *
+ * An object that is added and then removed is dropped from the set. One
+ * that is removed and then added again (which for edges and districts means
+ * a new object at the address of a deleted one) is listed as both; to apply
+ * the set, process the removals first, the additions second and the
+ * modifications last.
+ *
+ * Seed-points are counted per position, as several regions may seed the
+ * same point; an addition and a removal at one point cancel out.
+ *
+ * Removed edges and districts may already be deleted, their pointers must
+ * only be used as keys.
+ */
+class core::ChangeSet
+{
+public:
+	typedef QSet<core::Edge *> EdgeSet;
+	typedef QHash<core::Point, int> PointCounts;
+	typedef QSet<core::District *> DistrictSet;
+
+	//! Constructs an empty set.
+	ChangeSet();
+
+//! \name Recording changes.
+//@{
+	//! Records an added edge.
+	void addEdge(core::Edge * edge);
+	//! Records a removed edge.
+	void removeEdge(core::Edge * edge);
+	//! Records an edge that changed its type or geometry.
+	void modifyEdge(core::Edge * edge);
+
+	//! Records an added seed-point.
+	void addSeed(core::Point const & p);
+	//! Records a removed seed-point.
+	void removeSeed(core::Point const & p);
+
+	//! Records an added district.
+	void addDistrict(core::District * district);
+	//! Records a removed district.
+	void removeDistrict(core::District * district);
+	//! Records a district whose border or blocks have changed.
+	void modifyDistrict(core::District * district);
+//@}
+
+	//! Returns whether there are no changes.
+	bool isEmpty() const;
+
+	//! Removes all changes.
+	void clear();
+
+//! \name Recorded changes.
+//@{
+	EdgeSet const & addedEdges() const { return m_addedEdges; }
+	EdgeSet const & removedEdges() const { return m_removedEdges; }
+	EdgeSet const & modifiedEdges() const { return m_modifiedEdges; }
+
+	//! Returns the number of seeds added at each point.
+	PointCounts const & addedSeeds() const { return m_addedSeeds; }
+	//! Returns the number of seeds removed at each point.
+	PointCounts const & removedSeeds() const { return m_removedSeeds; }
+
+	DistrictSet const & addedDistricts() const { return m_addedDistricts; }
+	DistrictSet const & removedDistricts() const { return m_removedDistricts; }
+	DistrictSet const & modifiedDistricts() const { return m_modifiedDistricts; }
+//@}
+
+private:
+	EdgeSet m_addedEdges;
+	EdgeSet m_removedEdges;
+	EdgeSet m_modifiedEdges;
+	PointCounts m_addedSeeds;
+	PointCounts m_removedSeeds;
+	DistrictSet m_addedDistricts;
+	DistrictSet m_removedDistricts;
+	DistrictSet m_modifiedDistricts;
+};
+
+
+#endif // ifndef CORE_CHANGESET_H_
@@ -23,6 +23,7 @@
 #include "core/seeder.h"
 #include "core/grapher.h"
 #include "core/district.h"
+#include "base/profiler.h"
 
 #include <QTime>
 #include <QDebug>
@@ -41,21 +42,28 @@ City::City(QObject * parent)
 
 void City::clear()
 {
+	ChangeBatch batch(this);
+
+	resetSubregions();
 	removeDistricts();
 
 	while (! seeder().empty())
 	{
-		emit seedRemoved(seeder().pop());
+		changes().removeSeed(seeder().pop());
 	}
 
 	foreach (Edge * edge, tracer().edges())
 	{
 		removeEdge(edge);
 	}
+
+	tracer().resetStatistics();
 }
 
 void City::removeDistricts()
 {
+	ChangeBatch batch(this);
+
 	while (! m_districts.empty())
 	{
 		removeDistrict(m_districts.last());
@@ -70,6 +78,10 @@ void City::traceInit()
 
 bool City::traceStep(TensorField const & field)
 {
+	PROFILE_SPAN("city/traceStep");
+
+	ChangeBatch batch(this);
+
 	if (m_selectedDistrict == NULL && !m_districtsForTrace.empty())
 	{
 		selectDistrict(m_districtsForTrace.takeFirst());
@@ -139,6 +151,8 @@ void City::findSubregions()
 
 void City::findBlocks()
 {
+	PROFILE_SPAN("city/findBlocks");
+
 	QTime swatch;
 	swatch.start();
 
@@ -165,40 +179,20 @@ bool City::traceDistrict(TensorField const & field)
 	}
 }
 
-void City::on_district_edgeAdded(core::Edge * edge)
-{
-	emit edgeAdded(edge);
-}
-
-void City::on_district_edgeRemoved(core::Edge * edge)
-{
-	emit edgeRemoved(edge);
-}
-
-void City::on_district_seedAdded(core::Point const & p)
-{
-	emit seedAdded(p);
-}
-
-void City::on_district_seedRemoved(core::Point const & p)
-{
-	emit seedRemoved(p);
-}
-
-
 void City::addDistrict(core::District * district)
 {
+	ChangeBatch batch(this);
+
 	if (! m_districts.contains(district))
 	{
+		// changes of the district are collected by the city from now on
 		district->setParent(this);
 		m_districts.append(district);
 
-		connect(district, SIGNAL(edgeAdded(core::Edge*)), this, SLOT(on_district_edgeAdded(core::Edge*)));
-		connect(district, SIGNAL(edgeRemoved(core::Edge*)), this, SLOT(on_district_edgeRemoved(core::Edge*)));
-		connect(district, SIGNAL(seedAdded(core::Point)), this, SLOT(on_district_seedAdded(core::Point)));
-		connect(district, SIGNAL(seedRemoved(core::Point)), this, SLOT(on_district_seedRemoved(core::Point)));
+		// local streets avoid the same obstacles as the major ones
+		district->tracer().setObstacleMask(tracer().obstacleMask());
 
-		emit districtAdded(district);
+		changes().addDistrict(district);
 	}
 	else
 	{
@@ -207,7 +201,9 @@ void City::addDistrict(core::District * district)
 }
 
 void City::removeDistrict(core::District * district)
-{	
+{
+	ChangeBatch batch(this);
+
 	m_districtsForTrace.removeOne(district);
 	m_districtsForSubs.removeOne(district);
 
@@ -224,9 +220,7 @@ void City::removeDistrict(core::District * district)
 	if (m_districts.contains(district))
 	{
 		m_districts.removeOne(district);
-		emit districtRemoved(district);
-
-		district->disconnect(this);
+		changes().removeDistrict(district);
 
 		if (district->parent() == this)
 		{
@@ -241,6 +235,18 @@ QList<core::District *> City::districts() const
 	return m_districts;
 }
 
+Tracer::Statistics City::tracerStatistics() const
+{
+	Tracer::Statistics result = tracer().statistics();
+
+	foreach (District * district, m_districts)
+	{
+		result += district->tracer().statistics();
+	}
+
+	return result;
+}
+
 void City::selectDistrict(core::District * district)
 {
 	m_selectedDistrict = district;
@@ -252,11 +258,33 @@ District * City::selectedDistrict() const
 }
 
 
-void City::onSubregionFound(QVector<core::Point> const & border)
+QObject * City::onSubregionFound(QVector<core::Point> const & border)
 {
 	core::District * district = new core::District(border, this);
 	addDistrict(district);
 
 	// tracing candidate
 	m_districtsForTrace.append(district);
+
+	return district;
+}
+
+void City::onSubregionLost(QObject * subregion)
+{
+	core::District * district = qobject_cast<core::District *>(subregion);
+
+	if (district != NULL)
+	{
+		removeDistrict(district);
+	}
+}
+
+void City::onSubregionChanged(QObject * subregion, QVector<core::Point> const & border)
+{
+	core::District * district = qobject_cast<core::District *>(subregion);
+
+	if (district != NULL && m_districts.contains(district))
+	{
+		district->setBorder(border);
+	}
 }
@@ -21,6 +21,7 @@
 
 #include "core/city.hh"
 #include "core/region.h"
+#include "core/tracer.h"
 #include "core/field.hh"
 #include "core/point.hh"
 #include "core/edge.hh"
@@ -80,18 +81,27 @@ public:
 	District * selectedDistrict() const;
 //@}
 
-signals:
-	//! Signal emitted when a district object has been added to the city.
-	void districtAdded(core::District * district);
-	//! Signal emitted when a district object has been removed from the city.
-	void districtRemoved(core::District * district);
+	//! Returns tracing counters summed over the city and all its districts.
+	Tracer::Statistics tracerStatistics() const;
 
 protected:
 	//! Callback function called by base class when a subregion has been detected.
 	/*!
 	 * This implementation creates a District object in the specified area.
 	 */
-	void onSubregionFound(QVector<core::Point> const & border);
+	QObject * onSubregionFound(QVector<core::Point> const & border);
+
+	//! Callback function called by base class when a subregion ceased to exist.
+	/*!
+	 * This implementation removes the district object.
+	 */
+	void onSubregionLost(QObject * subregion);
+
+	//! Callback function called by base class when the border of a subregion has changed.
+	/*!
+	 * This implementation moves the district's border, keeping its streets and blocks.
+	 */
+	void onSubregionChanged(QObject * subregion, QVector<core::Point> const & border);
 
 	//! Called when traceStep() is invoked on a pristine object.
 	virtual void traceInit();
@@ -111,16 +121,6 @@ private:
 
 	//! Traces a field in the currently selected district.
 	bool traceDistrict(TensorField const & field);
-
-private slots:
-	//! Callback function called when a district has added an edge.
-	void on_district_edgeAdded(core::Edge * edge);
-	//! Callback function called when a district has removed an edge.
-	void on_district_edgeRemoved(core::Edge * edge);
-	//! Callback function called when a district has added a seed.
-	void on_district_seedAdded(core::Point const & p);
-	//! Callback function called when a district has removed a seed.
-	void on_district_seedRemoved(core::Point const & p);
 };
 
 
@@ -35,6 +35,7 @@ using math::Vector2f;
 District::District(QVector<Point> const & border, QObject * parent)
 	: Region(parent)
 	, m_polygon(border)
+	, m_mask(m_polygon)
 {
 	m_traceMajorNetwork = false;
 }
@@ -42,6 +43,8 @@ District::District(QVector<Point> const & border, QObject * parent)
 
 bool District::traceStep(TensorField const & field)
 {
+	ChangeBatch batch(this);
+
 	if (seeder().empty() && tracer().edgesCount() == 0)
 	{
 		traceInit();
@@ -65,8 +68,8 @@ void District::traceInit()
 	{
 		if (edge->parent() != NULL)
 		{
-			grapher().connect(edge->v1(), edge->v2());
-			emit edgeAdded(edge);
+			grapher().connect(edge);
+			changes().addEdge(edge);
 		}
 	}
 }
@@ -74,17 +77,20 @@ void District::traceInit()
 
 bool District::contains(Point const & p)
 {
-	return m_polygon.contains(p);
+	return m_mask.contains(p);
 }
 
 
 void District::clear()
 {
+	ChangeBatch batch(this);
+
+	resetSubregions();
 	m_blocks.clear();
 
 	while (! seeder().empty())
 	{
-		emit seedRemoved(seeder().pop());
+		changes().removeSeed(seeder().pop());
 	}
 
 	foreach (Edge * edge, tracer().edges())
@@ -94,26 +100,61 @@ void District::clear()
 }
 
 
-void District::onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order)
+void District::setBorder(QVector<Point> const & border)
+{
+	ChangeBatch batch(this);
+
+	m_polygon = math::Polygon(border);
+	m_mask = math::PolygonMask(m_polygon);
+
+	changes().modifyDistrict(this);
+}
+
+
+//! Returns vertices at which the specified edges start along the border.
+static
+QVector<Point> subregionBase(QVector<Edge *> const & edges, QVector<bool> const & order)
 {
-	QList<Point> border;
-	QList<Point> base;
+	QVector<Point> base;
 
 	for (int i = 0; i < edges.size(); ++i)
 	{
-		Edge * edge = edges[i];
+		base << (order[i] ? edges[i]->v1() : edges[i]->v2());
+	}
 
-		if (order[i])
-		{
-			border << edge->v1() << edge->trace() << edge->v2();
-			base << edge->v1();
-		}
-		else
-		{
-			border << edge->v2() << edge->traceReversed() << edge->v1();
-			base << edge->v2();
-		}
+	return base;
+}
+
+QObject * District::onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order)
+{
+	Block * block = new Block(subregionBase(edges, order), subregionBorder(edges, order), this);
+	m_blocks.append(block);
+
+	changes().modifyDistrict(this);
+
+	return block;
+}
+
+void District::onSubregionLost(QObject * subregion)
+{
+	Block * block = qobject_cast<Block *>(subregion);
+
+	if (block != NULL && m_blocks.removeOne(block))
+	{
+		delete block;
+
+		changes().modifyDistrict(this);
 	}
+}
+
+void District::onSubregionChanged(QObject * subregion, QVector<Edge *> const & edges, QVector<bool> const & order)
+{
+	Block * block = qobject_cast<Block *>(subregion);
 
-	m_blocks.append(new Block(base.toVector(), border.toVector(), this));
+	if (block != NULL && m_blocks.contains(block))
+	{
+		block->setBorder(subregionBase(edges, order), subregionBorder(edges, order));
+
+		changes().modifyDistrict(this);
+	}
 }
@@ -24,6 +24,7 @@
 #include "core/block.hh"
 #include "core/point.hh"
 #include "math/polygon.h"
+#include "math/polygonmask.h"
 
 #include <QVector>
 
@@ -54,6 +55,8 @@ public:
 
 	//! Tests whether this district encloses the specified point.
 	/*!
+	 * Points away from the border are classified in constant time.
+	 *
 	 * \param p point to test
 	 */
 	bool contains(Point const & p);
@@ -61,6 +64,17 @@ public:
 	//!  Removes all edges and trace points from this district.
 	void clear();
 
+	//! Replaces the polygon that limits the district area.
+	/*!
+	 * Streets and blocks traced so far are kept, as the new border encloses
+	 * the same area; a split or merged face is found as a new district instead.
+	 * Boundary edges are traced from the new polygon if tracing has not
+	 * started yet.
+	 *
+	 * \param border new district border
+	 */
+	void setBorder(QVector<Point> const & border);
+
 	//! Returns the polygon that limits the district area.
 	math::Polygon polygon() const { return m_polygon; }
 
@@ -70,9 +84,21 @@ public:
 protected:
 	//! Callback function called by base class when a subregion has been detected.
 	/*!
-	 * This implementation creates a District object in the enclosed area.
+	 * This implementation creates a Block object in the enclosed area.
+	 */
+	QObject * onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order);
+
+	//! Callback function called by base class when a subregion ceased to exist.
+	/*!
+	 * This implementation removes the block object.
+	 */
+	void onSubregionLost(QObject * subregion);
+
+	//! Callback function called by base class when the border of a subregion has changed.
+	/*!
+	 * This implementation updates the block object's polygons.
 	 */
-	void onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order);
+	void onSubregionChanged(QObject * subregion, QVector<Edge *> const & edges, QVector<bool> const & order);
 
 	//! Adds initial seed point and boundary edge.
 	virtual void traceInit();
@@ -80,6 +106,8 @@ protected:
 private:
 	//! Polygon encapsulating the district's area.
 	math::Polygon m_polygon;
+	//! Mask of the polygon, for fast containment tests.
+	math::PolygonMask m_mask;
 	//! Detected urban blocks.
 	QList<Block *> m_blocks;
 };
@@ -18,14 +18,19 @@
  */
 
 #include "core/field.h"
-#include "core/border.h"
+#include "core/boundarygeometry.h"
+#include "core/filter.h"
+#include "core/heightmap.h"
+#include "core/parameters.h"
 #include "math/funcs.h"
 #include "math/vector2f.h"
 #include "math/tensor.h"
+#include "base/profiler.h"
 
 #include <math.h>
 
 #include <QtGui>
+#include <QtConcurrentMap>
 
 
 using namespace core;
@@ -198,8 +203,11 @@ void BasisSumField::clear()
 
 
 HeightField::HeightField(QImage const & image)
-	: m_image(image)
 {
+	if (! image.isNull())
+	{
+		setImage(image);
+	}
 }
 
 HeightField::~HeightField()
@@ -209,40 +217,48 @@ HeightField::~HeightField()
 void HeightField::setImage(QImage const & image)
 {
 	m_image = image;
+	setHeights(m_image.values());
 }
 
-Tensor HeightField::operator()(math::Vector2f const & p) const
+void HeightField::setHeightMap(HeightMap const & heightMap)
 {
-	static const int dx = 2, dy = 2;
-	
-	if (m_image.isNull())
-	{
-		return Tensor();
-	}
-	
-	QPoint  ip = m_image.toImageCoords(p).toPoint();
+	Parameters * params = Parameters::instance();
+	int resolution = params->get("heightField/resolution", 2048).toInt();
+	int previewSize = params->get("heightField/previewSize", 1024).toInt();
 
-	if (! QRect(QPoint(0,0), m_image.size()-QSize(dx,dy)).contains(ip))
-	{
-		return Tensor();
-	}
-	
-	QRgb pix0 = m_image.pixel(ip);
-	float f0 = QColor::fromRgb(pix0).valueF();
-	
-	QRgb pix1 = m_image.pixel(ip + QPoint(dx,0));
-	float f1 = QColor::fromRgb(pix1).valueF();
+	FloatRaster heights = heightMap.toRaster(heightMap.levelForSize(resolution));
+
+	// the image is a preview reduced from the same heights, the tensors are
+	// computed from the heights themselves
+	//
+	m_image = MapImage(HeightMap::toImage(heights, previewSize));
+	setHeights(heights);
+}
+
+void HeightField::setHeights(FloatRaster const & heights)
+{
+	PROFILE_SPAN("field/heightTensors");
+
+	Parameters * params = Parameters::instance();
+	float blur = params->get("heightField/blur", 1.0f).toFloat();
+	float smoothing = params->get("heightField/smoothing", 2.0f).toFloat();
 
-	QRgb pix2 = m_image.pixel(ip + QPoint(0,dy));
-	float f2 = QColor::fromRgb(pix2).valueF();
+	FloatRaster blurred, gx, gy;
+	filter::gaussianBlur(blurred, heights, blur);
+	filter::gradient(gx, gy, blurred);
 
-	qreal dHx = 100.0f * (f1 - f0);
-	qreal dHy = 100.0f * (f2 - f0);
+	// the old forward difference over two pixels was scaled by 100
+	filter::orientationTensor(m_tensorX, m_tensorY, gx, gy, smoothing, 200.0f);
+}
 
-	qreal f = atan2f(dHy, dHx) + M_PI/2.0f;
-	qreal r = sqrtf(pow2(dHx) + pow2(dHy));
+Tensor HeightField::operator()(math::Vector2f const & p) const
+{
+	if (m_tensorX.isNull())
+	{
+		return Tensor();
+	}
 
-	return Tensor(r, f);
+	return Tensor::fromValues(m_tensorX.bilinear(p), m_tensorY.bilinear(p));
 }
 
 
@@ -250,7 +266,13 @@ Tensor HeightField::operator()(math::Vector2f const & p) const
 
 
 BoundaryField::BoundaryField(QImage const & image)
+	: m_method(RadialBasisMethod)
 {
+	if (Parameters::instance()->get("boundaryField/distanceTransform", false).toBool())
+	{
+		m_method = DistanceTransformMethod;
+	}
+
 	if (! image.isNull())
 	{
 		setImage(image);
@@ -260,53 +282,143 @@ BoundaryField::BoundaryField(QImage const & image)
 void BoundaryField::setImage(QImage const & image)
 {
 	m_image = image;
+	m_geometry.clear();
+
+	if (! m_image.isNull())
+	{
+		m_geometry = BoundaryGeometry::fromImage(m_image);
+
+		QPainter painter;
+		painter.begin(&m_image);
+
+		QPen pen;
+		pen.setColor(QColor(100, 100, 255));
+		painter.setPen(pen);
+
+		foreach (BoundaryGeometry::Polyline const & polyline, m_geometry->simplified(0.02f))
+		{
+			for (int i = 1; i < polyline.size(); ++i)
+			{
+				painter.drawLine(m_image.toImageCoords(polyline[i-1]), m_image.toImageCoords(polyline[i]));
+			}
+		}
+
+		painter.end();
+	}
+
+	update();
+}
+
+void BoundaryField::setMethod(Method method)
+{
+	if (method != m_method)
+	{
+		m_method = method;
+		update();
+	}
+}
+
+void BoundaryField::update()
+{
+	PROFILE_SPAN("field/boundary");
+
 	m_sumField.clear();
+	m_distance = FloatRaster();
+	m_tensorX = FloatRaster();
+	m_tensorY = FloatRaster();
 
-	if (m_image.isNull())
+	if (m_geometry.isNull())
 	{
 		return;
 	}
-	
-	QPainter painter;
-	painter.begin(&m_image);
 
-	QPen pen;
-	pen.setColor(QColor(100, 100, 255));
-	painter.setPen(pen);
-	
-	border::Regions regions;
-	border::findRegions(regions, image);
+	if (m_method == DistanceTransformMethod)
+	{
+		computeDistanceField();
+	}
+	else
+	{
+		createBasisFields();
+	}
+}
 
-	foreach (border::Boundary const & boundary, regions)
+void BoundaryField::createBasisFields()
+{
+	foreach (BoundaryGeometry::Polyline const & polyline, m_geometry->simplified(0.02f))
+	{
+		for (int i = 1; i < polyline.size(); ++i)
+		{
+			m_sumField += new BasisField(polyline[i-1], 1.0f, polyline[i] - polyline[i-1]);
+		}
+	}
+}
+
+void BoundaryField::computeDistanceField()
+{
+	int const w = m_image.width();
+	int const h = m_image.height();
+
+	if (w < 2 || h < 2) return;
+
+	ByteRaster seeds(w,h);
+
+	foreach (border::Boundary const & boundary, m_geometry->regions())
 	{
 		foreach (border::BoundarySegment const & segment, boundary)
 		{
-			QPoint a = segment[0];
-			Vector2f af = m_image.toFieldCoords(a);
-			
-			foreach (QPoint b, segment)
+			foreach (QPoint const & pixel, segment)
 			{
-				Vector2f bf = m_image.toFieldCoords(b);
-
-				Vector2f d = bf - af;
-				if (d.norm() > 0.02)
-				{
-					m_sumField += new BasisField(af, 1.0f, d);
-					
-					painter.drawLine(a,b);
-
-					a = b;
-					af = m_image.toFieldCoords(a);
-				}
+				seeds.setValue(pixel.x(), pixel.y(), 1);
 			}
 		}
 	}
 
-	painter.end();
+	// distances in field units
+	//
+	float const sx = 1.0f / (w-1);
+	float const sy = 1.0f / (h-1);
+
+	filter::distanceTransform(m_distance, seeds, sx, sy);
+
+	FloatRaster gx, gy;
+	filter::gradient(gx, gy, m_distance);
+
+	// gradient in field coordinates, where the y axis points up
+	//
+	for (int y = 0; y < h; ++y)
+	{
+		float * lx = gx.scanLine(y);
+		float * ly = gy.scanLine(y);
+
+		for (int x = 0; x < w; ++x)
+		{
+			lx[x] /= sx;
+			ly[x] /= -sy;
+		}
+	}
+
+	// the distance gradient is of unit length except on the boundaries and
+	// where the nearest boundary changes, there its direction is recovered
+	// from the neighbourhood
+	//
+	filter::orientationTensor(m_tensorX, m_tensorY, gx, gy, 1.0f, 1.0f);
 }
 
 Tensor BoundaryField::operator()(math::Vector2f const & p) const
 {
+	if (m_method == DistanceTransformMethod)
+	{
+		if (m_distance.isNull())
+		{
+			return Tensor();
+		}
+
+		float d = m_distance.bilinear(p);
+		Tensor t = Tensor::fromValues(m_tensorX.bilinear(p), m_tensorY.bilinear(p));
+
+		return expf(-decay() * d*d) * t;
+	}
+
 	return m_sumField(p);
 }
 
@@ -337,34 +449,48 @@ DiscreteField::~DiscreteField()
 	m_matrix = NULL;
 }
 
-void DiscreteField::loadValues(TensorField const & field)
+//! Row of lattice points loaded from a tensor field.
+struct LoadRowTask
 {
-	int rows = m_dim+1, cols = m_dim+1;
-
-	float sx, sy;
-	sx = sy = 1.0f / m_dim;
-
-	QProgressDialog progress;
-	progress.setLabelText("Loading values...");
-	progress.setRange(0, rows);
-	
-	for (int row = 0; row < rows; ++row)
+	//! Field the values are loaded from.
+	TensorField const * field;
+	//! Destination row.
+	Tensor * values;
+	//! Row index.
+	int row;
+	//! Number of lattice points in the row.
+	int cols;
+	//! Distance between two lattice points.
+	float step;
+
+	//! Samples the field at lattice points of the row.
+	void run()
 	{
 		for (int col = 0; col < cols; ++col)
 		{
-			Vector2f p(col*sx, row*sy);
-			m_matrix[row][col] = field(p);
+			Vector2f p(col*step, row*step);
+			values[col] = (*field)(p);
 		}
+	}
+};
 
-		QCoreApplication::processEvents();
-		
-		progress.setValue(progress.value()+1);
-		if (progress.wasCanceled())
-		{
-			// TODO: maybe revert?
-			break;
-		}
+void DiscreteField::loadValues(TensorField const & field)
+{
+	PROFILE_SPAN("field/loadValues");
+
+	int rows = m_dim+1, cols = m_dim+1;
+
+	QVector<LoadRowTask> tasks(rows);
+	for (int row = 0; row < rows; ++row)
+	{
+		tasks[row].field = &field;
+		tasks[row].values = m_matrix[row];
+		tasks[row].row = row;
+		tasks[row].cols = cols;
+		tasks[row].step = 1.0f / m_dim;
 	}
+
+	QtConcurrent::blockingMap(tasks, &LoadRowTask::run);
 }
 
 Tensor DiscreteField::operator()(math::Vector2f const & p) const
@@ -20,11 +20,14 @@
 #define CORE_FIELD_H_
 
 #include "core/field.hh"
+#include "core/boundarygeometry.hh"
+#include "core/heightmap.hh"
 #include "core/mapimage.h"
 #include "math/tensor.h"
 #include "math/vector2f.hh"
 
 #include <QObject>
+#include <QSharedPointer>
 #include <list>
 
 
@@ -147,6 +150,17 @@ private:
 
 
 //! Tensor field obtained from a heightmap image.
+/*!
+ * Roads follow the terrain contours, perpendicular to the gradient of the
+ * height. The field is precomputed on assignment of the image: heights are
+ * blurred, differentiated with the Scharr operator, and the resulting structure
+ * tensor is averaged. Values are sampled bilinearly from the result.
+ *
+ * The amount of blurring and averaging are taken from the "heightField/blur"
+ * and "heightField/smoothing" parameters, in pixels.
+ *
+ * High-precision heights can be assigned from a HeightMap instead of an image.
+ */
 class core::HeightField : public virtual TensorField
 {
 public:
@@ -155,9 +169,19 @@ public:
 	~HeightField();
 
 	//! Returns the heightmap image.
+	/*!
+	 * After setHeightMap(), this is a grayscale preview of the heights, not
+	 * larger than the "heightField/previewSize" parameter.
+	 */
 	QImage image() const { return m_image; }
 	//! Assigns the heightmap image.
 	void setImage(QImage const & image);
+	//! Assigns heights from the specified heightmap.
+	/*!
+	 * The finest pyramid level not larger than the "heightField/resolution"
+	 * parameter is used. The heightmap image becomes its preview.
+	 */
+	void setHeightMap(HeightMap const & heightMap);
 	
 	//! Returns the tensor value at the specified point.
 	math::Tensor operator()(math::Vector2f const & p) const;
@@ -165,13 +189,42 @@ public:
 private:
 	//! Heightmap image.
 	MapImage m_image;
+	//! First component of the tensor at each pixel.
+	FloatRaster m_tensorX;
+	//! Second component of the tensor at each pixel.
+	FloatRaster m_tensorY;
+
+	//! Computes the tensor rasters from the specified heights.
+	void setHeights(FloatRaster const & heights);
 };
 
 
 //! Tensor field that respects natural boundaries.
+/*!
+ * The field follows the boundaries found in the boundary map image, and it
+ * weakens with distance from them. It can be computed by two methods:
+ *
+ * - RadialBasisMethod sums one basis field per step of the simplified
+ *   boundary polylines, so its cost grows with the boundary length.
+ * - DistanceTransformMethod computes the exact distance to the boundaries
+ *   for every pixel, takes the direction perpendicular to the distance gradient,
+ *   and the strength exp(-decay*d^2) of the distance d. The rasters are
+ *   precomputed in time linear in the number of pixels, and then sampled
+ *   bilinearly.
+ *
+ * The initial method is the distance transform if the
+ * "boundaryField/distanceTransform" parameter is set.
+ */
 class core::BoundaryField : public virtual TensorField
 {
 public:
+	//! Method of computing the field.
+	enum Method
+	{
+		RadialBasisMethod,
+		DistanceTransformMethod
+	};
+
 	//! Constructs the object.
 	BoundaryField(QImage const & image = QImage());
 
@@ -181,18 +234,40 @@ public:
 	//! Assigns the boundary map image.
 	void setImage(QImage const & image);
 	//! Returns the boundary map image.
-	MapImage image() const { return m_image; }
+	MapImage const & image() const { return m_image; }
 	
-	//! Assigns the RBF decay parameter.
+	//! Assigns the decay parameter.
 	void setDecay(float value) { m_sumField.setDecay(value); }
-	//! Returns the RBF decay parameter.
+	//! Returns the decay parameter.
 	float decay() const { return m_sumField.decay(); }
 
+	//! Selects the method of computing the field.
+	void setMethod(Method method);
+	//! Returns the method of computing the field.
+	Method method() const { return m_method; }
+
 private:
 	//! Boundary map image.
 	MapImage m_image;
+	//! Boundaries found in the image.
+	QSharedPointer<BoundaryGeometry const> m_geometry;
+	//! Method of computing the field.
+	Method m_method;
 	//! Sum field.
 	BasisSumField m_sumField;
+	//! Distance to the nearest boundary at each pixel.
+	FloatRaster m_distance;
+	//! First component of the unit tensor at each pixel.
+	FloatRaster m_tensorX;
+	//! Second component of the unit tensor at each pixel.
+	FloatRaster m_tensorY;
+
+	//! Recomputes the field with the current method.
+	void update();
+	//! Creates the basis fields of the radial basis method.
+	void createBasisFields();
+	//! Computes the rasters of the distance transform method.
+	void computeDistanceField();
 };
 
 
@@ -213,6 +288,9 @@ public:
 
 	//! Loads values at lattice points from the specified tensor field.
 	/*!
+	 * Rows of lattice points are loaded in parallel, so the field must be safe
+	 * to evaluate from several threads at once.
+	 *
 	 * \param field tensor field to load values from
 	 */
 	void loadValues(TensorField const & field);
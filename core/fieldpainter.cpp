@@ -22,6 +22,7 @@
 #include "math/vector2f.h"
 #include "math/tensor.h"
 #include "math/funcs.h"
+#include "base/profiler.h"
 
 #include <QtCore>
 #include <QtOpenGL>
@@ -173,6 +174,8 @@ void FieldPainter::remakeIfNeeded()
 {
 	if (! needsRemake()) return;
 	needsRemake(false);
+
+	PROFILE_SPAN("fieldPainter/remake");
 	
 	m_blendImage = makeBlendImage();
 	makeMesh();
@@ -234,6 +237,8 @@ void FieldPainter::resizeGL(int w, int h)
 
 void FieldPainter::paintGL(bool flag)
 {
+	PROFILE_SPAN("fieldPainter/paint");
+
 	paintTexture(flag);
 }
 
@@ -0,0 +1,526 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/filter.h"
+#include "core/raster.h"
+
+#include <QVector>
+#include <QThread>
+#include <QtConcurrentMap>
+
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+#if defined(__SSE__)
+#include <xmmintrin.h>
+#endif
+
+using namespace core;
+
+
+//! Adds a scaled row to another: out += k*in.
+static
+void addScaled(float * out, float const * in, float k, int n)
+{
+	int i = 0;
+#if defined(__SSE__)
+	__m128 vk = _mm_set1_ps(k);
+	for (; i+4 <= n; i += 4)
+	{
+		__m128 vo = _mm_loadu_ps(out+i);
+		__m128 vi = _mm_loadu_ps(in+i);
+		_mm_storeu_ps(out+i, _mm_add_ps(vo, _mm_mul_ps(vk, vi)));
+	}
+#endif
+	for (; i < n; ++i)
+	{
+		out[i] += k * in[i];
+	}
+}
+
+//! Adds a scaled difference of two rows to another: out += k*(plus - minus).
+static
+void addScaledDifference(float * out, float const * plus, float const * minus, float k, int n)
+{
+	int i = 0;
+#if defined(__SSE__)
+	__m128 vk = _mm_set1_ps(k);
+	for (; i+4 <= n; i += 4)
+	{
+		__m128 vo = _mm_loadu_ps(out+i);
+		__m128 vd = _mm_sub_ps(_mm_loadu_ps(plus+i), _mm_loadu_ps(minus+i));
+		_mm_storeu_ps(out+i, _mm_add_ps(vo, _mm_mul_ps(vk, vd)));
+	}
+#endif
+	for (; i < n; ++i)
+	{
+		out[i] += k * (plus[i] - minus[i]);
+	}
+}
+
+//! Copies a row into a buffer, with the edge pixels repeated on both sides.
+static
+void padRow(float * buffer, float const * row, int n, int pad)
+{
+	for (int i = 0; i < pad; ++i)
+	{
+		buffer[i] = row[0];
+		buffer[pad + n + i] = row[n-1];
+	}
+	memcpy(buffer + pad, row, n * sizeof(float));
+}
+
+//! Returns normalized weights of a Gaussian kernel, from -radius to radius.
+static
+QVector<float> gaussianKernel(float sigma)
+{
+	int radius = qMax(1, int(ceilf(3.0f * sigma)));
+
+	QVector<float> weights(2*radius + 1);
+	float sum = 0;
+
+	for (int i = -radius; i <= radius; ++i)
+	{
+		weights[i + radius] = expf(-0.5f * i*i / (sigma*sigma));
+		sum += weights[i + radius];
+	}
+	for (int i = 0; i < weights.size(); ++i)
+	{
+		weights[i] /= sum;
+	}
+
+	return weights;
+}
+
+
+//! Band of rows, or columns, processed by a filter kernel.
+template<class Kernel>
+struct BandTask
+{
+	//! The kernel.
+	Kernel const * kernel;
+	//! First row.
+	int y0;
+	//! One past the last row.
+	int y1;
+
+	//! Runs the kernel on the band.
+	void run() { kernel->run(y0, y1); }
+};
+
+//! Runs the kernel on all rows, or columns, in parallel bands.
+template<class Kernel>
+static
+void runInBands(Kernel const & kernel, int rows)
+{
+	int const n = qMax(1, qMin(rows, QThread::idealThreadCount() * 4));
+
+	QVector< BandTask<Kernel> > tasks(n);
+	for (int t = 0; t < n; ++t)
+	{
+		tasks[t].kernel = &kernel;
+		tasks[t].y0 = (rows * t) / n;
+		tasks[t].y1 = (rows * (t+1)) / n;
+	}
+
+	QtConcurrent::blockingMap(tasks, &BandTask<Kernel>::run);
+}
+
+
+//! Convolution of rows with a symmetric kernel.
+struct HorizontalBlur
+{
+	FloatRaster const * in;
+	FloatRaster * out;
+	QVector<float> weights;
+
+	void run(int y0, int y1) const
+	{
+		int const w = in->width();
+		int const r = weights.size() / 2;
+
+		QVector<float> buffer(w + 2*r);
+
+		for (int y = y0; y < y1; ++y)
+		{
+			padRow(buffer.data(), in->constScanLine(y), w, r);
+
+			float * o = out->scanLine(y);
+			memset(o, 0, w * sizeof(float));
+
+			for (int i = 0; i < weights.size(); ++i)
+			{
+				addScaled(o, buffer.constData() + i, weights[i], w);
+			}
+		}
+	}
+};
+
+//! Convolution of columns with a symmetric kernel.
+struct VerticalBlur
+{
+	FloatRaster const * in;
+	FloatRaster * out;
+	QVector<float> weights;
+
+	void run(int y0, int y1) const
+	{
+		int const w = in->width();
+		int const h = in->height();
+		int const r = weights.size() / 2;
+
+		for (int y = y0; y < y1; ++y)
+		{
+			float * o = out->scanLine(y);
+			memset(o, 0, w * sizeof(float));
+
+			for (int i = -r; i <= r; ++i)
+			{
+				int yy = qBound(0, y + i, h-1);
+				addScaled(o, in->constScanLine(yy), weights[i + r], w);
+			}
+		}
+	}
+};
+
+//! Scharr operator, the derivative is smoothed with weights 3, 10, 3.
+struct Scharr
+{
+	FloatRaster const * in;
+	FloatRaster * gx;
+	FloatRaster * gy;
+
+	void run(int y0, int y1) const
+	{
+		static float const k[3] = { 3.0f/32, 10.0f/32, 3.0f/32 };
+
+		int const w = in->width();
+		int const h = in->height();
+
+		// previous, current and next row, padded by one pixel
+		QVector<float> buffer(3 * (w+2));
+		float * rows[3] = { buffer.data(), buffer.data() + (w+2), buffer.data() + 2*(w+2) };
+
+		for (int y = y0; y < y1; ++y)
+		{
+			for (int j = 0; j < 3; ++j)
+			{
+				padRow(rows[j], in->constScanLine(qBound(0, y + j - 1, h-1)), w, 1);
+			}
+
+			float * ox = gx->scanLine(y);
+			float * oy = gy->scanLine(y);
+			memset(ox, 0, w * sizeof(float));
+			memset(oy, 0, w * sizeof(float));
+
+			for (int j = 0; j < 3; ++j)
+			{
+				addScaledDifference(ox, rows[j] + 2, rows[j], k[j], w);
+				addScaledDifference(oy, rows[2] + j, rows[0] + j, k[j], w);
+			}
+		}
+	}
+};
+
+//! Products of gradient components, the structure tensor.
+struct StructureTensor
+{
+	FloatRaster const * gx;
+	FloatRaster const * gy;
+	FloatRaster * jxx;
+	FloatRaster * jxy;
+	FloatRaster * jyy;
+	float scale;
+
+	void run(int y0, int y1) const
+	{
+		int const w = gx->width();
+		float const s2 = scale * scale;
+
+		for (int y = y0; y < y1; ++y)
+		{
+			float const * a = gx->constScanLine(y);
+			float const * b = gy->constScanLine(y);
+			float * xx = jxx->scanLine(y);
+			float * xy = jxy->scanLine(y);
+			float * yy = jyy->scanLine(y);
+
+			for (int x = 0; x < w; ++x)
+			{
+				xx[x] = s2 * a[x]*a[x];
+				xy[x] = s2 * a[x]*b[x];
+				yy[x] = s2 * b[x]*b[x];
+			}
+		}
+	}
+};
+
+//! Conversion of the structure tensor to orientation tensor components.
+struct OrientationTensor
+{
+	FloatRaster const * jxx;
+	FloatRaster const * jxy;
+	FloatRaster const * jyy;
+	FloatRaster * tx;
+	FloatRaster * ty;
+
+	void run(int y0, int y1) const
+	{
+		int const w = jxx->width();
+
+		for (int y = y0; y < y1; ++y)
+		{
+			float const * xx = jxx->constScanLine(y);
+			float const * xy = jxy->constScanLine(y);
+			float const * yy = jyy->constScanLine(y);
+			float * ox = tx->scanLine(y);
+			float * oy = ty->scanLine(y);
+
+			for (int x = 0; x < w; ++x)
+			{
+				// g*g^T of a gradient at angle f is |g|^2 * [1 + cos 2f, sin 2f; sin 2f, 1 - cos 2f] / 2,
+				// and rotating by pi/2 negates the doubled-angle components
+				//
+				float trace = xx[x] + yy[x];
+				float r = (trace > 0) ? 1.0f / sqrtf(trace) : 0.0f;
+
+				ox[x] = (yy[x] - xx[x]) * r;
+				oy[x] = -2.0f * xy[x] * r;
+			}
+		}
+	}
+};
+
+
+//! Value of pixels without a seed in the distance transform.
+static float const farAway = 1e20f;
+
+//! One-dimensional squared distance transform.
+/*!
+ * \param f squared distances of the samples, farAway for none
+ * \param d resulting squared distances
+ * \param n number of samples
+ * \param s2 squared spacing of samples
+ * \param v work buffer, n entries
+ * \param z work buffer, n+1 entries
+ */
+static
+void distanceTransform1D(float const * f, float * d, int n, float s2, int * v, float * z)
+{
+	float const infinity = std::numeric_limits<float>::infinity();
+
+	// lower envelope of the parabolas rooted at the samples
+	//
+	int k = 0;
+	v[0] = 0;
+	z[0] = -infinity;
+	z[1] = infinity;
+
+	for (int q = 1; q < n; ++q)
+	{
+		float s = ((f[q] + s2*q*q) - (f[v[k]] + s2*v[k]*v[k])) / (2*s2*(q - v[k]));
+
+		while (s <= z[k])
+		{
+			--k;
+			s = ((f[q] + s2*q*q) - (f[v[k]] + s2*v[k]*v[k])) / (2*s2*(q - v[k]));
+		}
+
+		++k;
+		v[k] = q;
+		z[k] = s;
+		z[k+1] = infinity;
+	}
+
+	// sample the envelope
+	//
+	k = 0;
+	for (int q = 0; q < n; ++q)
+	{
+		while (z[k+1] < q) ++k;
+
+		int r = v[k];
+		d[q] = s2*(q - r)*(q - r) + f[r];
+	}
+}
+
+//! First pass of the distance transform, over columns.
+struct DistanceColumns
+{
+	ByteRaster const * seeds;
+	FloatRaster * out;
+	float s2;
+
+	void run(int x0, int x1) const
+	{
+		int const h = seeds->height();
+
+		QVector<float> f(h), d(h), z(h+1);
+		QVector<int> v(h);
+
+		for (int x = x0; x < x1; ++x)
+		{
+			for (int y = 0; y < h; ++y)
+			{
+				f[y] = seeds->value(x,y) ? 0.0f : farAway;
+			}
+
+			distanceTransform1D(f.constData(), d.data(), h, s2, v.data(), z.data());
+
+			for (int y = 0; y < h; ++y)
+			{
+				out->scanLine(y)[x] = d[y];
+			}
+		}
+	}
+};
+
+//! Second pass of the distance transform, over rows.
+struct DistanceRows
+{
+	FloatRaster const * in;
+	FloatRaster * out;
+	float s2;
+
+	void run(int y0, int y1) const
+	{
+		int const w = in->width();
+
+		QVector<float> z(w+1);
+		QVector<int> v(w);
+
+		for (int y = y0; y < y1; ++y)
+		{
+			float * o = out->scanLine(y);
+
+			distanceTransform1D(in->constScanLine(y), o, w, s2, v.data(), z.data());
+
+			for (int x = 0; x < w; ++x)
+			{
+				o[x] = sqrtf(o[x]);
+			}
+		}
+	}
+};
+
+
+void core::filter::gaussianBlur(FloatRaster & out, FloatRaster const & in, float sigma)
+{
+	if (sigma <= 0 || in.isNull())
+	{
+		out = in;
+		return;
+	}
+
+	FloatRaster tmp(in.width(), in.height());
+	FloatRaster result(in.width(), in.height());
+
+	HorizontalBlur horizontal;
+	horizontal.in = &in;
+	horizontal.out = &tmp;
+	horizontal.weights = gaussianKernel(sigma);
+	runInBands(horizontal, in.height());
+
+	VerticalBlur vertical;
+	vertical.in = &tmp;
+	vertical.out = &result;
+	vertical.weights = horizontal.weights;
+	runInBands(vertical, in.height());
+
+	out = result;
+}
+
+void core::filter::gradient(FloatRaster & gx, FloatRaster & gy, FloatRaster const & in)
+{
+	FloatRaster rx(in.width(), in.height());
+	FloatRaster ry(in.width(), in.height());
+
+	if (! in.isNull())
+	{
+		Scharr scharr;
+		scharr.in = &in;
+		scharr.gx = &rx;
+		scharr.gy = &ry;
+		runInBands(scharr, in.height());
+	}
+
+	gx = rx;
+	gy = ry;
+}
+
+void core::filter::orientationTensor(FloatRaster & tx, FloatRaster & ty,
+	FloatRaster const & gx, FloatRaster const & gy, float sigma, float scale)
+{
+	int const w = gx.width();
+	int const h = gx.height();
+
+	FloatRaster jxx(w,h), jxy(w,h), jyy(w,h);
+
+	StructureTensor structure;
+	structure.gx = &gx;
+	structure.gy = &gy;
+	structure.jxx = &jxx;
+	structure.jxy = &jxy;
+	structure.jyy = &jyy;
+	structure.scale = scale;
+	runInBands(structure, h);
+
+	gaussianBlur(jxx, jxx, sigma);
+	gaussianBlur(jxy, jxy, sigma);
+	gaussianBlur(jyy, jyy, sigma);
+
+	FloatRaster rx(w,h), ry(w,h);
+
+	OrientationTensor orientation;
+	orientation.jxx = &jxx;
+	orientation.jxy = &jxy;
+	orientation.jyy = &jyy;
+	orientation.tx = &rx;
+	orientation.ty = &ry;
+	runInBands(orientation, h);
+
+	tx = rx;
+	ty = ry;
+}
+
+void core::filter::distanceTransform(FloatRaster & out, ByteRaster const & seeds, float sx, float sy)
+{
+	int const w = seeds.width();
+	int const h = seeds.height();
+
+	FloatRaster columns(w,h), result(w,h);
+
+	if (! seeds.isNull())
+	{
+		DistanceColumns first;
+		first.seeds = &seeds;
+		first.out = &columns;
+		first.s2 = sy*sy;
+		runInBands(first, w);
+
+		DistanceRows second;
+		second.in = &columns;
+		second.out = &result;
+		second.s2 = sx*sx;
+		runInBands(second, h);
+	}
+
+	out = result;
+}
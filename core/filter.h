@@ -0,0 +1,93 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_FILTER_H_
+#define CORE_FILTER_H_
+
+#include "core/raster.hh"
+
+
+namespace core
+{
+	//! Image filters on float rasters.
+	/*!
+	 * Filters treat pixels outside the raster as copies of the nearest edge
+	 * pixel. Work is split into bands of rows that run in parallel, and rows
+	 * are processed with SIMD kernels where available.
+	 *
+	 * Input and output rasters may be the same object.
+	 */
+	namespace filter
+	{
+		//! Blurs the raster with a Gaussian kernel.
+		/*!
+		 * \param[out] out blurred raster
+		 * \param[in] in input raster
+		 * \param[in] sigma standard deviation of the kernel, in pixels; no blurring when not positive
+		 */
+		void gaussianBlur(FloatRaster & out, FloatRaster const & in, float sigma);
+
+		//! Computes the gradient of the raster with the Scharr operator.
+		/*!
+		 * Derivatives are per pixel, along the raster's rows and columns.
+		 *
+		 * \param[out] gx derivatives along rows
+		 * \param[out] gy derivatives along columns
+		 * \param[in] in input raster
+		 */
+		void gradient(FloatRaster & gx, FloatRaster & gy, FloatRaster const & in);
+
+		//! Computes the orientation tensor of the gradient.
+		/*!
+		 * The structure tensor of the scaled gradient is averaged with a Gaussian
+		 * window and converted to a math::Tensor whose major eigenvector is
+		 * perpendicular to the dominant gradient direction, with the magnitude of
+		 * the gradient as its value. Without averaging this is the tensor
+		 * Tensor(|g|, atan2(gy,gx) + pi/2).
+		 *
+		 * \param[out] tx first tensor component
+		 * \param[out] ty second tensor component
+		 * \param[in] gx derivatives along rows
+		 * \param[in] gy derivatives along columns
+		 * \param[in] sigma standard deviation of the averaging window, in pixels
+		 * \param[in] scale gradient scale factor
+		 */
+		void orientationTensor(FloatRaster & tx, FloatRaster & ty,
+			FloatRaster const & gx, FloatRaster const & gy, float sigma, float scale);
+
+		//! Computes the Euclidean distance transform of the seed pixels.
+		/*!
+		 * Each pixel gets the distance to the nearest nonzero seed pixel, with
+		 * pixels spaced by sx along rows and sy along columns. Distances are
+		 * exact, computed with the lower envelope of parabolas in two separable
+		 * passes (Felzenszwalb and Huttenlocher), first over columns and then
+		 * over rows.
+		 *
+		 * Pixels are very far away when there are no seeds at all.
+		 *
+		 * \param[out] out distances
+		 * \param[in] seeds seed pixels
+		 * \param[in] sx spacing of columns
+		 * \param[in] sy spacing of rows
+		 */
+		void distanceTransform(FloatRaster & out, ByteRaster const & seeds, float sx = 1, float sy = 1);
+	};
+};
+
+
+#endif // ifndef CORE_FILTER_H_
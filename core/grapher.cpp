@@ -19,13 +19,22 @@
 
 #include "core/grapher.h"
 #include "core/point.h"
+#include "core/edge.h"
+#include "core/parameters.h"
 #include "math/graph.h"
 #include "math/polygon.h"
+#include "math/funcs.h"
+#include "base/profiler.h"
 
 #include <QDebug>
 #include <QTime>
+#include <QVector>
+#include <QSet>
+
+#include <cmath>
 
 using namespace core;
+using math::Vector2f;
 
 
 //! Comparison operator for points.
@@ -43,18 +52,89 @@ bool operator<(Point const & left, Point const & right)
 
 Grapher::Grapher(QObject * parent)
 	: QObject(parent)
+	, m_nextEdgeId(0)
+	, m_faceTracking(false)
+	, m_nextFaceId(0)
+{
+}
+
+
+Grapher::Adjacency::Adjacency(Vertex v_, math::Vector2f const & d_, int edge_, float area_)
+	: v(v_), d(d_)
+	, angle(atan2f(d_(1), d_(0)))
+	, edge(edge_)
+	, area(area_)
+{
+}
+
+
+//! Returns the shoelace term of a straight segment.
+static inline
+float segmentArea(Vector2f const & a, Vector2f const & b)
 {
+	return a(0)*b(1) - b(0)*a(1);
+}
+
+//! Returns the shoelace sum of the polyline running from v1 through trace to v2.
+/*!
+ * Summing these over the edges of a face gives twice the face's signed area,
+ * which is non-zero even for faces bounded by two curved edges.
+ */
+static
+float traceArea(Point const & v1, core::Edge::Trace const & trace, Point const & v2)
+{
+	float area = 0.0f;
+	Vector2f prev = v1.pos();
+
+	foreach (Point const & p, trace)
+	{
+		area += segmentArea(prev, p.pos());
+		prev = p.pos();
+	}
+
+	return area + segmentArea(prev, v2.pos());
 }
 
 
 void Grapher::connect(Vertex v1, Vertex v2)
 {
-	m_vertices[v1].append(Adjacency(v2));
-	m_vertices[v2].append(Adjacency(v1));
+	Vector2f d = v2.pos() - v1.pos();
+	float area = segmentArea(v1.pos(), v2.pos());
+	int edge = m_nextEdgeId++;
+
+	invalidateFaces(v1, v2);
+
+	insertAdjacency(v1, Adjacency(v2,  d, edge,  area));
+	insertAdjacency(v2, Adjacency(v1, -d, edge, -area));
+}
+
+void Grapher::connect(core::Edge const * edge)
+{
+	Vertex v1 = edge->v1();
+	Vertex v2 = edge->v2();
+	core::Edge::Trace trace = edge->trace();
+
+	// the edge leaves its end-points towards the nearest trace samples
+	//
+	Vector2f d1 = (trace.empty() ? v2 : trace.first()).pos() - v1.pos();
+	Vector2f d2 = (trace.empty() ? v1 : trace.last()).pos() - v2.pos();
+
+	if (math::zero(d1.norm()) == 0) d1 = v2.pos() - v1.pos();
+	if (math::zero(d2.norm()) == 0) d2 = v1.pos() - v2.pos();
+
+	float area = traceArea(v1, trace, v2);
+	int id = m_nextEdgeId++;
+
+	invalidateFaces(v1, v2);
+
+	insertAdjacency(v1, Adjacency(v2, d1, id,  area));
+	insertAdjacency(v2, Adjacency(v1, d2, id, -area));
 }
 
 void Grapher::disconnect(Vertex v1, Vertex v2)
 {
+	invalidateFaces(v1, v2);
+
 	AdjacencyList & a1 = m_vertices[v1];
 	for (AdjacencyList::iterator it = a1.begin(); it != a1.end(); )
 	{
@@ -79,6 +159,16 @@ void Grapher::disconnect(Vertex v1, Vertex v2)
 	}
 }
 
+void Grapher::insertAdjacency(Vertex v, Adjacency const & a)
+{
+	AdjacencyList & adjs = m_vertices[v];
+
+	int i = adjs.size();
+	while (i > 0 && a.angle < adjs[i-1].angle) --i;
+
+	adjs.insert(i, a);
+}
+
 
 Grapher::EdgeList Grapher::edges() const
 {
@@ -141,31 +231,249 @@ Grapher::VertexList Grapher::dongles() const
 }
 
 
-//! Implements comparison of loops in street graph.
+//! Half-edge of the planar embedding.
+struct HalfEdge
+{
+	//! Index of the target vertex.
+	int to;
+	//! Angle at which the half-edge leaves its source vertex.
+	float angle;
+	//! Shoelace sum of the edge's trace, walked from the source vertex.
+	float area;
+
+	//! Orders half-edges counter-clockwise around the source vertex.
+	bool operator<(HalfEdge const & other) const
+	{
+		return angle < other.angle;
+	}
+};
+
+//! Returns the root of the specified element in the union-find forest.
+static
+int findRoot(QVector<int> & parents, int i)
+{
+	while (parents[i] != i)
+	{
+		parents[i] = parents[parents[i]];
+		i = parents[i];
+	}
+
+	return i;
+}
+
+Grapher::CycleList Grapher::faces(bool * planar) const
+{
+	QList<Vertex> indices = m_vertices.keys();
+	int const n = indices.size();
+
+	QMap<Vertex,int> lookup;
+	for (int i = 0; i < n; ++i)
+	{
+		lookup.insert(indices[i], i);
+	}
+
+	// half-edges leaving each vertex
+	//
+	QVector< QVector<HalfEdge> > adjs(n);
+	for (VertexMap::const_iterator it = m_vertices.begin(); it != m_vertices.end(); ++it)
+	{
+		int i = lookup.value(it.key());
+
+		foreach (Adjacency const & a, it.value())
+		{
+			if (a.v == it.key()) continue; // ignore loops
+
+			HalfEdge h;
+			h.to = lookup.value(a.v);
+			h.angle = atan2f(a.d(1), a.d(0));
+			h.area = a.area;
+			adjs[i].append(h);
+		}
+	}
+
+	// prune dangling trees, they do not bound any face
+	//
+	QVector<int> degree(n);
+	QVector<bool> pruned(n, false);
+	QList<int> queue;
+	for (int i = 0; i < n; ++i)
+	{
+		degree[i] = adjs[i].size();
+		if (degree[i] <= 1) queue << i;
+	}
+	while (! queue.empty())
+	{
+		int i = queue.takeFirst();
+		if (pruned[i]) continue;
+
+		pruned[i] = true;
+		foreach (HalfEdge const & h, adjs[i])
+		{
+			if (!pruned[h.to] && --degree[h.to] <= 1)
+			{
+				queue << h.to;
+			}
+		}
+	}
+
+	// sort remaining half-edges counter-clockwise and lay them out consecutively
+	//
+	QVector<int> offset(n+1, 0);
+	for (int i = 0; i < n; ++i)
+	{
+		QVector<HalfEdge> kept;
+		if (! pruned[i])
+		{
+			foreach (HalfEdge const & h, adjs[i])
+			{
+				if (! pruned[h.to]) kept.append(h);
+			}
+			qSort(kept.begin(), kept.end());
+		}
+
+		adjs[i] = kept;
+		offset[i+1] = offset[i] + kept.size();
+	}
+
+	// pair each half-edge with its twin
+	//
+	// Parallel edges between the same vertex pair appear in opposite angular
+	// order at the two end-points, so the r-th one counter-clockwise at one
+	// end is paired with the r-th one clockwise at the other.
+	//
+	QVector<int> twin(offset[n], -1);
+	for (int i = 0; i < n; ++i)
+	{
+		for (int k = 0; k < adjs[i].size(); ++k)
+		{
+			int j = adjs[i][k].to;
+
+			int rank = 0, count = 0;
+			for (int q = 0; q < adjs[i].size(); ++q)
+			{
+				if (adjs[i][q].to != j) continue;
+				if (q < k) ++rank;
+				++count;
+			}
+
+			for (int p = adjs[j].size()-1, r = 0; p >= 0; --p)
+			{
+				if (adjs[j][p].to != i) continue;
+				if (r++ == rank)
+				{
+					twin[offset[i]+k] = p;
+					break;
+				}
+			}
+		}
+	}
+
+	// connected components, for the Euler formula check
+	//
+	QVector<int> parents(n);
+	for (int i = 0; i < n; ++i) parents[i] = i;
+	for (int i = 0; i < n; ++i)
+	{
+		foreach (HalfEdge const & h, adjs[i])
+		{
+			parents[findRoot(parents, i)] = findRoot(parents, h.to);
+		}
+	}
+
+	// walk the faces
+	//
+	// Leaving vertex v along the half-edge clockwise-next to the one we arrived
+	// on keeps the face on the left, so bounded faces come out counter-clockwise
+	// (positive area) and outer faces clockwise (negative area).
+	//
+	QVector<bool> visited(offset[n], false);
+	QVector<int> eulerChar(n, 0);
+	CycleList result;
+
+	for (int i = 0; i < n; ++i)
+	{
+		if (pruned[i]) continue;
+
+		// V - E + F, with every edge counted as two halves
+		//
+		eulerChar[findRoot(parents, i)] += 2 - adjs[i].size();
+
+		for (int k = 0; k < adjs[i].size(); ++k)
+		{
+			if (visited[offset[i]+k]) continue;
+
+			Cycle face;
+			float area = 0.0f;
+
+			int u = i, e = k;
+			while (! visited[offset[u]+e])
+			{
+				visited[offset[u]+e] = true;
+
+				int v = adjs[u][e].to;
+				int p = twin[offset[u]+e];
+				if (p < 0) break;
+
+				area += adjs[u][e].area;
+
+				face << indices[u];
+
+				int deg = adjs[v].size();
+				e = (p + deg - 1) % deg;
+				u = v;
+			}
+
+			eulerChar[findRoot(parents, i)] += 2;
+
+			// two curved edges between the same vertex pair bound a face as well
+			//
+			if (area > 0.0f && face.size() >= 2)
+			{
+				result << face;
+			}
+		}
+	}
+
+	if (planar != NULL)
+	{
+		*planar = true;
+
+		for (int i = 0; i < n; ++i)
+		{
+			if (!pruned[i] && findRoot(parents, i) == i && eulerChar[i] != 4)
+			{
+				*planar = false;
+			}
+		}
+	}
+
+	return result;
+}
+
+
+//! Computes weights of loops in street graph.
 /*!
- * Criterion for comparation is are enclosed by the loop.
+ * Weight of the loop is the area enclosed by it.
  */
-struct CompareCycles
+struct CycleArea
 {
-	//! Compares the object
+	//! Constructs the object.
 	/*!
 	 * \param lut vertex lookup table
 	 */
-	CompareCycles(QList<Grapher::Vertex> & lut)
+	CycleArea(QList<Grapher::Vertex> & lut)
 		: m_lut(lut)
 	{}
 
-	//! Less-than comparison function.
-	bool operator()(QList<math::Graph::Vertex> const & left, QList<math::Graph::Vertex> const & right)
+	//! Weight function.
+	float operator()(QList<math::Graph::Vertex> const & cycle) const
 	{
-		QList<core::Point> lp, rp;
-			
-		foreach (math::Graph::Vertex gv, left)
-			lp.append(m_lut[gv-1]);
-		foreach (math::Graph::Vertex gv, right)
-			rp.append(m_lut[gv-1]);
+		QList<core::Point> points;
 
-		return math::Polygon(lp).area() < math::Polygon(rp).area();
+		foreach (math::Graph::Vertex gv, cycle)
+			points.append(m_lut[gv-1]);
+
+		return math::Polygon(points).area();
 	}
 
 private:
@@ -175,11 +483,39 @@ private:
 	
 Grapher::CycleList Grapher::cycles() const
 {
-	// vertex indices
-	QList<Vertex> indices = m_vertices.keys();
+	PROFILE_SPAN("grapher/cycles");
 
 	QTime swatch;
 	swatch.start();
+
+	CycleList result;
+	bool planar = false;
+
+	if (Parameters::instance()->get("grapher/planar", true).toBool())
+	{
+		result = faces(&planar);
+
+		if (! planar)
+		{
+			qWarning() << "graph embedding is not planar, falling back to minimum cycle basis";
+		}
+	}
+
+	if (! planar)
+	{
+		result = minimumCycleBasis();
+	}
+
+	qDebug() << "found" << result.size() << "cycles in" << swatch.elapsed() << "ms";
+
+	return result;
+}
+
+Grapher::CycleList Grapher::minimumCycleBasis() const
+{
+	// vertex indices
+	QList<Vertex> indices = m_vertices.keys();
+
 	int numEdges = 0;
 
 	// construct the graph using vertex indices as vertex identifiers
@@ -210,7 +546,7 @@ Grapher::CycleList Grapher::cycles() const
 	qDebug() << "graph contains" << m_vertices.size() << "vertices and" << numEdges << "edges";
 
 	// obtain the graph's MCB (this could take a while)
-	QList<math::Graph::VertexList> mcb = graph.minimumCycleBasis(CompareCycles(indices));
+	QList<math::Graph::VertexList> mcb = graph.minimumCycleBasis(CycleArea(indices));
 
 	// construct cycle list from the graph's MCB
 	//
@@ -226,7 +562,434 @@ Grapher::CycleList Grapher::cycles() const
 		result.append(cycle);
 	}
 
-	qDebug() << "found" << result.size() << "cycles in" << swatch.elapsed() << "ms";
+	return result;
+}
+
+
+void Grapher::setFaceTracking(bool enabled)
+{
+	m_faces.clear();
+	m_halfEdgeFaces.clear();
+	m_facesAdded.clear();
+	m_facesRemoved.clear();
+	m_facesChanged.clear();
+	m_staleFaces.clear();
+	m_dirtyVertices.clear();
+
+	m_faceTracking = enabled;
+
+	if (! enabled) return;
+
+	QTime swatch;
+	swatch.start();
+
+	// walk all faces once
+	//
+	QSet<int> walked;
+	for (VertexMap::const_iterator it = m_vertices.begin(); it != m_vertices.end(); ++it)
+	{
+		AdjacencyList const & adjs = it.value();
 
+		for (int k = 0; k < adjs.size(); ++k)
+		{
+			if (adjs[k].v == it.key()) continue; // ignore loops
+			if (walked.contains(halfEdgeKey(it.key(), adjs[k]))) continue;
+
+			TrackedFace face;
+			bool bounded = walkFace(it.key(), k, face);
+
+			foreach (int h, face.halfEdges) walked.insert(h);
+
+			if (bounded) addFace(face);
+		}
+	}
+
+	qDebug() << "tracking" << m_faces.size() << "faces, found in" << swatch.elapsed() << "ms";
+}
+
+QList<int> Grapher::faceIds() const
+{
+	return m_faces.keys();
+}
+
+Grapher::Cycle Grapher::face(int id) const
+{
+	return m_faces.value(id).cycle;
+}
+
+void Grapher::takeFaceChanges(QList<int> & added, QList<int> & removed, QList<int> & changed)
+{
+	updateFaces();
+
+	added = m_facesAdded;
+	removed = m_facesRemoved;
+	changed = m_facesChanged;
+
+	m_facesAdded.clear();
+	m_facesRemoved.clear();
+	m_facesChanged.clear();
+}
+
+int Grapher::halfEdgeKey(Vertex const & v, Adjacency const & a)
+{
+	return 2*a.edge + ((v < a.v) ? 0 : 1);
+}
+
+//! Removes dangling trees from a closed walk.
+/*!
+ * Dangling trees show up in the walk as back-and-forth sequences,
+ * i.e. as x,y,x patterns that are reduced to x.
+ */
+static
+QList<Grapher::Vertex> removeSpurs(QList<Grapher::Vertex> const & walk)
+{
+	QList<Grapher::Vertex> result;
+
+	foreach (Grapher::Vertex const & v, walk)
+	{
+		if (result.size() >= 2 && result[result.size()-2] == v)
+		{
+			result.removeLast();
+		}
+		else
+		{
+			result.append(v);
+		}
+	}
+
+	// the walk is closed, reduce the patterns wrapping around its ends
+	//
+	for (bool changed = true; changed && result.size() >= 3; )
+	{
+		int n = result.size();
+		changed = false;
+
+		if (result[n-1] == result[1])
+		{
+			result.removeFirst();
+			result.removeLast();
+			changed = true;
+		}
+		else if (result[n-2] == result[0])
+		{
+			result.removeLast();
+			result.removeLast();
+			changed = true;
+		}
+	}
+
+	return result;
+}
+
+bool Grapher::walkFace(Vertex v, int index, TrackedFace & face) const
+{
+	QList<Vertex> walk;
+	float area = 0.0f;
+
+	face.halfEdges.clear();
+
+	Vertex u = v;
+	int k = index;
+
+	do
+	{
+		AdjacencyList const & adjs = *m_vertices.find(u);
+		Adjacency const & a = adjs[k];
+
+		walk << u;
+		face.halfEdges << halfEdgeKey(u, a);
+
+		area += a.area;
+
+		// find the twin half-edge
+		//
+		AdjacencyList const & next = *m_vertices.find(a.v);
+
+		int p = 0;
+		while (p < next.size() && !(next[p].edge == a.edge && next[p].v == u)) ++p;
+
+		if (p == next.size())
+		{
+			qCritical() << "half-edge twin is missing!";
+			return false;
+		}
+
+		// leave along the clockwise successor of the twin, skipping loops
+		//
+		k = p;
+		do
+		{
+			k = (k + next.size() - 1) % next.size();
+		}
+		while (next[k].v == a.v);
+
+		u = a.v;
+
+		if (walk.size() > 2*m_nextEdgeId + 2)
+		{
+			qCritical() << "face walk does not terminate!";
+			return false;
+		}
+	}
+	while (!(u == v && k == index));
+
+	face.cycle = removeSpurs(walk);
+	face.area = area;
+
+	return area > 0.0f && face.cycle.size() >= 2;
+}
+
+void Grapher::invalidateFaces(Vertex v1, Vertex v2)
+{
+	if (! m_faceTracking) return;
+
+	QList<Vertex> ends;
+	ends << v1;
+	if (!(v2 == v1)) ends << v2;
+
+	foreach (Vertex const & v, ends)
+	{
+		m_dirtyVertices << v;
+
+		VertexMap::const_iterator it = m_vertices.find(v);
+		if (it == m_vertices.end()) continue;
+
+		foreach (Adjacency const & a, it.value())
+		{
+			int id = m_halfEdgeFaces.value(halfEdgeKey(v, a), -1);
+			if (id != -1) m_staleFaces.insert(id);
+		}
+	}
+}
+
+//! Returns keys of half-edges on the face's border, sorted.
+/*!
+ * Half-edges whose twins belong to the same face are dangling and left out.
+ */
+static
+QList<int> borderKeys(QList<int> const & halfEdges)
+{
+	QSet<int> all = halfEdges.toSet();
+	QList<int> result;
+
+	foreach (int h, halfEdges)
+	{
+		if (! all.contains(h ^ 1)) result << h;
+	}
+
+	qSort(result);
 	return result;
 }
+
+//! Returns the number of vertices two faces share, if they list them in the same cyclic order.
+/*!
+ * Vertices inserted into border edges, or removed from them, are not shared
+ * and so do not affect the outcome.
+ *
+ * \return number of shared vertices, or zero if their order differs
+ */
+static
+int sharedOutline(Grapher::Cycle const & c1, Grapher::Cycle const & c2)
+{
+	QSet<Grapher::Vertex> s1 = c1.toSet();
+	QSet<Grapher::Vertex> s2 = c2.toSet();
+
+	Grapher::Cycle r1, r2;
+	foreach (Grapher::Vertex const & v, c1) if (s2.contains(v)) r1 << v;
+	foreach (Grapher::Vertex const & v, c2) if (s1.contains(v)) r2 << v;
+
+	int const n = r1.size();
+	if (n == 0 || r2.size() != n) return 0;
+
+	int shift = r2.indexOf(r1.first());
+	for (int i = 0; i < n; ++i)
+	{
+		if (!(r1[i] == r2[(i + shift) % n])) return 0;
+	}
+
+	return n;
+}
+
+//! Largest relative area difference of a face that keeps its identifier.
+/*!
+ * Dangling trees and vertices inserted into border edges leave the area of a
+ * face as it is, so the tolerance only covers rounding. A face split by a new
+ * edge, or merged with its neighbour, gets a new identifier, as whatever was
+ * built in the old face may lie outside the new one.
+ */
+static float const faceAreaTolerance = 0.001f;
+
+//! A possible match between a walked face and a stale one.
+struct FaceMatch
+{
+	//! Index of the walked face.
+	int found;
+	//! Identifier of the stale face.
+	int stale;
+	//! Number of shared vertices.
+	int shared;
+	//! Relative area difference.
+	float dif;
+
+	//! Orders better matches first.
+	bool operator<(FaceMatch const & other) const
+	{
+		return (shared != other.shared) ? shared > other.shared : dif < other.dif;
+	}
+};
+
+void Grapher::updateFaces()
+{
+	if (m_staleFaces.empty() && m_dirtyVertices.empty()) return;
+
+	QList<int> stale = m_staleFaces.toList();
+	qSort(stale);
+
+	// take out stale faces, they are walked again from their vertices
+	//
+	QList<Vertex> starts = m_dirtyVertices;
+
+	foreach (int id, stale)
+	{
+		TrackedFace const & face = *m_faces.find(id);
+
+		foreach (int h, face.halfEdges)
+		{
+			if (m_halfEdgeFaces.value(h, -1) == id) m_halfEdgeFaces.remove(h);
+		}
+
+		starts += face.cycle;
+	}
+
+	m_staleFaces.clear();
+	m_dirtyVertices.clear();
+
+	// walk them again, skipping half-edges of faces that are still valid
+	//
+	QSet<int> walked;
+	QList<TrackedFace> found;
+
+	foreach (Vertex const & v, starts)
+	{
+		VertexMap::const_iterator it = m_vertices.find(v);
+		if (it == m_vertices.end()) continue;
+
+		AdjacencyList const & adjs = it.value();
+
+		for (int k = 0; k < adjs.size(); ++k)
+		{
+			if (adjs[k].v == v) continue; // ignore loops
+
+			int key = halfEdgeKey(v, adjs[k]);
+			if (walked.contains(key) || m_halfEdgeFaces.contains(key)) continue;
+
+			TrackedFace face;
+			bool bounded = walkFace(v, k, face);
+
+			foreach (int h, face.halfEdges) walked.insert(h);
+
+			if (bounded) found << face;
+		}
+	}
+
+	// a walked face takes over the identifier of a stale face with the same outline,
+	// i.e. one sharing at least three vertices in the same order (two for two-edge
+	// faces) and enclosing the same area; faces sharing the most vertices go first
+	//
+	QList<FaceMatch> matches;
+
+	for (int i = 0; i < found.size(); ++i)
+	{
+		TrackedFace const & face = found[i];
+
+		foreach (int id, stale)
+		{
+			TrackedFace const & old = *m_faces.find(id);
+
+			FaceMatch m;
+			m.found = i;
+			m.stale = id;
+			m.dif = qAbs(face.area - old.area) / qMax(face.area, old.area);
+			if (m.dif > faceAreaTolerance) continue;
+
+			m.shared = sharedOutline(face.cycle, old.cycle);
+			if (m.shared < qMin(3, qMin(face.cycle.size(), old.cycle.size()))) continue;
+
+			matches << m;
+		}
+	}
+
+	qSort(matches);
+
+	QVector<int> assigned(found.size(), -1);
+	foreach (FaceMatch const & m, matches)
+	{
+		if (assigned[m.found] == -1 && stale.contains(m.stale))
+		{
+			assigned[m.found] = m.stale;
+			stale.removeOne(m.stale);
+		}
+	}
+
+	for (int i = 0; i < found.size(); ++i)
+	{
+		TrackedFace const & face = found[i];
+		int match = assigned[i];
+
+		if (match == -1)
+		{
+			addFace(face);
+			continue;
+		}
+
+		TrackedFace & old = *m_faces.find(match);
+		bool changed = borderKeys(face.halfEdges) != borderKeys(old.halfEdges);
+
+		old = face;
+		foreach (int h, face.halfEdges) m_halfEdgeFaces.insert(h, match);
+
+		if (changed && !m_facesAdded.contains(match) && !m_facesChanged.contains(match))
+		{
+			m_facesChanged << match;
+		}
+	}
+
+	// faces that are gone
+	//
+	foreach (int id, stale)
+	{
+		removeFace(id);
+	}
+}
+
+void Grapher::addFace(TrackedFace const & face)
+{
+	int id = m_nextFaceId++;
+
+	m_faces.insert(id, face);
+	m_facesAdded << id;
+
+	foreach (int h, face.halfEdges)
+	{
+		m_halfEdgeFaces.insert(h, id);
+	}
+}
+
+void Grapher::removeFace(int id)
+{
+	TrackedFace face = m_faces.take(id);
+	m_staleFaces.remove(id);
+	m_facesChanged.removeOne(id);
+
+	foreach (int h, face.halfEdges)
+	{
+		if (m_halfEdgeFaces.value(h, -1) == id) m_halfEdgeFaces.remove(h);
+	}
+
+	// a face that has not been reported yet needs not be reported at all
+	//
+	if (! m_facesAdded.removeOne(id))
+	{
+		m_facesRemoved << id;
+	}
+}
@@ -22,11 +22,15 @@
 #include "core/grapher.hh"
 #include "core/tracer.hh"
 #include "core/point.h"
+#include "core/edge.hh"
+#include "math/vector2f.h"
 
 #include <QObject>
 #include <QPair>
 #include <QList>
 #include <QMap>
+#include <QHash>
+#include <QSet>
 
 
 //! Encapsulates road-network's connectivity information.
@@ -61,6 +65,16 @@ public:
 	 */
 	void connect(Vertex v1, Vertex v2);
 
+	//! Establishes a connection for the specified road-network edge.
+	/*!
+	 * Unlike connect(Vertex,Vertex), this records the directions in which
+	 * the edge's trace line leaves its end-points, which is what the planar
+	 * face traversal uses for ordering edges around a vertex.
+	 *
+	 * \param edge edge to connect
+	 */
+	void connect(core::Edge const * edge);
+
 	//! Removes a connection between the specified vertex pair.
 	/*!
 	 * \param v1 first vertex
@@ -87,17 +101,90 @@ public:
 	VertexList dongles() const;
 
 	//! Returns a list of cycles present in the graph.
+	/*!
+	 * Cycles are the bounded faces of the planar embedding, found by faces().
+	 * If the embedding turns out not to be planar, or the "grapher/planar"
+	 * parameter is switched off, the Minimum Cycle Basis is used instead.
+	 */
 	CycleList cycles() const;
 
+	//! Returns the bounded faces of the graph's planar embedding.
+	/*!
+	 * Half-edges are sorted by angle around each vertex and faces are
+	 * walked in counter-clockwise order, which takes O(E log E) time.
+	 * Dangling trees are pruned beforehand and outer faces are dropped.
+	 *
+	 * \param[out] planar if not NULL, receives whether the embedding satisfies the Euler formula
+	 * \return list of faces, each one given as a counter-clockwise cycle of vertices
+	 */
+	CycleList faces(bool * planar = NULL) const;
+
+	//! Returns the Minimum Cycle Basis of the graph.
+	/*!
+	 * This does not need a planar embedding but is considerably slower than faces().
+	 */
+	CycleList minimumCycleBasis() const;
+
+//! \name Incremental face maintenance.
+//@{
+	//! Turns incremental face maintenance on or off.
+	/*!
+	 * When turned on, bounded faces of the planar embedding are found and then kept
+	 * up to date. connect() and disconnect() only mark faces passing through the end-points
+	 * of a modified edge as stale, and takeFaceChanges() walks them again, so an update
+	 * takes time proportional to the size of faces touched rather than to the size of the graph.
+	 *
+	 * A walked face keeps the identifier of the stale face it replaces if both list their
+	 * shared vertices in the same cyclic order and enclose the same area. Hence
+	 * splitting a border edge, adding a dangling edge or re-adding a border edge modifies
+	 * the face instead of replacing it, while an edge across the face, or the removal of
+	 * an edge between two faces, replaces the faces involved.
+	 *
+	 * All faces found when tracking is turned on are reported as added by takeFaceChanges().
+	 */
+	void setFaceTracking(bool enabled);
+
+	//! Returns whether faces are maintained incrementally.
+	bool faceTracking() const { return m_faceTracking; }
+
+	//! Returns the identifiers of faces currently maintained.
+	QList<int> faceIds() const;
+
+	//! Returns the face with the specified identifier.
+	/*!
+	 * \return counter-clockwise cycle of vertices, or an empty cycle if no such face exists
+	 */
+	Cycle face(int id) const;
+
+	//! Brings faces up to date, then returns and clears changes accumulated since the last call.
+	/*!
+	 * A face that has been both added and removed in the meantime is not reported.
+	 * A face that has been added is not reported as changed.
+	 *
+	 * \param[out] added identifiers of faces that have been added
+	 * \param[out] removed identifiers of faces that have been removed
+	 * \param[out] changed identifiers of faces whose border has changed
+	 */
+	void takeFaceChanges(QList<int> & added, QList<int> & removed, QList<int> & changed);
+//@}
+
 private:
 	//! Encodes vertex adjacency.
 	struct Adjacency
 	{
 		//! Adjacent vertex.
 		Vertex v;
+		//! Direction in which the edge leaves the vertex.
+		math::Vector2f d;
+		//! Angle of the direction, adjacency lists are sorted by it.
+		float angle;
+		//! Edge identifier, shared by both end-points' adjacencies.
+		int edge;
+		//! Twice the signed area under the edge's trace, walked from the vertex to v.
+		float area;
 
 		//! Constructs the object.
-		Adjacency(Vertex v_) : v(v_) {}
+		Adjacency(Vertex v_, math::Vector2f const & d_, int edge_, float area_);
 	};
 
 	//! List of adjacencies.
@@ -105,8 +192,69 @@ private:
 	//! Adjacencies keyed by vertex.
 	typedef QMap<Vertex, AdjacencyList> VertexMap;
 
+	//! A face maintained by incremental face tracking.
+	struct TrackedFace
+	{
+		//! Face vertices.
+		Cycle cycle;
+		//! Keys of half-edges walked around the face.
+		QList<int> halfEdges;
+		//! Twice the enclosed area.
+		float area;
+	};
+
 	//! Graph's vertices.
 	VertexMap m_vertices;
+	//! Identifier to be assigned to the next edge.
+	int m_nextEdgeId;
+
+	//! Flag indicating whether faces are maintained incrementally.
+	bool m_faceTracking;
+	//! Identifier to be assigned to the next face.
+	int m_nextFaceId;
+	//! Maintained faces.
+	QMap<int, TrackedFace> m_faces;
+	//! Maps half-edge keys to faces containing them.
+	QHash<int, int> m_halfEdgeFaces;
+	//! Faces added since the last takeFaceChanges() call.
+	QList<int> m_facesAdded;
+	//! Faces removed since the last takeFaceChanges() call.
+	QList<int> m_facesRemoved;
+	//! Faces modified since the last takeFaceChanges() call.
+	QList<int> m_facesChanged;
+	//! Faces to be walked again.
+	QSet<int> m_staleFaces;
+	//! End-points of edges modified since faces were last walked.
+	QList<Vertex> m_dirtyVertices;
+
+	//! Inserts an adjacency keeping the list sorted by angle.
+	void insertAdjacency(Vertex v, Adjacency const & a);
+
+	//! Returns the key of the half-edge leaving the vertex along the specified adjacency.
+	static int halfEdgeKey(Vertex const & v, Adjacency const & a);
+
+	//! Walks the face left of the specified half-edge.
+	/*!
+	 * \param v source vertex of the half-edge
+	 * \param index index of the half-edge in the source vertex's adjacency list
+	 * \param[out] face the walked face, with dangling trees removed
+	 * \return true if the face is bounded
+	 */
+	bool walkFace(Vertex v, int index, TrackedFace & face) const;
+
+	//! Marks faces passing through the specified vertices as stale.
+	/*!
+	 * Must be called before the edge between the vertices is modified.
+	 */
+	void invalidateFaces(Vertex v1, Vertex v2);
+
+	//! Walks the stale faces again and matches them with the walked ones.
+	void updateFaces();
+
+	//! Adds the specified face to maintained faces.
+	void addFace(TrackedFace const & face);
+	//! Removes the specified face from maintained faces.
+	void removeFace(int id);
 };
 
 
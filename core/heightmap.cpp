@@ -0,0 +1,551 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/heightmap.h"
+
+#include <QFileInfo>
+#include <QMutexLocker>
+#include <QtEndian>
+#include <QDebug>
+
+#include <qnumeric.h>
+
+#include <cctype>
+#include <cmath>
+#include <cstring>
+
+using namespace core;
+
+
+//! Reads the next whitespace-separated token of a PNM header.
+/*!
+ * Comments, from '#' to the end of line, are skipped.
+ *
+ * \param header header bytes
+ * \param pos position to start from, moved past the token
+ * \param[out] token the token
+ * \retval false end of header reached
+ */
+static
+bool readToken(QByteArray const & header, int & pos, QByteArray & token)
+{
+	token.clear();
+
+	while (pos < header.size())
+	{
+		char c = header[pos];
+
+		if (c == '#')
+		{
+			while (pos < header.size() && header[pos] != '\n') ++pos;
+		}
+		else if (isspace(c))
+		{
+			++pos;
+		}
+		else
+		{
+			break;
+		}
+	}
+
+	while (pos < header.size() && !isspace(header[pos]))
+	{
+		token.append(header[pos++]);
+	}
+
+	return !token.isEmpty();
+}
+
+//! Returns the size of a sample in the specified format, in bytes.
+static
+int sampleSize(HeightMap::SampleFormat format)
+{
+	switch (format)
+	{
+	case HeightMap::UInt8:     return 1;
+	case HeightMap::UInt16BE:
+	case HeightMap::UInt16LE:  return 2;
+	case HeightMap::Float32BE:
+	case HeightMap::Float32LE: return 4;
+	}
+	return 1;
+}
+
+//! Returns the cache key of a tile.
+static inline
+qint64 tileKey(int level, int tx, int ty)
+{
+	return (qint64(level) << 48) | (qint64(ty) << 24) | qint64(tx);
+}
+
+//! Halves the raster by averaging 2x2 blocks, an odd edge is repeated.
+static
+FloatRaster reduce(FloatRaster const & in)
+{
+	int const w = (in.width() + 1) / 2;
+	int const h = (in.height() + 1) / 2;
+
+	FloatRaster out(w, h);
+
+	for (int y = 0; y < h; ++y)
+	{
+		float const * l0 = in.constScanLine(2*y);
+		float const * l1 = in.constScanLine(qMin(2*y + 1, in.height() - 1));
+		float * line = out.scanLine(y);
+
+		for (int x = 0; x < w; ++x)
+		{
+			int x0 = 2*x;
+			int x1 = qMin(2*x + 1, in.width() - 1);
+
+			line[x] = 0.25f * (l0[x0] + l0[x1] + l1[x0] + l1[x1]);
+		}
+	}
+
+	return out;
+}
+
+
+HeightMap::HeightMap()
+	: m_samples(NULL)
+	, m_format(UInt8)
+	, m_bottomUp(false)
+	, m_offset(0)
+	, m_scale(1)
+	, m_tiles(cacheSize)
+{
+}
+
+HeightMap::~HeightMap()
+{
+	close();
+}
+
+bool HeightMap::isHeightMapFile(QString const & path)
+{
+	QString suffix = QFileInfo(path).suffix().toLower();
+
+	return suffix == "pgm" || suffix == "pfm" || suffix == "r16" || suffix == "r32" || suffix == "f32";
+}
+
+bool HeightMap::open(QString const & path)
+{
+	close();
+
+	QString suffix = QFileInfo(path).suffix().toLower();
+
+	if (suffix == "r16" || suffix == "r32" || suffix == "f32")
+	{
+		SampleFormat format = (suffix == "r16") ? UInt16LE : Float32LE;
+		qint64 samples = QFileInfo(path).size() / sampleSize(format);
+		int side = int(sqrt(double(samples)) + 0.5);
+
+		if (qint64(side)*side != samples)
+		{
+			qWarning() << "raw heightmap" << path << "is not square";
+			return false;
+		}
+
+		return openRaw(path, side, side, format);
+	}
+
+	QFile file(path);
+	if (! file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "cannot open heightmap" << path;
+		return false;
+	}
+
+	QByteArray header = file.read(1024);
+	file.close();
+
+	QByteArray magic, width, height, maxval;
+	int pos = 0;
+
+	readToken(header, pos, magic);
+	readToken(header, pos, width);
+	readToken(header, pos, height);
+
+	if (! readToken(header, pos, maxval) || pos >= header.size())
+	{
+		qWarning() << "cannot read heightmap header" << path;
+		return false;
+	}
+
+	// a single whitespace separates the header from the samples
+	qint64 offset = pos + 1;
+
+	if (magic == "P5")
+	{
+		int maxValue = maxval.toInt();
+		if (maxValue <= 0 || maxValue > 65535) return false;
+
+		if (! openRaw(path, width.toInt(), height.toInt(), (maxValue < 256) ? UInt8 : UInt16BE, offset))
+		{
+			return false;
+		}
+
+		m_offset = 0;
+		m_scale = 1.0f / maxValue;
+		return true;
+	}
+	else if (magic == "Pf")
+	{
+		// negative scale marks little-endian samples
+		float scale = maxval.toFloat();
+
+		if (! openRaw(path, width.toInt(), height.toInt(), (scale < 0) ? Float32LE : Float32BE, offset))
+		{
+			return false;
+		}
+
+		m_bottomUp = true;
+		return true;
+	}
+
+	qWarning() << "unsupported heightmap format" << path;
+	return false;
+}
+
+bool HeightMap::openRaw(QString const & path, int width, int height, SampleFormat format, qint64 offset)
+{
+	close();
+
+	if (width <= 0 || height <= 0)
+	{
+		qWarning() << "invalid heightmap size" << width << height;
+		return false;
+	}
+
+	m_file.setFileName(path);
+	if (! m_file.open(QIODevice::ReadOnly))
+	{
+		qWarning() << "cannot open heightmap" << path;
+		return false;
+	}
+
+	qint64 length = qint64(width) * height * sampleSize(format);
+	if (offset + length > m_file.size())
+	{
+		qWarning() << "heightmap" << path << "is truncated";
+		m_file.close();
+		return false;
+	}
+
+	m_samples = m_file.map(offset, length);
+	if (m_samples == NULL)
+	{
+		qWarning() << "cannot map heightmap" << path;
+		m_file.close();
+		return false;
+	}
+
+	m_format = format;
+	m_bottomUp = false;
+
+	// pyramid levels, down to one tile
+	//
+	QSize size(width, height);
+	m_sizes.append(size);
+
+	while (size.width() > tileSize || size.height() > tileSize)
+	{
+		size = QSize((size.width() + 1) / 2, (size.height() + 1) / 2);
+		m_sizes.append(size);
+	}
+
+	// sample range
+	//
+	m_offset = 0;
+	m_scale = 1;
+
+	switch (format)
+	{
+	case UInt8:
+		m_scale = 1.0f / 255;
+		break;
+
+	case UInt16BE:
+	case UInt16LE:
+		m_scale = 1.0f / 65535;
+		break;
+
+	case Float32BE:
+	case Float32LE:
+		{
+			// float heights have no natural range, one pass over the file finds it,
+			// skipping no-data samples
+			//
+			float lo = 0, hi = 0;
+			bool found = false;
+
+			for (int y = 0; y < height; ++y)
+			{
+				for (int x = 0; x < width; ++x)
+				{
+					float v = sample(x,y);
+					if (! qIsFinite(v)) continue;
+
+					lo = found ? qMin(lo, v) : v;
+					hi = found ? qMax(hi, v) : v;
+					found = true;
+				}
+			}
+
+			m_offset = lo;
+			m_scale = (hi > lo) ? 1.0f / (hi - lo) : 1.0f;
+		}
+		break;
+	}
+
+	return true;
+}
+
+void HeightMap::close()
+{
+	{
+		QMutexLocker locker(&m_mutex);
+		m_tiles.clear();
+	}
+
+	m_sizes.clear();
+
+	if (m_samples != NULL)
+	{
+		m_file.unmap(const_cast<uchar *>(m_samples));
+		m_samples = NULL;
+	}
+
+	if (m_file.isOpen())
+	{
+		m_file.close();
+	}
+}
+
+float HeightMap::sample(int x, int y) const
+{
+	int const w = m_sizes[0].width();
+	int const h = m_sizes[0].height();
+
+	int row = m_bottomUp ? (h-1 - y) : y;
+	uchar const * p = m_samples + (qint64(row)*w + x) * sampleSize(m_format);
+
+	quint32 bits;
+	float f;
+
+	switch (m_format)
+	{
+	case UInt8:
+		return p[0];
+
+	case UInt16BE:
+		return qFromBigEndian<quint16>(p);
+
+	case UInt16LE:
+		return qFromLittleEndian<quint16>(p);
+
+	case Float32BE:
+		bits = qFromBigEndian<quint32>(p);
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+
+	case Float32LE:
+		bits = qFromLittleEndian<quint32>(p);
+		memcpy(&f, &bits, sizeof(f));
+		return f;
+	}
+
+	return 0;
+}
+
+FloatRaster HeightMap::tile(int level, int tx, int ty) const
+{
+	if (level < 0 || level >= levels()) return FloatRaster();
+
+	// the mapped file is the cache of level 0
+	//
+	if (level == 0)
+	{
+		return decodeTile(tx, ty);
+	}
+
+	qint64 key = tileKey(level, tx, ty);
+
+	{
+		QMutexLocker locker(&m_mutex);
+
+		FloatRaster const * cached = m_tiles.object(key);
+		if (cached != NULL) return *cached;
+	}
+
+	// tiles are reduced outside the lock, as reducing requests finer tiles
+	//
+	FloatRaster result = reduceTile(level, tx, ty);
+
+	{
+		QMutexLocker locker(&m_mutex);
+
+		m_tiles.insert(key, new FloatRaster(result), qMax(result.width() * result.height(), 1));
+	}
+
+	return result;
+}
+
+FloatRaster HeightMap::decodeTile(int tx, int ty) const
+{
+	int x0 = tx * tileSize, y0 = ty * tileSize;
+	int tw = qMin(tileSize, width() - x0);
+	int th = qMin(tileSize, height() - y0);
+
+	if (tw <= 0 || th <= 0) return FloatRaster();
+
+	FloatRaster result(tw, th);
+
+	for (int y = 0; y < th; ++y)
+	{
+		float * line = result.scanLine(y);
+
+		for (int x = 0; x < tw; ++x)
+		{
+			float v = sample(x0 + x, y0 + y);
+
+			// no-data samples would spread to every coarser level
+			line[x] = qIsFinite(v) ? (v - m_offset) * m_scale : 0.0f;
+		}
+	}
+
+	return result;
+}
+
+FloatRaster HeightMap::reduceTile(int level, int tx, int ty) const
+{
+	int x0 = tx * tileSize, y0 = ty * tileSize;
+	int tw = qMin(tileSize, width(level) - x0);
+	int th = qMin(tileSize, height(level) - y0);
+
+	if (tw <= 0 || th <= 0) return FloatRaster();
+
+	// the tile covers up to four tiles of the previous level
+	//
+	int const sw = width(level-1);
+	int const sh = height(level-1);
+
+	FloatRaster src[2][2];
+	for (int j = 0; j < 2; ++j)
+	{
+		for (int i = 0; i < 2; ++i)
+		{
+			if ((2*tx + i) * tileSize < sw && (2*ty + j) * tileSize < sh)
+			{
+				src[j][i] = tile(level-1, 2*tx + i, 2*ty + j);
+			}
+		}
+	}
+
+	FloatRaster result(tw, th);
+
+	for (int y = 0; y < th; ++y)
+	{
+		float * line = result.scanLine(y);
+
+		for (int x = 0; x < tw; ++x)
+		{
+			float sum = 0;
+
+			for (int k = 0; k < 4; ++k)
+			{
+				// samples beyond an odd edge repeat the edge sample
+				int sx = qMin(2*(x0 + x) + (k & 1), sw-1) - 2*x0;
+				int sy = qMin(2*(y0 + y) + (k >> 1), sh-1) - 2*y0;
+
+				sum += src[sy / tileSize][sx / tileSize].value(sx % tileSize, sy % tileSize);
+			}
+
+			line[x] = 0.25f * sum;
+		}
+	}
+
+	return result;
+}
+
+int HeightMap::levelForSize(int maxSize) const
+{
+	for (int level = 0; level < levels(); ++level)
+	{
+		if (width(level) <= maxSize && height(level) <= maxSize)
+		{
+			return level;
+		}
+	}
+
+	return levels() - 1;
+}
+
+FloatRaster HeightMap::toRaster(int level) const
+{
+	if (level < 0 || level >= levels()) return FloatRaster();
+
+	int const w = width(level);
+	int const h = height(level);
+
+	FloatRaster result(w, h);
+
+	for (int ty = 0; ty * tileSize < h; ++ty)
+	{
+		for (int tx = 0; tx * tileSize < w; ++tx)
+		{
+			FloatRaster t = tile(level, tx, ty);
+
+			for (int y = 0; y < t.height(); ++y)
+			{
+				memcpy(result.scanLine(ty*tileSize + y) + tx*tileSize, t.constScanLine(y), t.width() * sizeof(float));
+			}
+		}
+	}
+
+	return result;
+}
+
+QImage HeightMap::toImage(FloatRaster const & heights, int maxSize)
+{
+	if (heights.isNull()) return QImage();
+
+	FloatRaster raster = heights;
+	while (raster.width() > qMax(maxSize, 1) || raster.height() > qMax(maxSize, 1))
+	{
+		raster = reduce(raster);
+	}
+
+	QImage image(raster.width(), raster.height(), QImage::Format_RGB32);
+
+	for (int y = 0; y < raster.height(); ++y)
+	{
+		QRgb * line = reinterpret_cast<QRgb *>(image.scanLine(y));
+		float const * values = raster.constScanLine(y);
+
+		for (int x = 0; x < raster.width(); ++x)
+		{
+			int v = qBound(0, int(values[x] * 255 + 0.5f), 255);
+			line[x] = qRgb(v,v,v);
+		}
+	}
+
+	return image;
+}
@@ -0,0 +1,177 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_HEIGHTMAP_H_
+#define CORE_HEIGHTMAP_H_
+
+#include "core/heightmap.hh"
+#include "core/raster.h"
+
+#include <QFile>
+#include <QCache>
+#include <QMutex>
+#include <QImage>
+
+
+//! Loader of high-precision heightmaps from memory-mapped files.
+/*!
+ * The file is mapped, not read, and heights are decoded in square tiles of a
+ * mip pyramid. Level 0 is the full resolution, and each following level halves
+ * the size of the previous one by averaging, down to the level that fits in a
+ * single tile.
+ *
+ * Tiles of level 0 are decoded from the mapped file on each request and never
+ * held, so a large file is reduced to a level without the full-resolution
+ * heights ever being in memory. Tiles of the coarser levels are cached, up to
+ * cacheSize samples, so a level and the levels above it are computed once.
+ *
+ * Supported files are binary PGM (8 or 16 bits per sample), PFM (grayscale
+ * float) and headerless raw files. Raw files with suffix ".r16" (16-bit
+ * little-endian) and ".r32" or ".f32" (32-bit float little-endian) are taken
+ * to be square. Other raw layouts can be opened with openRaw().
+ *
+ * Heights are normalized to range [0,1]: integer samples by their maximum
+ * value, float samples by the range of finite values found in the file.
+ * Non-finite float samples, used for missing data, are taken as the lowest
+ * height.
+ */
+class core::HeightMap
+{
+public:
+	//! Sample format of the file.
+	enum SampleFormat
+	{
+		UInt8,
+		UInt16BE,
+		UInt16LE,
+		Float32BE,
+		Float32LE
+	};
+
+	//! Width and height of a tile, in samples.
+	static int const tileSize = 256;
+	//! Maximum number of samples held in cached tiles.
+	static int const cacheSize = 4 << 20;
+
+//! \name Object construction.
+//@{
+	//! Constructs a null heightmap.
+	HeightMap();
+
+	~HeightMap();
+//@}
+
+	//! Tests whether the file at the specified path is a known heightmap format.
+	/*!
+	 * Files are recognized by their suffix.
+	 */
+	static bool isHeightMapFile(QString const & path);
+
+	//! Opens a PGM, PFM or raw heightmap file.
+	/*!
+	 * \retval true the file was opened and mapped
+	 * \retval false the file could not be opened or its format is not recognized
+	 */
+	bool open(QString const & path);
+
+	//! Opens a headerless raw heightmap file.
+	/*!
+	 * \param path path to the file
+	 * \param width number of samples in a row
+	 * \param height number of rows
+	 * \param format sample format
+	 * \param offset offset of the first sample in the file, in bytes
+	 */
+	bool openRaw(QString const & path, int width, int height, SampleFormat format, qint64 offset = 0);
+
+	//! Unmaps the file and drops all cached tiles.
+	void close();
+
+	//! Tests whether no file is open.
+	bool isNull() const { return m_samples == NULL; }
+
+//! \name Mip pyramid.
+//@{
+	//! Returns the number of levels.
+	int levels() const { return m_sizes.size(); }
+	//! Returns the number of columns at the specified level.
+	int width(int level = 0) const { return m_sizes.value(level).width(); }
+	//! Returns the number of rows at the specified level.
+	int height(int level = 0) const { return m_sizes.value(level).height(); }
+
+	//! Returns the specified tile.
+	/*!
+	 * Edge tiles are smaller than tileSize. Tiles of level 0 are decoded on
+	 * each request, tiles of coarser levels on first request.
+	 *
+	 * \param level pyramid level
+	 * \param tx tile column
+	 * \param ty tile row
+	 */
+	FloatRaster tile(int level, int tx, int ty) const;
+
+	//! Returns the finest level with neither dimension larger than the specified size.
+	int levelForSize(int maxSize) const;
+
+	//! Returns the whole level as one raster.
+	FloatRaster toRaster(int level) const;
+//@}
+
+	//! Returns an 8-bit grayscale image of the specified heights.
+	/*!
+	 * The heights are halved by averaging until neither dimension is larger
+	 * than maxSize.
+	 */
+	static QImage toImage(FloatRaster const & heights, int maxSize);
+
+private:
+	//! The mapped file.
+	QFile m_file;
+	//! First sample in the mapped file.
+	uchar const * m_samples;
+	//! Sample format.
+	SampleFormat m_format;
+	//! Whether rows are stored bottom to top.
+	bool m_bottomUp;
+	//! Height of the lowest sample value.
+	float m_offset;
+	//! Scale of sample values.
+	float m_scale;
+	//! Level sizes.
+	QVector<QSize> m_sizes;
+
+	//! Tiles of coarser levels, keyed by level and tile coordinates.
+	mutable QCache<qint64, FloatRaster> m_tiles;
+	//! Guards m_tiles.
+	mutable QMutex m_mutex;
+
+	//! Returns the height of the specified sample in the file.
+	float sample(int x, int y) const;
+	//! Decodes a tile of level 0 from the file.
+	FloatRaster decodeTile(int tx, int ty) const;
+	//! Computes a tile by averaging tiles of the previous level.
+	FloatRaster reduceTile(int level, int tx, int ty) const;
+
+	//! Non-copyable.
+	HeightMap(HeightMap const &);
+	//! Non-copyable.
+	HeightMap & operator=(HeightMap const &);
+};
+
+
+#endif // ifndef CORE_HEIGHTMAP_H_
@@ -20,6 +20,8 @@
 #include "core/mapimage.h"
 #include "math/vector2f.h"
 
+#include <QColor>
+
 #include <cmath>
 
 using namespace core;
@@ -33,11 +35,58 @@ MapImage::MapImage()
 MapImage::MapImage(const char * path)
 	: QImage(path)
 {
+	decode();
 }
 
 MapImage::MapImage(QImage const & image)
 	: QImage(image)
 {
+	decode();
+}
+
+void MapImage::decode()
+{
+	if (isNull())
+	{
+		m_values = FloatRaster();
+		m_hues = FloatRaster();
+		return;
+	}
+
+	int const w = width();
+	int const h = height();
+
+	m_values = FloatRaster(w,h);
+	m_hues = FloatRaster(w,h);
+
+	QImage argb = convertToFormat(QImage::Format_ARGB32);
+
+	// map images use few colours, so the last one is remembered
+	//
+	QRgb lastRgb = 0;
+	float lastValue = 0;
+	float lastHue = -1;
+
+	for (int y = 0; y < h; ++y)
+	{
+		QRgb const * line = reinterpret_cast<QRgb const *>(argb.constScanLine(y));
+		float * values = m_values.scanLine(y);
+		float * hues = m_hues.scanLine(y);
+
+		for (int x = 0; x < w; ++x)
+		{
+			if (line[x] != lastRgb)
+			{
+				QColor c = QColor::fromRgba(line[x]);
+				lastRgb = line[x];
+				lastValue = c.valueF();
+				lastHue = c.hue();
+			}
+
+			values[x] = lastValue;
+			hues[x] = lastHue;
+		}
+	}
 }
 
 QPointF MapImage::toImageCoords(math::Vector2f const & fieldCoords) const
@@ -20,6 +20,7 @@
 #define CORE_MAPIMAGE_H_
 
 #include "core/mapimage.hh"
+#include "core/raster.h"
 #include "math/vector2f.hh"
 
 #include <QImage>
@@ -29,6 +30,10 @@
 //! Encapsulation of input map image.
 /*!
  * Map images are used for loading natural boundary maps and heightmaps.
+ *
+ * Pixels are decoded into rasters once, when the image is constructed, so
+ * fields and tracers can sample them without going through QColor. Painting
+ * on the image afterwards does not update the rasters.
  */
 class core::MapImage : public QImage
 {
@@ -53,6 +58,24 @@ public:
 	//! Converts image coordinates to field coordinates.
 	math::Vector2f toFieldCoords(QPointF const & imageCoords) const;
 //@}
+
+//! \name Decoded pixels.
+//@{
+	//! Returns pixel values (the V component of HSV), in range [0,1].
+	FloatRaster const & values() const { return m_values; }
+
+	//! Returns pixel hues, in degrees, or -1 for achromatic pixels.
+	FloatRaster const & hues() const { return m_hues; }
+//@}
+
+private:
+	//! Pixel values.
+	FloatRaster m_values;
+	//! Pixel hues.
+	FloatRaster m_hues;
+
+	//! Decodes pixels into the rasters.
+	void decode();
 };
 
 
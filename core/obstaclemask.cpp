@@ -0,0 +1,137 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/obstaclemask.h"
+#include "core/mapimage.h"
+#include "core/filter.h"
+
+#include <QtGlobal>
+
+
+using namespace core;
+
+
+ObstacleMask::ObstacleMask(MapImage const & image)
+	: m_bits(qMax(image.height(), 1), qMax(image.width(), 1), false)
+	, m_scaleX(qMax(image.width() - 1, 0))
+	, m_scaleY(qMax(image.height() - 1, 0))
+{
+	FloatRaster const & hues = image.hues();
+
+	int const w = hues.width();
+	int const h = hues.height();
+
+	ByteRaster seeds(w,h);
+
+	for (int y = 0; y < h; ++y)
+	{
+		float const * line = hues.constScanLine(y);
+		unsigned char * seedLine = seeds.scanLine(y);
+
+		for (int x = 0; x < w; ++x)
+		{
+			if (line[x] > 0)
+			{
+				m_bits.set(y, x, true);
+				seedLine[x] = 1;
+			}
+		}
+	}
+
+	if (w > 1 && h > 1)
+	{
+		filter::distanceTransform(m_distance, seeds, 1.0f / (w-1), 1.0f / (h-1));
+	}
+}
+
+inline
+bool ObstacleMask::test(float x, float y) const
+{
+	// same clamping and rounding as MapImage::toImageCoords()
+	//
+	int col = int(qBound(0.0f, x, 1.0f) * m_scaleX + 0.5f);
+	int row = int(m_scaleY - qBound(0.0f, y, 1.0f) * m_scaleY + 0.5f);
+
+	return m_bits.get(row, col);
+}
+
+inline
+bool ObstacleMask::testSpan(int row, int col0, int col1) const
+{
+	int col = m_bits.firstSetBit(row, col0);
+
+	return col >= 0 && col <= col1;
+}
+
+bool ObstacleMask::contains(math::Vector2f const & p) const
+{
+	return test(p(0), p(1));
+}
+
+bool ObstacleMask::intersects(math::Vector2f const & a, math::Vector2f const & b) const
+{
+	// continuous image coordinates, rounded as in test()
+	//
+	float ax = qBound(0.0f, a(0), 1.0f) * m_scaleX;
+	float ay = m_scaleY - qBound(0.0f, a(1), 1.0f) * m_scaleY;
+	float bx = qBound(0.0f, b(0), 1.0f) * m_scaleX;
+	float by = m_scaleY - qBound(0.0f, b(1), 1.0f) * m_scaleY;
+
+	int row0 = int(qMin(ay, by) + 0.5f);
+	int row1 = int(qMax(ay, by) + 0.5f);
+
+	for (int row = row0; row <= row1; ++row)
+	{
+		float x0 = qMin(ax, bx);
+		float x1 = qMax(ax, bx);
+
+		if (ay != by)
+		{
+			// part of the segment nearest to this row
+			//
+			float t0 = (row - 0.5f - ay) / (by - ay);
+			float t1 = (row + 0.5f - ay) / (by - ay);
+
+			if (t0 > t1) qSwap(t0, t1);
+
+			t0 = qMax(t0, 0.0f);
+			t1 = qMin(t1, 1.0f);
+
+			x0 = qMin(ax + t0 * (bx - ax), ax + t1 * (bx - ax));
+			x1 = qMax(ax + t0 * (bx - ax), ax + t1 * (bx - ax));
+		}
+
+		if (testSpan(row, int(x0 + 0.5f), int(x1 + 0.5f)))
+		{
+			return true;
+		}
+	}
+
+	return false;
+}
+
+float ObstacleMask::distance(math::Vector2f const & p) const
+{
+	if (m_distance.isNull())
+	{
+		return contains(p) ? 0.0f : 1e10f;
+	}
+
+	return m_distance.bilinear(p);
+}
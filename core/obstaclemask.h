@@ -0,0 +1,79 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_OBSTACLEMASK_H_
+#define CORE_OBSTACLEMASK_H_
+
+#include "core/obstaclemask.hh"
+#include "core/mapimage.hh"
+#include "core/raster.h"
+#include "base/bitmatrix.h"
+#include "math/vector2f.h"
+
+
+//! Areas of the boundary map where roads cannot be placed, like water.
+/*!
+ * Obstacle pixels are the pixels of the boundary map with a nonzero hue.
+ * They are packed into a bit matrix, one bit per pixel, when the mask is
+ * constructed. The distance to the nearest obstacle is also precomputed.
+ *
+ * All queries take field coordinates.
+ */
+class core::ObstacleMask
+{
+public:
+	//! Constructs the mask of the specified boundary map.
+	ObstacleMask(MapImage const & image);
+
+	//! Tests whether the nearest pixel to the specified point is an obstacle.
+	bool contains(math::Vector2f const & p) const;
+
+	//! Tests whether the line segment from a to b passes over an obstacle.
+	/*!
+	 * The segment is tested row by row, the pixels it covers in a row a
+	 * word of the mask at a time.
+	 */
+	bool intersects(math::Vector2f const & a, math::Vector2f const & b) const;
+
+	//! Returns the distance from the specified point to the nearest obstacle.
+	/*!
+	 * The distance is zero inside obstacles, and very large if there are none.
+	 */
+	float distance(math::Vector2f const & p) const;
+
+	//! Returns the packed obstacle pixels, rows are image rows.
+	base::BitMatrix const & bits() const { return m_bits; }
+
+private:
+	//! Obstacle pixels.
+	base::BitMatrix m_bits;
+	//! Distance to the nearest obstacle pixel, in field units.
+	FloatRaster m_distance;
+	//! Column scale, from field to image coordinates.
+	float m_scaleX;
+	//! Row scale, from field to image coordinates.
+	float m_scaleY;
+
+	//! Tests the nearest pixel to the specified point.
+	bool test(float x, float y) const;
+	//! Tests the pixels of a row from col0 to col1, inclusive.
+	bool testSpan(int row, int col0, int col1) const;
+};
+
+
+#endif // ifndef CORE_OBSTACLEMASK_H_
@@ -42,12 +42,18 @@ Parameters::Parameters(QObject *parent)
 
 void Parameters::set(KeyType const & key, ValueType const & value)
 {
-	m_map[key] = value;
+	{
+		QWriteLocker locker(&m_lock);
+		m_map[key] = value;
+	}
+
 	emit valueChanged(key, value);
 }
 
 Parameters::ValueType Parameters::get(KeyType const & key, ValueType const & def) const
 {
+	QReadLocker locker(&m_lock);
+
 	if (m_map.contains(key))
 	{
 		return m_map[key];
@@ -60,5 +66,7 @@ Parameters::ValueType Parameters::get(KeyType const & key, ValueType const & def
 
 Parameters::ValueType Parameters::get(KeyType const & key) const
 {
+	QReadLocker locker(&m_lock);
+
 	return m_map[key];
 }
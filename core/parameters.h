@@ -25,12 +25,15 @@
 #include <QString>
 #include <QVariant>
 #include <QMap>
+#include <QReadWriteLock>
 
 
 //! Global parameters map.
 /*!
  * A global instance of this class keeps various parametes that control
  * many aspects of core functionality.
+ *
+ * Parameters may be read from worker threads while the GUI assigns them.
  */
 class core::Parameters : public QObject
 {
@@ -73,6 +76,8 @@ signals:
 private:
 	//! Key/value map.
 	QMap<KeyType, ValueType> m_map;
+	//! Guards the key/value map.
+	mutable QReadWriteLock m_lock;
 
 	//! Constructs the object.
 	explicit Parameters(QObject * parent = NULL);
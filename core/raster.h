@@ -0,0 +1,186 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_RASTER_H_
+#define CORE_RASTER_H_
+
+#include "core/raster.hh"
+#include "math/vector2f.h"
+
+#include <QSharedData>
+#include <QSharedDataPointer>
+#include <QPoint>
+#include <QtGlobal>
+
+#include <cstring>
+
+
+//! Single-channel typed raster.
+/*!
+ * Values are stored row by row. The buffer is allocated at a 16-byte boundary
+ * and rows are padded to a multiple of 16 bytes, so every scan line starts at
+ * a 16-byte address. The buffer is implicitly shared, so rasters are cheap to
+ * copy. T must be a plain value type, values are copied as bytes.
+ *
+ * Sampling functions take field coordinates, using the same mapping as
+ * MapImage: the field's unit square covers the raster, with the y axis
+ * pointing up. Points outside the square are clamped to the border.
+ */
+template<typename T>
+class core::Raster
+{
+public:
+//! \name Object construction.
+//@{
+	//! Constructs a null raster.
+	Raster()
+		: m_width(0), m_height(0), m_stride(0)
+	{
+	}
+
+	//! Constructs a raster of the specified size, with all values set to zero.
+	Raster(int width, int height)
+		: m_width(width), m_height(height)
+		, m_stride(alignedStride(width))
+		, m_data(new Buffer(m_stride * height))
+	{
+	}
+//@}
+
+	//! Tests whether this is a null raster.
+	bool isNull() const { return m_width == 0 || m_height == 0; }
+	//! Returns the number of columns.
+	int width() const { return m_width; }
+	//! Returns the number of rows.
+	int height() const { return m_height; }
+	//! Returns the number of values between starts of two consecutive rows.
+	int stride() const { return m_stride; }
+
+	//! Tests whether the specified pixel is inside the raster.
+	bool contains(int x, int y) const { return x >= 0 && y >= 0 && x < m_width && y < m_height; }
+
+	//! Returns the values of the specified row.
+	T * scanLine(int y) { return m_data->values + y*m_stride; }
+	//! Returns the values of the specified row.
+	T const * constScanLine(int y) const { return m_data->values + y*m_stride; }
+
+	//! Returns the value of the specified pixel.
+	T value(int x, int y) const { return m_data->values[y*m_stride + x]; }
+	//! Assigns the value of the specified pixel.
+	void setValue(int x, int y, T value) { m_data->values[y*m_stride + x] = value; }
+
+//! \name Sampling in field coordinates.
+//@{
+	//! Returns the nearest pixel to the specified point.
+	QPoint nearestPixel(math::Vector2f const & p) const
+	{
+		float sx, sy;
+		toRasterCoords(p, sx, sy);
+
+		return QPoint(int(sx + 0.5f), int(sy + 0.5f));
+	}
+
+	//! Returns the value of the nearest pixel.
+	T nearest(math::Vector2f const & p) const
+	{
+		QPoint ip = nearestPixel(p);
+		return value(ip.x(), ip.y());
+	}
+
+	//! Returns the value interpolated between the four nearest pixels.
+	float bilinear(math::Vector2f const & p) const
+	{
+		float sx, sy;
+		toRasterCoords(p, sx, sy);
+
+		int x0 = int(sx), y0 = int(sy);
+		int x1 = qMin(x0 + 1, m_width - 1);
+		int y1 = qMin(y0 + 1, m_height - 1);
+		float tx = sx - x0, ty = sy - y0;
+
+		float top    = (1-tx) * value(x0,y0) + tx * value(x1,y0);
+		float bottom = (1-tx) * value(x0,y1) + tx * value(x1,y1);
+
+		return (1-ty) * top + ty * bottom;
+	}
+//@}
+
+private:
+	//! Alignment of the buffer and of the rows, in bytes.
+	enum { Alignment = 16 };
+
+	//! Implicitly shared buffer of values.
+	struct Buffer : public QSharedData
+	{
+		//! Values, at an aligned address.
+		T * values;
+		//! Number of values.
+		int size;
+
+		//! Allocates the buffer, with all values set to zero.
+		Buffer(int n)
+			: size(n)
+		{
+			values = static_cast<T *>(qMallocAligned(qMax(size, 1) * sizeof(T), Alignment));
+			memset(values, 0, size * sizeof(T));
+		}
+
+		//! Allocates a copy of the buffer, on detach.
+		Buffer(Buffer const & other)
+			: QSharedData(other)
+			, size(other.size)
+		{
+			values = static_cast<T *>(qMallocAligned(qMax(size, 1) * sizeof(T), Alignment));
+			memcpy(values, other.values, size * sizeof(T));
+		}
+
+		~Buffer()
+		{
+			qFreeAligned(values);
+		}
+	};
+
+	//! Number of columns.
+	int m_width;
+	//! Number of rows.
+	int m_height;
+	//! Row length in the buffer.
+	int m_stride;
+	//! Values.
+	QSharedDataPointer<Buffer> m_data;
+
+	//! Returns the row length for the specified number of columns, rounded up to 16 bytes.
+	static int alignedStride(int width)
+	{
+		int const perBlock = Alignment / sizeof(T) > 0 ? Alignment / sizeof(T) : 1;
+		return (width + perBlock - 1) / perBlock * perBlock;
+	}
+
+	//! Converts field coordinates to continuous raster coordinates, clamped to the raster.
+	void toRasterCoords(math::Vector2f const & p, float & sx, float & sy) const
+	{
+		float fx = qMax(0.0f, qMin(p(0), 1.0f));
+		float fy = qMax(0.0f, qMin(p(1), 1.0f));
+
+		sx = fx * (m_width - 1);
+		sy = (m_height - 1) - fy * (m_height - 1);
+	}
+};
+
+
+#endif // ifndef CORE_RASTER_H_
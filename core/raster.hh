@@ -0,0 +1,32 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_RASTER_HH_
+#define CORE_RASTER_HH_
+
+namespace core
+{
+	template<typename T> class Raster;
+
+	//! Single-channel raster of floats.
+	typedef Raster<float> FloatRaster;
+	//! Single-channel raster of bytes.
+	typedef Raster<unsigned char> ByteRaster;
+};
+
+#endif // ifndef CORE_RASTER_HH_
@@ -22,9 +22,11 @@
 #include "core/seeder.h"
 #include "core/grapher.h"
 #include "core/field.h"
+#include "core/parameters.h"
 #include "math/vector2f.h"
 #include "math/tensor.h"
 #include "math/funcs.h"
+#include "base/profiler.h"
 
 #include <QDebug>
 
@@ -40,6 +42,7 @@ core::Region::Region(QObject * parent)
 	, m_seeder(NULL)
 	, m_grapher(NULL)
 	, m_lastTraceMajor(false)
+	, m_changeDepth(0)
 {
 }
 
@@ -99,43 +102,101 @@ Grapher & core::Region::grapher() const
 
 void core::Region::removeEdge(Edge * edge)
 {
+	ChangeBatch batch(this);
+
 	Q_ASSERT(edge->parent() == &tracer());
 	tracer().removeEdge(edge);
 
 	if (edge->parent() == NULL)
 	{
 		grapher().disconnect(edge->v1(), edge->v2());
-		emit edgeRemoved(edge);
+		changes().removeEdge(edge);
 		delete edge;
+
+		updateSubregions();
 	}
 }
 
 void core::Region::addSeed(Point const & seed)
 {
+	ChangeBatch batch(this);
+
 	if (seeder().insert(seed))
 	{
-		emit seedAdded(seed);
+		changes().addSeed(seed);
 	}
 }
 
 void core::Region::removeSeed(Point const & seed)
 {
+	ChangeBatch batch(this);
+
 	if (seeder().remove(seed))
 	{
-		emit seedRemoved(seed);
+		changes().removeSeed(seed);
+	}
+}
+
+
+void core::Region::beginChanges()
+{
+	++changeRoot()->m_changeDepth;
+}
+
+void core::Region::endChanges()
+{
+	Region * root = changeRoot();
+	Q_ASSERT(root->m_changeDepth > 0);
+
+	if (--root->m_changeDepth == 0 && ! root->m_changes.isEmpty())
+	{
+		ChangeSet changes = root->takeChanges();
+		emit root->changed(changes);
 	}
 }
 
+ChangeSet core::Region::takeChanges()
+{
+	Region * root = changeRoot();
+
+	ChangeSet changes = root->m_changes;
+	root->m_changes.clear();
+
+	return changes;
+}
+
+ChangeSet & core::Region::changes()
+{
+	return changeRoot()->m_changes;
+}
+
+core::Region * core::Region::changeRoot()
+{
+	Region * root = this;
+
+	while (Region * parent = qobject_cast<Region *>(root->parent()))
+	{
+		root = parent;
+	}
+
+	return root;
+}
+
 
 bool core::Region::traceField(TensorField const & field)
 {
+	PROFILE_SPAN("region/traceField");
+
+	ChangeBatch batch(this);
+
 	Point seed = seeder().pop();
 
 	if (seed.finite())
 	{
-		emit seedRemoved(seed);
+		changes().removeSeed(seed);
 
-		Region::traceField(field, seed);
+		int n = Region::traceField(field, seed);
+		tracer().countSeed(n > 0);
 
 		return true;
 	}
@@ -143,20 +204,25 @@ bool core::Region::traceField(TensorField const & field)
 	{
 		// try re-seeding
 
+		PROFILE_SPAN("region/reseed");
+
 		foreach (Point p, grapher().dongles() + grapher().bridges())
 		{
 			if (seeder().insert(p))
 			{
-				emit seedAdded(p);
+				changes().addSeed(p);
 			}
 		}
 
 		while (! seeder().empty())
 		{
 			seed = seeder().pop();
-			emit seedRemoved(seed);
+			changes().removeSeed(seed);
 
-			if (core::Region::traceField(field, seed) > 0)
+			int n = core::Region::traceField(field, seed);
+			tracer().countSeed(n > 0);
+
+			if (n > 0)
 			{
 				return true;
 			}
@@ -190,6 +256,8 @@ int core::Region::traceField(TensorField const & field, Point const & fromPoint)
 
 int core::Region::traceField(TensorField const & field, Point const & fromPoint, math::Vector2f const & inDirection, bool major)
 {
+	ChangeBatch batch(this);
+
 	Tracer::EdgeList edges = tracer().traceField(field, major, fromPoint.pos(), inDirection);
 
 	int numAdded = 0;
@@ -199,18 +267,18 @@ int core::Region::traceField(TensorField const & field, Point const & fromPoint,
 		{
 			++numAdded;
 
-			grapher().connect(edge->v1(), edge->v2());
-			emit edgeAdded(edge);
+			grapher().connect(edge);
+			changes().addEdge(edge);
 
 			if (seeder().insert(edge->v2()))
 			{
-				emit seedAdded(edge->v2());
+				changes().addSeed(edge->v2());
 			}
 		}
 		else
 		{
 			grapher().disconnect(edge->v1(), edge->v2());
-			emit edgeRemoved(edge);
+			changes().removeEdge(edge);
 
 			// remove seed-points from deleted vertices
 			//
@@ -218,14 +286,14 @@ int core::Region::traceField(TensorField const & field, Point const & fromPoint,
 			{
 				if (seeder().remove(edge->v1()))
 				{
-					emit seedRemoved(edge->v1());
+					changes().removeSeed(edge->v1());
 				}
 			}
 			if (!tracer().containsVertex(edge->v2()))
 			{
 				if (seeder().remove(edge->v2()))
 				{
-					emit seedRemoved(edge->v2());
+					changes().removeSeed(edge->v2());
 				}
 			}
 
@@ -233,33 +301,43 @@ int core::Region::traceField(TensorField const & field, Point const & fromPoint,
 		}
 	}
 
+	updateSubregions();
+
 	return numAdded;
 }
 
 void core::Region::traceLineSegment(Point const & fromPoint, Point const & toPoint)
 {
+	ChangeBatch batch(this);
+
 	Tracer::EdgeList edges = tracer().traceLineSegment(fromPoint, toPoint);
 
 	foreach (core::Edge * edge, edges)
 	{
 		if (edge->parent() != NULL)
 		{
-			grapher().connect(edge->v1(), edge->v2());
-			emit edgeAdded(edge);
+			grapher().connect(edge);
+			changes().addEdge(edge);
 		}
 		else
 		{
 			grapher().disconnect(edge->v1(), edge->v2());
-			emit edgeRemoved(edge);
+			changes().removeEdge(edge);
 
 			delete edge;
 		}
 	}
+
+	updateSubregions();
 }
 
 
 void core::Region::simplifyGraph()
 {
+	PROFILE_SPAN("region/simplifyGraph");
+
+	ChangeBatch batch(this);
+
 	Tracer::EdgeList edges;
 	int numAdded = 0, numRemoved = 0;
 
@@ -273,15 +351,15 @@ void core::Region::simplifyGraph()
 			{
 				++numAdded;
 
-				grapher().connect(edge->v1(), edge->v2());
-				emit edgeAdded(edge);
+				grapher().connect(edge);
+				changes().addEdge(edge);
 			}
 			else
 			{
 				++numRemoved;
 
 				grapher().disconnect(edge->v1(), edge->v2());
-				emit edgeRemoved(edge);
+				changes().removeEdge(edge);
 
 				delete edge;
 			}
@@ -289,50 +367,160 @@ void core::Region::simplifyGraph()
 	}
 	while (! edges.empty());
 
+	updateSubregions();
+
 //	qDebug() << "removed" << numRemoved << "edge(s), added" << numAdded << "edge(s)";
 }
 
 
 void core::Region::findSubregions()
 {
+	PROFILE_SPAN("region/findSubregions");
+
+	ChangeBatch batch(this);
+
+	if (grapher().faceTracking())
+	{
+		// subregions are already up to date
+		updateSubregions();
+		return;
+	}
+
+	Parameters * params = Parameters::instance();
+
+	if (params->get("grapher/incremental", true).toBool() && params->get("grapher/planar", true).toBool())
+	{
+		grapher().setFaceTracking(true);
+		updateSubregions();
+		return;
+	}
+
 	Grapher::CycleList cycles = grapher().cycles();
 
 	foreach (Grapher::Cycle cycle, cycles)
 	{
-		QList<Edge *> edges;
-		QList<bool>   order;
-		bool road = false;
+		createSubregion(cycle);
+	}
+}
 
-		QList<Tracer::Vertex> & verts = cycle; // same thing
-		for (QList<Tracer::Vertex>::iterator it = verts.begin(); it != verts.end(); ++it)
-		{
-			QList<Tracer::Vertex>::iterator jt = it + 1;
-			if (jt == verts.end()) jt = verts.begin();
+bool core::Region::findSubregionEdges(QList<Point> const & cycle, QVector<Edge *> & edges, QVector<bool> & order) const
+{
+	bool road = false;
+
+	edges.clear();
+	order.clear();
+
+	for (QList<Tracer::Vertex>::const_iterator it = cycle.begin(); it != cycle.end(); ++it)
+	{
+		QList<Tracer::Vertex>::const_iterator jt = it + 1;
+		if (jt == cycle.end()) jt = cycle.begin();
 
-			Tracer::Vertex v1 = *it;
-			Tracer::Vertex v2 = *jt;
+		Tracer::Vertex v1 = *it;
+		Tracer::Vertex v2 = *jt;
 
-			Edge * edge = tracer().findEdge(v1, v2, true).value(0);
-			if (edge == NULL)
+		// faces bounded by two edges between the same vertex pair use each one once
+		//
+		Edge * edge = NULL;
+		foreach (Edge * candidate, tracer().findEdge(v1, v2, true))
+		{
+			if (! edges.contains(candidate))
 			{
-				qCritical() << "the edge for specified vertices is missing!";
-				continue;
+				edge = candidate;
+				break;
 			}
+		}
 
-			edges << edge;
-			order << (v1 == edge->v1());
-			road  |= edge->isRoad();
+		if (edge == NULL)
+		{
+			qCritical() << "the edge for specified vertices is missing!";
+			continue;
 		}
 
-		if (road)
+		edges << edge;
+		order << (v1 == edge->v1());
+		road  |= edge->isRoad();
+	}
+
+	// the region must be surrounded by at least one road segment to be worth building on
+	return road;
+}
+
+QObject * core::Region::createSubregion(QList<Point> const & cycle)
+{
+	QVector<Edge *> edges;
+	QVector<bool>   order;
+
+	if (findSubregionEdges(cycle, edges, order))
+	{
+		return onSubregionFound(edges, order);
+	}
+
+	return NULL;
+}
+
+void core::Region::updateSubregions()
+{
+	if (! grapher().faceTracking()) return;
+
+	QList<int> added, removed, changed;
+	grapher().takeFaceChanges(added, removed, changed);
+
+	foreach (int id, removed)
+	{
+		QPointer<QObject> subregion = m_subregions.take(id);
+
+		if (! subregion.isNull())
 		{
-			// the region must be surrounded by at least one road segment to be worth building on
-			onSubregionFound(edges.toVector(), order.toVector());
+			onSubregionLost(subregion);
 		}
 	}
+
+	// subregions whose border has changed are updated in place
+	//
+	foreach (int id, changed)
+	{
+		QPointer<QObject> subregion = m_subregions.value(id);
+
+		QVector<Edge *> edges;
+		QVector<bool>   order;
+		bool road = findSubregionEdges(grapher().face(id), edges, order);
+
+		if (subregion.isNull())
+		{
+			// the face had no subregion yet, it may qualify now
+			//
+			m_subregions.remove(id);
+			if (road) added << id;
+		}
+		else if (road)
+		{
+			onSubregionChanged(subregion, edges, order);
+		}
+		else
+		{
+			m_subregions.remove(id);
+			onSubregionLost(subregion);
+		}
+	}
+
+	foreach (int id, added)
+	{
+		QObject * subregion = createSubregion(grapher().face(id));
+
+		if (subregion != NULL)
+		{
+			m_subregions.insert(id, subregion);
+		}
+	}
+}
+
+void core::Region::resetSubregions()
+{
+	grapher().setFaceTracking(false);
+	m_subregions.clear();
 }
 
-void core::Region::onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order)
+QVector<Point> core::Region::subregionBorder(QVector<Edge *> const & edges, QVector<bool> const & order)
 {
 	QList<Point> border;
 
@@ -351,10 +539,32 @@ void core::Region::onSubregionFound(QVector<Edge *> const & edges, QVector<bool>
 		}
 	}
 
-	onSubregionFound(border.toVector());
+	return border.toVector();
+}
+
+QObject * core::Region::onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order)
+{
+	return onSubregionFound(subregionBorder(edges, order));
+}
+
+QObject * core::Region::onSubregionFound(QVector<Point> const & border)
+{
+	Q_UNUSED(border);
+	return NULL;
+}
+
+void core::Region::onSubregionLost(QObject * subregion)
+{
+	Q_UNUSED(subregion);
+}
+
+void core::Region::onSubregionChanged(QObject * subregion, QVector<Edge *> const & edges, QVector<bool> const & order)
+{
+	onSubregionChanged(subregion, subregionBorder(edges, order));
 }
 
-void core::Region::onSubregionFound(QVector<Point> const & border)
+void core::Region::onSubregionChanged(QObject * subregion, QVector<Point> const & border)
 {
+	Q_UNUSED(subregion);
 	Q_UNUSED(border);
 }
@@ -26,20 +26,45 @@
 #include "core/field.hh"
 #include "core/point.hh"
 #include "core/edge.hh"
+#include "core/changeset.h"
 #include "math/vector2f.hh"
 
 #include <QObject>
 #include <QVector>
+#include <QList>
+#include <QMap>
+#include <QPointer>
 
 
 //! Represents a region of space where road network is built.
 /*!
  * Provides instances of Tracer, Grapher and Seeder classes that are
  * used during the road-construction process.
+ *
+ * Changes to the road network are collected in a ChangeSet and delivered by
+ * the changed() signal, once per public operation or per batch of them.
+ * A region nested in another one, such as a district in a city, has its
+ * changes delivered by the outermost region.
  */
 class core::Region : public QObject
 {
 	Q_OBJECT
+public:
+	//! Batches changes for the lifetime of the object.
+	class ChangeBatch
+	{
+	public:
+		//! Calls beginChanges() on the specified region.
+		explicit ChangeBatch(Region * region) : m_region(region) { m_region->beginChanges(); }
+		//! Calls endChanges() on the region.
+		~ChangeBatch() { m_region->endChanges(); }
+
+	private:
+		Q_DISABLE_COPY(ChangeBatch)
+
+		Region * m_region;
+	};
+
 public:
 	//! Construct the object.
 	explicit Region(QObject * parent = NULL);
@@ -54,7 +79,7 @@ public:
 	//! Removes the specified edge from the street graph.
 	/*!
 	 * Edge information is removed from both the tracing and graphing subsystem.
-	 * Emits the edgeRemoved signal.
+	 * The removal is reported through the changed() signal.
 	 *
 	 * \param edge edge to be removed
 	 */
@@ -62,7 +87,7 @@ public:
 
 	//! Adds the specified seed point.
 	/*!
-	 * Emits the seedAdded signal.
+	 * The addition is reported through the changed() signal.
 	 *
 	 * \param seed seed point to be added
 	 */
@@ -70,7 +95,7 @@ public:
 
 	//! Removes the specified seed point.
 	/*!
-	 * Emits the seedRemoved signal.
+	 * The removal is reported through the changed() signal.
 	 *
 	 * \param seed seed point to be removed
 	 */
@@ -113,17 +138,39 @@ public:
 	void simplifyGraph();
 
 	//! Locates closed regions withing the road network.
+	/*!
+	 * If the "grapher/incremental" parameter is set (the default), the grapher keeps
+	 * faces up to date from then on, and subregions are created and removed as edges
+	 * are added and removed, without running the detection again.
+	 */
 	void findSubregions();
 
+//! \name Change notification.
+//@{
+	//! Starts a batch of changes.
+	/*!
+	 * The changed() signal is not emitted until the matching endChanges().
+	 * Batches may be nested.
+	 */
+	void beginChanges();
+
+	//! Ends a batch of changes.
+	/*!
+	 * Emits the changed() signal if this ends the outermost batch, and
+	 * there were any changes.
+	 */
+	void endChanges();
+
+	//! Returns and clears the changes collected so far, without emitting changed().
+	core::ChangeSet takeChanges();
+//@}
+
 signals:
-	//! A signal emitted when an edge has been added to the road network.
-	void edgeAdded(core::Edge * edge);
-	//! A signal emitted when an edge has been removed from the road network.
-	void edgeRemoved(core::Edge * edge);
-	//! A signal emitted when a seed-point has been added to the seeder object.
-	void seedAdded(core::Point const & p);
-	//! A signal emitted when a seed-point has been removed from the seeder object.
-	void seedRemoved(core::Point const & p);
+	//! A signal emitted when the road network has changed.
+	/*!
+	 * \param changes edges, seed-points and districts added, removed or modified
+	 */
+	void changed(core::ChangeSet const & changes);
 
 protected:
 	//! Flag indicating whether we're tracing a major road network (or not).
@@ -132,14 +179,53 @@ protected:
 	//! Callback function called when a subregion has been detected.
 	/*!
 	 * This implementation constructs the border and calls foundSubregion(QVector<Point> const & border).
+	 *
+	 * \return object representing the subregion, or NULL if none has been created
 	 */
-	virtual void onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order);
+	virtual QObject * onSubregionFound(QVector<Edge *> const & edges, QVector<bool> const & order);
 
 	//! Callback function called when a subregion has been detected.
 	/*!
 	 * This implementation does nothing.
+	 *
+	 * \return object representing the subregion, or NULL if none has been created
+	 */
+	virtual QObject * onSubregionFound(QVector<Point> const & border);
+
+	//! Callback function called when a subregion ceased to exist.
+	/*!
+	 * Called only while subregions are maintained incrementally, with the
+	 * object previously returned by onSubregionFound(). This implementation
+	 * does nothing.
 	 */
-	virtual void onSubregionFound(QVector<Point> const & border);
+	virtual void onSubregionLost(QObject * subregion);
+
+	//! Callback function called when the border of a subregion has changed.
+	/*!
+	 * Called only while subregions are maintained incrementally, with the
+	 * object previously returned by onSubregionFound(), which is to be updated
+	 * in place. This implementation constructs the border and calls
+	 * onSubregionChanged(QObject *, QVector<Point> const &).
+	 */
+	virtual void onSubregionChanged(QObject * subregion, QVector<Edge *> const & edges, QVector<bool> const & order);
+
+	//! Callback function called when the border of a subregion has changed.
+	/*!
+	 * This implementation does nothing.
+	 */
+	virtual void onSubregionChanged(QObject * subregion, QVector<Point> const & border);
+
+	//! Returns the border running along the specified edges.
+	static QVector<Point> subregionBorder(QVector<Edge *> const & edges, QVector<bool> const & order);
+
+	//! Stops incremental maintenance of subregions.
+	/*!
+	 * Existing subregion objects are left alone.
+	 */
+	void resetSubregions();
+
+	//! Returns the change set collecting changes of this region.
+	core::ChangeSet & changes();
 
 private:
 	//! Tracer object.
@@ -150,6 +236,15 @@ private:
 	core::Grapher * m_grapher;
 	//! Flag indicating whether last trace step was in the direction of major eigenvector field (or not).
 	bool m_lastTraceMajor;
+	//! Subregion objects keyed by identifiers of grapher's faces.
+	QMap<int, QPointer<QObject> > m_subregions;
+	//! Changes collected since the last notification.
+	core::ChangeSet m_changes;
+	//! Nesting depth of change batches.
+	int m_changeDepth;
+
+	//! Returns the outermost region, which collects the changes.
+	Region * changeRoot();
 
 	//! Creates the tracer object and assigns it to m_tracer.
 	void createTracer();
@@ -157,6 +252,24 @@ private:
 	void createSeeder();
 	//! Creates the graphing object and assigns it to m_grapher.
 	void createGrapher();
+
+	//! Finds edges along the specified cycle.
+	/*!
+	 * \param cycle cycle of vertices
+	 * \param[out] edges edges between consecutive vertices
+	 * \param[out] order for each edge, whether it runs from its v1() to its v2() along the cycle
+	 * \return true if at least one of the edges is a road
+	 */
+	bool findSubregionEdges(QList<Point> const & cycle, QVector<Edge *> & edges, QVector<bool> & order) const;
+
+	//! Creates the subregion enclosed by the specified cycle.
+	/*!
+	 * \return object representing the subregion, or NULL if none has been created
+	 */
+	QObject * createSubregion(QList<Point> const & cycle);
+
+	//! Applies face changes reported by the grapher to subregions.
+	void updateSubregions();
 };
 
 
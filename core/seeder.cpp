@@ -19,7 +19,7 @@
 
 #include "core/seeder.h"
 #include "core/mapimage.h"
-#include "core/border.h"
+#include "core/boundarygeometry.h"
 #include "math/vector2f.h"
 #include "math/funcs.h"
 
@@ -101,29 +101,13 @@ Seeder::SeedPointList::iterator Seeder::findSeedPoint(Point const & p)
 
 void Seeder::setBoundaries(core::MapImage const & mapImage)
 {
-	border::Regions regions;
-	border::findRegions(regions, mapImage);
+	QSharedPointer<BoundaryGeometry const> geometry = BoundaryGeometry::fromImage(mapImage);
 
-	foreach (border::Boundary const & boundary, regions)
+	foreach (BoundaryGeometry::Polyline const & polyline, geometry->simplified(0.01f)) // TODO: configurable parameter
 	{
-		foreach (border::BoundarySegment const & segment, boundary)
+		for (int i = 1; i < polyline.size(); ++i)
 		{
-			QPoint a = segment[0];
-			Vector2f af = mapImage.toFieldCoords(a);
-
-			foreach (QPoint b, segment)
-			{
-				Vector2f bf = mapImage.toFieldCoords(b);
-
-				Vector2f d = bf - af;
-				if (d.norm() > 0.01) // TODO: configurable parameter
-				{
-					m_boundarySegments.append(LineSegment(af, bf));
-
-					a = b;
-					af = mapImage.toFieldCoords(a);
-				}
-			}
+			m_boundarySegments.append(LineSegment(polyline[i-1], polyline[i]));
 		}
 	}
 }
@@ -19,6 +19,7 @@
 
 #include "core/tracer.h"
 #include "core/edge.h"
+#include "core/filter.h"
 
 #include <QDebug>
 
@@ -47,7 +48,81 @@ Tracer::Tracer(RoadType type, QObject * parent)
 
 void Tracer::setPopulationMapImage(MapImage const & image)
 {
-	m_populationMapImage = image;
+	float blur = Parameters::instance()->get("tracer/populationBlur", 0.0f).toFloat();
+
+	filter::gaussianBlur(m_populationDensity, image.values(), blur);
+}
+
+void Tracer::setObstacleMask(QSharedPointer<ObstacleMask const> const & mask)
+{
+	m_obstacleMask = mask;
+}
+
+
+Tracer::Statistics::Statistics()
+	: rk4Steps(0)
+	, fieldEvaluations(0)
+	, traces(0)
+	, samples(0)
+	, gridQueries(0)
+	, gridCandidates(0)
+	, seedsConsumed(0)
+	, seedsProductive(0)
+{
+	for (int i = 0; i < NumOutcomes; ++i) outcomes[i] = 0;
+}
+
+Tracer::Statistics & Tracer::Statistics::operator+=(Statistics const & other)
+{
+	rk4Steps         += other.rk4Steps;
+	fieldEvaluations += other.fieldEvaluations;
+	traces           += other.traces;
+	samples          += other.samples;
+	gridQueries      += other.gridQueries;
+	gridCandidates   += other.gridCandidates;
+	seedsConsumed    += other.seedsConsumed;
+	seedsProductive  += other.seedsProductive;
+
+	for (int i = 0; i < NumOutcomes; ++i) outcomes[i] += other.outcomes[i];
+
+	return *this;
+}
+
+qint64 Tracer::Statistics::edgesTraced() const
+{
+	return outcomes[OutcomeVertex] + outcomes[OutcomeSamplePoint] + outcomes[OutcomeFreeEnd];
+}
+
+float Tracer::Statistics::samplesPerEdge() const
+{
+	qint64 edges = edgesTraced();
+	return edges > 0 ? float(samples) / edges : 0.0f;
+}
+
+char const * Tracer::Statistics::outcomeName(Outcome outcome)
+{
+	switch (outcome)
+	{
+	case OutcomeVertex:        return "connected to vertex";
+	case OutcomeSamplePoint:   return "touched trace line";
+	case OutcomeFreeEnd:       return "free end";
+	case OutcomeRejectedAngle: return "rejected by angle";
+	case OutcomeRejectedShort: return "rejected as too short";
+	case OutcomeRejectedOther: return "rejected (other)";
+	default:                   return "unknown";
+	}
+}
+
+
+void Tracer::resetStatistics()
+{
+	m_statistics = Statistics();
+}
+
+void Tracer::countSeed(bool productive)
+{
+	++m_statistics.seedsConsumed;
+	if (productive) ++m_statistics.seedsProductive;
 }
 
 
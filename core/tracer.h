@@ -26,12 +26,14 @@
 #include "base/matrix.h"
 #include "core/field.hh"
 #include "core/mapimage.h"
+#include "core/obstaclemask.hh"
 #include "core/parameters.h"
 
 #include <QObject>
 #include <QVector>
 #include <QList>
 #include <QPair>
+#include <QSharedPointer>
 
 
 //! Road-network tracer.
@@ -62,6 +64,60 @@ public:
 		RoadTypeLocal, //!< Local roads.
 	};
 
+	//! Counters of the tracing work done.
+	/*!
+	 * Comparing the integration and search work against the edges it produced
+	 * shows which parameter settings waste the most of it.
+	 */
+	struct Statistics
+	{
+		//! Outcome of a trace started by traceField().
+		enum Outcome
+		{
+			OutcomeVertex,        //!< Connected to an existing vertex.
+			OutcomeSamplePoint,   //!< Touched an existing trace line, which was split.
+			OutcomeFreeEnd,       //!< Ended in a new vertex.
+			OutcomeRejectedAngle, //!< Touched a trace line at too sharp an angle.
+			OutcomeRejectedShort, //!< Too short to make an edge.
+			OutcomeRejectedOther, //!< Duplicated an edge, or touched too close to a vertex.
+			NumOutcomes
+		};
+
+		//! Number of RK4 integration steps.
+		qint64 rk4Steps;
+		//! Number of tensor field evaluations.
+		qint64 fieldEvaluations;
+		//! Number of traces started by traceField().
+		qint64 traces;
+		//! Number of sample-points traced.
+		qint64 samples;
+		//! Number of spatial grid queries.
+		qint64 gridQueries;
+		//! Number of grid elements scanned by the queries.
+		qint64 gridCandidates;
+		//! Number of traces with each outcome.
+		qint64 outcomes[NumOutcomes];
+		//! Number of seeds the region traced from.
+		qint64 seedsConsumed;
+		//! Number of seeds that produced at least one edge.
+		qint64 seedsProductive;
+
+		//! Constructs zeroed counters.
+		Statistics();
+
+		//! Adds counters of another tracer.
+		Statistics & operator+=(Statistics const & other);
+
+		//! Returns the number of traces that produced an edge.
+		qint64 edgesTraced() const;
+
+		//! Returns the mean number of sample-points traced per edge produced.
+		float samplesPerEdge() const;
+
+		//! Returns a human-readable name of the specified outcome.
+		static char const * outcomeName(Outcome outcome);
+	};
+
 public:
 	//! Constructs the object.
 	Tracer(RoadType type, QObject * parent = NULL);
@@ -72,7 +128,36 @@ public:
 	RoadType roadType() const { return m_roadType; }
 
 	//! Assigns the population map image.
+	/*!
+	 * Population density, the value of the image pixels, is decoded once
+	 * and smoothed by a Gaussian of "tracer/populationBlur" pixels. Denser
+	 * areas get shorter separation distances.
+	 */
 	void setPopulationMapImage(MapImage const & image);
+
+	//! Assigns the obstacle mask.
+	/*!
+	 * Streamlines traced by traceField() end at the last sample-point before
+	 * an obstacle, or at one that comes within a quarter sample step of it.
+	 */
+	void setObstacleMask(QSharedPointer<ObstacleMask const> const & mask);
+	//! Returns the assigned obstacle mask.
+	QSharedPointer<ObstacleMask const> obstacleMask() const { return m_obstacleMask; }
+//@}
+
+//! \name Statistics.
+//@{
+	//! Returns counters of the work done since construction or the last reset.
+	Statistics const & statistics() const { return m_statistics; }
+
+	//! Resets all counters to zero.
+	void resetStatistics();
+
+	//! Counts a seed the owning region traced from.
+	/*!
+	 * \param productive whether tracing from the seed added any edge
+	 */
+	void countSeed(bool productive);
 //@}
 
 //! \name Element access.
@@ -149,6 +234,16 @@ public:
 	 * \return list of created and removed edges
 	 */
 	EdgeList traceField(core::TensorField const & field, bool major, math::Vector2f const & fromPosition, math::Vector2f const & inDirection);
+
+	//! Integrates the field's streamline by the RK-4 scheme.
+	/*!
+	 * Stops at a degenerate point, at the domain bounds, or after distMax.
+	 * \param[in,out] p starting point, receives the end point
+	 * \param[in,out] d tracing direction, receives the direction at the end point
+	 * \param steps if not NULL, the number of integration steps is added to it
+	 * \return distance traced
+	 */
+	static float integrate(core::TensorField const & field, bool major, math::Vector2f & p, math::Vector2f & d, float distMax, int * steps = NULL);
 //@}
 
 	//! Simplifies the road network.
@@ -196,8 +291,12 @@ private:
 
 	//! Assigned road type.
 	RoadType m_roadType;
-	//! Assigned population map image.
-	MapImage m_populationMapImage;
+	//! Population density, from the population map image.
+	FloatRaster m_populationDensity;
+	//! Assigned obstacle mask.
+	QSharedPointer<ObstacleMask const> m_obstacleMask;
+	//! Work counters, updated by const queries as well.
+	mutable Statistics m_statistics;
 
 //! \name Data elements.
 //@{
@@ -227,6 +326,25 @@ private:
 
 //! \name Tracing parameters.
 //@{
+	//! Distances that depend on the position.
+	struct Separation
+	{
+		//! Distance separating individual vertices.
+		float sep;
+		//! Distance separating two trace lines.
+		float test;
+		//! Minimum length of a road segment.
+		float segment;
+		//! Extra distance to try traversing while looking for a way to complete a road segment.
+		float lookahead;
+	};
+
+	//! Returns all distances that depend on the position, at the specified point.
+	/*!
+	 * The population density is sampled only once.
+	 */
+	Separation separation(Point const & p) const;
+
 	//! Returns the distance separating individual vertices.
 	float distSep() const;
 	//! Returns the distance separating individual vertices.
@@ -289,9 +407,10 @@ private:
 	 * \param startVertex vertex from which the trace line starts
 	 * \param trace trace line
 	 * \param existingVertex vertex that the trace comes close to
+	 * \param outcome if not NULL, receives the outcome
 	 * \return list of created and removed edges
 	 */
-	EdgeList completeEdge(Vertex const & startVertex, Edge::Trace const & trace, Vertex const & existingVertex);
+	EdgeList completeEdge(Vertex const & startVertex, Edge::Trace const & trace, Vertex const & existingVertex, Statistics::Outcome * outcome = NULL);
 
 	//! Completes an edge that touches an existing trace line.
 	/*!
@@ -299,17 +418,19 @@ private:
 	 * \param trace trace line
 	 * \param existingSamplePoint point of contact on the existing trace
 	 * \param touchingSamplePoint point of contact on the trace line
+	 * \param outcome if not NULL, receives the outcome
 	 * \return list of created and removed edges
 	 */
-	EdgeList completeEdge(Vertex const & startVertex, Edge::Trace const & trace, SamplePoint const & existingSamplePoint,SamplePoint const & touchingSamplePoint);
+	EdgeList completeEdge(Vertex const & startVertex, Edge::Trace const & trace, SamplePoint const & existingSamplePoint,SamplePoint const & touchingSamplePoint, Statistics::Outcome * outcome = NULL);
 
 	//! Completes an edge.
 	/*!
 	 * \param startVertex vertex from which the trace line starts
 	 * \param trace trace line
+	 * \param outcome if not NULL, receives the outcome
 	 * \return list of created and removed edges
 	 */
-	EdgeList completeEdge(Vertex const & startVertex, Edge::Trace const & trace);
+	EdgeList completeEdge(Vertex const & startVertex, Edge::Trace const & trace, Statistics::Outcome * outcome = NULL);
 
 	//! Type of road edge this tracer is laying.
 	Edge::Types edgeType() const;
@@ -42,7 +42,7 @@ void removeGridElement(T & grid, E const & element);
 
 template<class T, class E>
 static
-QList<E> findGridElement(T const & grid, math::Vector2f const & atPosition, math::Vector2f const & sweepDirection, float sweepAngle);
+QList<E> findGridElement(T const & grid, math::Vector2f const & atPosition, math::Vector2f const & sweepDirection, float sweepAngle, int * scanned);
 
 template<class T, class E>
 static
@@ -202,7 +202,13 @@ Tracer::VertexList Tracer::findVertex(math::Vector2f const & atPosition, float r
 
 Tracer::VertexList Tracer::findVertex(math::Vector2f const & atPosition, math::Vector2f const & sweepDirection, float sweepAngle) const
 {
-	return findGridElement<VertexGrid, Vertex>(m_vertices, atPosition, sweepDirection, sweepAngle);
+	int scanned = 0;
+	VertexList result = findGridElement<VertexGrid, Vertex>(m_vertices, atPosition, sweepDirection, sweepAngle, &scanned);
+
+	++m_statistics.gridQueries;
+	m_statistics.gridCandidates += scanned;
+
+	return result;
 }
 
 Tracer::SamplePointList Tracer::findSamplePoint(math::Vector2f const & atPosition, float radius) const
@@ -212,7 +218,13 @@ Tracer::SamplePointList Tracer::findSamplePoint(math::Vector2f const & atPositio
 
 Tracer::SamplePointList Tracer::findSamplePoint(math::Vector2f const & atPosition, math::Vector2f const & sweepDirection, float sweepAngle) const
 {
-	return findGridElement<SamplePointGrid, SamplePoint>(m_samplePoints, atPosition, sweepDirection, sweepAngle);
+	int scanned = 0;
+	SamplePointList result = findGridElement<SamplePointGrid, SamplePoint>(m_samplePoints, atPosition, sweepDirection, sweepAngle, &scanned);
+
+	++m_statistics.gridQueries;
+	m_statistics.gridCandidates += scanned;
+
+	return result;
 }
 
 //
@@ -275,9 +287,12 @@ struct CloserToPosition
 };
 
 //! Finds elements that fall in the search area.
+/*!
+ * The number of elements examined is added to \a scanned.
+ */
 template<class T, class E>
 static
-QList<E> findGridElement(T const & grid, math::Vector2f const & atPosition, math::Vector2f const & sweepDirection, float sweepAngle)
+QList<E> findGridElement(T const & grid, math::Vector2f const & atPosition, math::Vector2f const & sweepDirection, float sweepAngle, int * scanned)
 {
 	// cell that contains the specified position
 	//
@@ -305,6 +320,8 @@ QList<E> findGridElement(T const & grid, math::Vector2f const & atPosition, math
 			int c = col + dc;
 			if (c < 0 || c >= grid.cols()) continue;
 
+			*scanned += grid(r,c).size();
+
 			foreach (E const & element, grid(r,c))
 			{
 				Vector2f direction = element.pos() - atPosition;
@@ -23,7 +23,6 @@
 #include <QDebug>
 #include <QStringList>
 #include <QVariant>
-#include <QColor>
 
 #include <cmath>
 
@@ -67,15 +66,12 @@ float Tracer::distSep() const
 
 float Tracer::distSep(Point const & p) const
 {
-	if (m_populationMapImage.isNull())
+	if (m_populationDensity.isNull())
 	{
 		return distSep();
 	}
 
-	QPoint pxp = m_populationMapImage.toImageCoords(p.pos()).toPoint();
-	QRgb rgb = m_populationMapImage.pixel(pxp);
-	QColor c = QColor::fromRgb(rgb);
-	float  k = c.valueF();
+	float k = m_populationDensity.bilinear(p.pos());
 
 	return distSep() * (1.5f - k);
 }
@@ -95,6 +91,18 @@ float Tracer::distLookahead(Point const & p) const
 	return distSegment(p) * m_koefLookahead;
 }
 
+Tracer::Separation Tracer::separation(Point const & p) const
+{
+	Separation result;
+
+	result.sep       = distSep(p);
+	result.test      = result.sep * m_koefTest;
+	result.segment   = result.sep * m_koefSegment;
+	result.lookahead = result.segment * m_koefLookahead;
+
+	return result;
+}
+
 float Tracer::distSample() const
 {
 	return m_distSample;
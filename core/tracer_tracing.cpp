@@ -22,8 +22,10 @@
 #include "math/tensor.h"
 #include "math/funcs.h"
 #include "core/mapimage.h"
-#include "core/border.h"
+#include "core/boundarygeometry.h"
+#include "core/obstaclemask.h"
 #include "core/field.h"
+#include "base/profiler.h"
 
 #include <cmath>
 
@@ -137,24 +139,19 @@ Tracer::EdgeList Tracer::traceBoundaries(core::MapImage const & boundaryImage)
 {
 	EdgeList result;
 
-	border::Regions regions;
-	border::findRegions(regions, boundaryImage);
+	QSharedPointer<BoundaryGeometry const> geometry = BoundaryGeometry::fromImage(boundaryImage);
 
-	foreach (border::Boundary const & boundary, regions)
+	// full resolution, traceBoundary() does its own sampling
+	foreach (BoundaryGeometry::Polyline const & polyline, geometry->polylines())
 	{
-		foreach (border::BoundarySegment const & segment, boundary)
-		{
-			QVector<Point> segv(segment.size());
-
-			for (border::BoundarySegment::const_iterator it = segment.begin(); it != segment.end(); ++it)
-			{
-				int i = it - segment.begin();
-				segv[i] = boundaryImage.toFieldCoords(*it);
-			}
-
+		QVector<Point> segv(polyline.size());
 
-			result += traceBoundary(segv);
+		for (int i = 0; i < polyline.size(); ++i)
+		{
+			segv[i] = polyline[i];
 		}
+
+		result += traceBoundary(segv);
 	}
 
 	return result;
@@ -222,7 +219,7 @@ Vector2f eigenv(math::Tensor const & t, bool major, Vector2f const & d)
 	return math::orient(t.eigenVector(major), d);
 }
 
-float traceField(core::TensorField const & field, bool major, math::Vector2f & p, math::Vector2f & d, float distMax)
+float Tracer::integrate(core::TensorField const & field, bool major, math::Vector2f & p, math::Vector2f & d, float distMax, int * steps)
 {
 	static const float h = RK4_STEP; // integration interval
 
@@ -230,6 +227,8 @@ float traceField(core::TensorField const & field, bool major, math::Vector2f & p
 
 	for (int instep = 0; instep < INSTEP_MAX; ++instep)
 	{
+		if (steps != NULL) ++*steps;
+
 		// trace the hiperstreamline using RK-4 numerical scheme
 		//
 		Vector2f m1 = eigenv(field(p            ), major, d);
@@ -266,6 +265,10 @@ float traceField(core::TensorField const & field, bool major, math::Vector2f & p
 
 Tracer::EdgeList Tracer::traceField(core::TensorField const & field, bool major, math::Vector2f const & fromPosition, math::Vector2f const & inDirection)
 {
+	PROFILE_SPAN("tracer/traceField");
+
+	++m_statistics.traces;
+
 	// select the starting vertex
 	//
 	VertexList verticen = findVertex(fromPosition, distSep());
@@ -280,10 +283,25 @@ Tracer::EdgeList Tracer::traceField(core::TensorField const & field, bool major,
 	//
 	Vector2f sp = startVertex.pos(); // sample-point
 	Vector2f td = inDirection;       // tracing direction
-	for (float segmentLength = 0; segmentLength < distSegment(sp)+distLookahead(sp); )
+	Separation sd = separation(sp);  // distances at the sample-point
+
+	// distance to the nearest obstacle, and how close the streamline may
+	// come to one while heading towards it
+	//
+	float shoreDist = m_obstacleMask.isNull() ? INFINITY : m_obstacleMask->distance(sp);
+	float const shoreMargin = 0.25f * distSample();
+
+	for (float segmentLength = 0; segmentLength < sd.segment + sd.lookahead; )
 	{
 		Vector2f tp = sp; // tracing point
-		float traceDist = ::traceField(field, major, tp, td, distSample());
+		float traceDist;
+		int steps = 0;
+		{
+			PROFILE_SPAN("tracer/integrate");
+			traceDist = integrate(field, major, tp, td, distSample(), &steps);
+		}
+		m_statistics.rk4Steps += steps;
+		m_statistics.fieldEvaluations += 4 * steps;
 
 		if (math::zero(traceDist) == 0.0f)
 		{
@@ -292,11 +310,36 @@ Tracer::EdgeList Tracer::traceField(core::TensorField const & field, bool major,
 			break;
 		}
 
+		bool atShore = false;
+
+		if (! m_obstacleMask.isNull())
+		{
+			// a step into the water, or over a narrow stretch of it, ends the
+			// streamline at the previous sample-point, whose connections have
+			// already been looked for
+			//
+			if (m_obstacleMask->contains(tp) || (!m_obstacleMask->contains(sp) && m_obstacleMask->intersects(sp, tp)))
+			{
+				break;
+			}
+
+			// a sample-point at the water's edge is the last one, once it is
+			// connected
+			//
+			float d = m_obstacleMask->distance(tp);
+			atShore = d < shoreDist && d < shoreMargin;
+			shoreDist = d;
+		}
+
 		segmentLength += traceDist;
 		sp = tp;
+		sd = separation(sp);
 
 		// save this sample-point
 		trace.append(sp);
+		++m_statistics.samples;
+
+		PROFILE_SPAN("tracer/neighbours");
 
 		// look for an existing vertex to connect to
 		//
@@ -312,7 +355,7 @@ Tracer::EdgeList Tracer::traceField(core::TensorField const & field, bool major,
 
 		// find the closest existing sample-point
 		//
-		SamplePoint nearestSamplePoint = findSamplePoint(sp, td.normalized()*distTest(sp), M_PI/3).value(0);
+		SamplePoint nearestSamplePoint = findSamplePoint(sp, td.normalized()*sd.test, M_PI/3).value(0);
 		if (nearestSamplePoint.finite())
 		{
 			float dist = (sp - nearestSamplePoint.pos()).norm();
@@ -321,7 +364,7 @@ Tracer::EdgeList Tracer::traceField(core::TensorField const & field, bool major,
 			// or we don't have an existing sample-point yet and we're not looking ahead
 			//
 			if ((existingSamplePoint.finite() && (dist < existingDist) && (existingSamplePoint.edge() == nearestSamplePoint.edge()))
-			|| (!existingSamplePoint.finite() && (segmentLength <= distSegment(sp))))
+			|| (!existingSamplePoint.finite() && (segmentLength <= sd.segment)))
 			{
 				touchingSamplePoint = trace.last();
 				existingSamplePoint = nearestSamplePoint;
@@ -330,26 +373,45 @@ Tracer::EdgeList Tracer::traceField(core::TensorField const & field, bool major,
 
 			if (dist < distTouch()) break;
 		}
+
+		if (atShore) break;
 	}
 
 	// complete the edge
 	//
+	PROFILE_SPAN("tracer/completeEdge");
+
+	EdgeList result;
+	Statistics::Outcome outcome;
+
 	if (existingVertex.finite())
 	{
-		return completeEdge(startVertex, trace, existingVertex);
+		result = completeEdge(startVertex, trace, existingVertex, &outcome);
 	}
 	else if (existingSamplePoint.finite())
 	{
-		return completeEdge(startVertex, trace, existingSamplePoint, touchingSamplePoint);
+		result = completeEdge(startVertex, trace, existingSamplePoint, touchingSamplePoint, &outcome);
 	}
 	else
 	{
-		return completeEdge(startVertex, trace);
+		result = completeEdge(startVertex, trace, &outcome);
 	}
+
+	++m_statistics.outcomes[outcome];
+
+	return result;
+}
+
+
+// Stores the outcome of completing an edge, if requested.
+static inline
+void setOutcome(Tracer::Statistics::Outcome * outcome, Tracer::Statistics::Outcome value)
+{
+	if (outcome != NULL) *outcome = value;
 }
 
 
-Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace const & trace, Vertex const & existingVertex)
+Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace const & trace, Vertex const & existingVertex, Statistics::Outcome * outcome)
 {
 	EdgeList result;
 
@@ -358,6 +420,7 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	if (containsEdge(startVertex, existingVertex))
 	{
 		// this is an existing edge
+		setOutcome(outcome, Statistics::OutcomeRejectedOther);
 		return result;
 	}
 
@@ -375,6 +438,7 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	if (spcount == 0)
 	{
 		// no samples in this edge
+		setOutcome(outcome, Statistics::OutcomeRejectedShort);
 		return result;
 	}
 
@@ -383,13 +447,17 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	Edge * edge = new Edge(startVertex, existingVertex, trace.mid(0, spcount), edgeType());
 	addEdge(edge);
 
+	setOutcome(outcome, Statistics::OutcomeVertex);
 	return result << edge;
 }
 
-Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace const & trace, SamplePoint const & existingSamplePoint, SamplePoint const & touchingSamplePoint)
+Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace const & trace, SamplePoint const & existingSamplePoint, SamplePoint const & touchingSamplePoint, Statistics::Outcome * outcome)
 {
 	EdgeList result;
 
+	// rejections other than by angle or length are the default
+	setOutcome(outcome, Statistics::OutcomeRejectedOther);
+
 	float dist = (touchingSamplePoint.pos() - existingSamplePoint.pos()).norm();
 	if (dist > distTouch())
 	{
@@ -404,6 +472,7 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	Vector2f vn = (touchingSamplePoint.pos() - startVertex.pos()).normalized();
 	if (fabsf(acosf(vx * vn)) < M_PI/4 || fabsf(acosf(-vx * vn)) < M_PI/4)
 	{
+		setOutcome(outcome, Statistics::OutcomeRejectedAngle);
 		return result;
 	}
 
@@ -417,7 +486,11 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	// new edge's trace-line is trace broken at touch-point
 	//
 	Edge::Trace newTrace = trace.mid(0, qFind(trace, touchingSamplePoint) - trace.begin());
-	if (newTrace.empty()) return result;
+	if (newTrace.empty())
+	{
+		setOutcome(outcome, Statistics::OutcomeRejectedShort);
+		return result;
+	}
 
 	// split the existing edge
 	//
@@ -429,13 +502,17 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	Edge * newEdge = new Edge(startVertex, existingSamplePoint.pos(), newTrace, edgeType());
 	addEdge(newEdge);
 
+	setOutcome(outcome, Statistics::OutcomeSamplePoint);
 	return result << split << newEdge;
 }
 
-Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace const & trace)
+Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace const & trace, Statistics::Outcome * outcome)
 {
 	EdgeList result;
 
+	// all rejections here are for length
+	setOutcome(outcome, Statistics::OutcomeRejectedShort);
+
 	if (trace.empty())
 	{
 		return result;
@@ -475,6 +552,7 @@ Tracer::EdgeList Tracer::completeEdge(Vertex const & startVertex, Edge::Trace co
 	Edge * edge = new Edge(startVertex, endVertex, newTrace, edgeType());
 	addEdge(edge);
 
+	setOutcome(outcome, Statistics::OutcomeFreeEnd);
 	return result << edge;
 }
 
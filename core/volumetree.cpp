@@ -0,0 +1,224 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/volumetree.h"
+#include "core/volumebox.h"
+#include "math/rect.h"
+
+#include <qalgorithms.h>
+
+
+using namespace core;
+
+
+//! Maximum number of boxes in a leaf node.
+static int const LEAF_SIZE = 4;
+
+
+//! Comparator for box centres along one axis.
+struct CenterLess
+{
+	//! Constructs the object.
+	CenterLess(QVector<VolumeTree::Bounds> const & bounds, int axis) : m_bounds(bounds), m_axis(axis) {}
+
+	//! Less-than comparison function.
+	bool operator()(int left, int right)
+	{
+		return center(m_bounds[left]) < center(m_bounds[right]);
+	}
+
+	float center(VolumeTree::Bounds const & b) const
+	{
+		return m_axis == 0 ? b.min.x() + b.max.x() : b.min.y() + b.max.y();
+	}
+
+	QVector<VolumeTree::Bounds> const & m_bounds;
+	int m_axis;
+};
+
+
+enum Classification
+{
+	Outside,
+	Intersecting,
+	Inside
+};
+
+//! Classifies bounds against a set of planes.
+static Classification classify(VolumeTree::Bounds const & b, QVector4D const * planes, int numPlanes)
+{
+	Classification result = Inside;
+
+	for (int i = 0; i < numPlanes; ++i)
+	{
+		QVector4D const & p = planes[i];
+
+		// the corner farthest along the plane normal tells whether the box is
+		// outside, the nearest one whether it is entirely inside
+		//
+		float farthest =
+			p.x() * (p.x() >= 0 ? b.max.x() : b.min.x()) +
+			p.y() * (p.y() >= 0 ? b.max.y() : b.min.y()) +
+			p.z() * (p.z() >= 0 ? b.max.z() : b.min.z()) + p.w();
+
+		if (farthest < 0)
+		{
+			return Outside;
+		}
+
+		float nearest =
+			p.x() * (p.x() >= 0 ? b.min.x() : b.max.x()) +
+			p.y() * (p.y() >= 0 ? b.min.y() : b.max.y()) +
+			p.z() * (p.z() >= 0 ? b.min.z() : b.max.z()) + p.w();
+
+		if (nearest < 0)
+		{
+			result = Intersecting;
+		}
+	}
+
+	return result;
+}
+
+
+VolumeTree::VolumeTree()
+{
+}
+
+void VolumeTree::build(QVector<VolumeBox> const & boxes)
+{
+	m_bounds.clear();
+	m_order.clear();
+	m_nodes.clear();
+
+	m_bounds.resize(boxes.size());
+
+	for (int i = 0; i < boxes.size(); ++i)
+	{
+		math::Polygon base = boxes[i].base();
+
+		if (base.numPoints() < 3) continue;
+
+		math::Rect r = base.boundingRect();
+		math::Point2f c = r.corner();
+
+		m_bounds[i].min = QVector3D(c.x(), c.y(), 0.0f);
+		m_bounds[i].max = QVector3D(c.x() + r.width(), c.y() + r.height(), boxes[i].height());
+
+		m_order.append(i);
+	}
+
+	if (! m_order.isEmpty())
+	{
+		buildNode(0, m_order.size());
+	}
+}
+
+int VolumeTree::buildNode(int first, int count)
+{
+	int index = m_nodes.size();
+	m_nodes.append(Node());
+
+	Node node;
+	node.first = first;
+	node.count = count;
+	node.left = -1;
+	node.right = -1;
+
+	node.bounds = m_bounds[m_order[first]];
+	for (int i = first + 1; i < first + count; ++i)
+	{
+		Bounds const & b = m_bounds[m_order[i]];
+
+		node.bounds.min = QVector3D(qMin(node.bounds.min.x(), b.min.x()), qMin(node.bounds.min.y(), b.min.y()), qMin(node.bounds.min.z(), b.min.z()));
+		node.bounds.max = QVector3D(qMax(node.bounds.max.x(), b.max.x()), qMax(node.bounds.max.y(), b.max.y()), qMax(node.bounds.max.z(), b.max.z()));
+	}
+
+	if (count > LEAF_SIZE)
+	{
+		// split in half along the longer side
+		//
+		QVector3D extent = node.bounds.max - node.bounds.min;
+		int axis = extent.x() >= extent.y() ? 0 : 1;
+
+		qSort(m_order.begin() + first, m_order.begin() + first + count, CenterLess(m_bounds, axis));
+
+		int half = count / 2;
+		node.left = buildNode(first, half);
+		node.right = buildNode(first + half, count - half);
+	}
+
+	m_nodes[index] = node;
+
+	return index;
+}
+
+VolumeTree::Bounds const & VolumeTree::bounds(int index) const
+{
+	return m_bounds[index];
+}
+
+void VolumeTree::cull(QVector4D const * planes, int numPlanes, QVector<int> & result) const
+{
+	result.clear();
+
+	if (m_nodes.isEmpty()) return;
+
+	// depth-first traversal; a balanced tree stays far below this depth
+	//
+	int stack[64];
+	int depth = 0;
+
+	stack[depth++] = 0;
+
+	while (depth > 0)
+	{
+		Node const & node = m_nodes[stack[--depth]];
+
+		Classification c = classify(node.bounds, planes, numPlanes);
+
+		if (c == Outside)
+		{
+			continue;
+		}
+
+		if (c == Inside)
+		{
+			for (int i = node.first; i < node.first + node.count; ++i)
+			{
+				result.append(m_order[i]);
+			}
+		}
+		else if (node.left < 0)
+		{
+			for (int i = node.first; i < node.first + node.count; ++i)
+			{
+				if (classify(m_bounds[m_order[i]], planes, numPlanes) != Outside)
+				{
+					result.append(m_order[i]);
+				}
+			}
+		}
+		else
+		{
+			stack[depth++] = node.left;
+			stack[depth++] = node.right;
+		}
+	}
+}
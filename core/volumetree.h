@@ -0,0 +1,100 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef CORE_VOLUMETREE_H
+#define CORE_VOLUMETREE_H
+
+#include "core/volumetree.hh"
+#include "core/volumebox.hh"
+
+#include <QVector>
+#include <QVector3D>
+#include <QVector4D>
+
+
+//! Bounding volume hierarchy over volume boxes.
+/*!
+ * Each box is bounded by the bounding rectangle of its base, extended from
+ * the ground up to the box height. Nodes split their boxes in half along the
+ * longer side of the plane, so every subtree holds a contiguous range of
+ * boxes, and a subtree that is entirely visible is reported without testing
+ * its descendants.
+ *
+ * Coordinates are those of the boxes: x and y on the plane, z for height.
+ */
+class core::VolumeTree
+{
+public:
+	//! Axis-aligned bounds.
+	struct Bounds
+	{
+		QVector3D min;
+		QVector3D max;
+	};
+
+	//! Constructs an empty tree.
+	VolumeTree();
+
+	//! Builds the hierarchy over the specified boxes.
+	/*!
+	 * Boxes whose base has fewer than three points are left out.
+	 */
+	void build(QVector<VolumeBox> const & boxes);
+
+	//! Returns bounds of the box with the specified index.
+	Bounds const & bounds(int index) const;
+
+	//! Finds boxes that are not entirely outside any of the specified planes.
+	/*!
+	 * A plane (a,b,c,d) keeps the points for which a*x + b*y + c*z + d >= 0,
+	 * so the six planes of a view frustum select the boxes in view.
+	 *
+	 * \param planes array of planes
+	 * \param numPlanes number of planes in the array
+	 * \param result receives indices of the boxes, in no particular order
+	 */
+	void cull(QVector4D const * planes, int numPlanes, QVector<int> & result) const;
+
+private:
+	//! Tree node.
+	struct Node
+	{
+		//! Bounds of all boxes in the node.
+		Bounds bounds;
+		//! Range of the node's boxes in m_order.
+		int first, count;
+		//! Child nodes, or -1 for leaves.
+		int left, right;
+	};
+
+	//! Box bounds, by box index.
+	QVector<Bounds> m_bounds;
+	//! Box indices, grouped by node.
+	QVector<int> m_order;
+	//! Tree nodes, root first.
+	QVector<Node> m_nodes;
+
+	//! Builds a subtree over the specified range of m_order.
+	/*!
+	 * \return index of the subtree root
+	 */
+	int buildNode(int first, int count);
+};
+
+
+#endif // ifndef CORE_VOLUMETREE_H
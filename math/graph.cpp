@@ -21,12 +21,13 @@
 #include "base/bitmatrix.h"
 
 #include <QSet>
+#include <QHash>
 #include <QDebug>
+#include <QThread>
 #include <QtAlgorithms>
+#include <QtConcurrentMap>
 
 #include <stdexcept>
-#include <vector>
-#include <set>
 #include <climits>
 
 #define DIST_INF (INT_MAX/2) // infinite distance
@@ -51,14 +52,20 @@ Graph::Edge makeEdge(Graph::Vertex v1, Graph::Vertex v2)
 
 
 Graph::Graph(int n)
-	: m_matrix(n, n, false)
+	: m_numVertices(n)
+	, m_adjacencyValid(false)
 {
 }
 
 
 unsigned int Graph::numVertices() const
 {
-	return m_matrix.rows(); // or cols
+	return m_numVertices;
+}
+
+int Graph::numEdges() const
+{
+	return m_edges.size();
 }
 
 
@@ -66,7 +73,16 @@ void Graph::connect(Vertex v1, Vertex v2)
 {
 	if (v1 != NullVertex && v2 != NullVertex)
 	{
-		m_matrix(IDX(v1), IDX(v2)) = m_matrix(IDX(v2), IDX(v1)) = true;
+		if (v1 > m_numVertices || v2 > m_numVertices) throw std::out_of_range("vertex out of range");
+
+		Edge e = makeEdge(v1,v2);
+
+		if (!m_edgeIndex.contains(e))
+		{
+			m_edgeIndex.insert(e, m_edges.size());
+			m_edges.append(e);
+			m_adjacencyValid = false;
+		}
 	}
 	else
 	{
@@ -78,7 +94,25 @@ void Graph::disconnect(Vertex v1, Vertex v2)
 {
 	if (v1 != NullVertex && v2 != NullVertex)
 	{
-		m_matrix(IDX(v1), IDX(v2)) = m_matrix(IDX(v2), IDX(v1)) = false;
+		Edge e = makeEdge(v1,v2);
+
+		QHash<Edge,int>::iterator it = m_edgeIndex.find(e);
+		if (it != m_edgeIndex.end())
+		{
+			// move the last edge into the vacated slot
+			//
+			int index = it.value();
+			m_edgeIndex.erase(it);
+
+			Edge last = m_edges.takeLast();
+			if (index < m_edges.size())
+			{
+				m_edges[index] = last;
+				m_edgeIndex[last] = index;
+			}
+
+			m_adjacencyValid = false;
+		}
 	}
 	else
 	{
@@ -88,165 +122,159 @@ void Graph::disconnect(Vertex v1, Vertex v2)
 
 bool Graph::connected(Vertex v1, Vertex v2) const
 {
-	if (v1 != NullVertex && v2 != NullVertex)
-	{
-		return m_matrix(IDX(v1), IDX(v2));
-	}
-	else
-	{
-		return false;
-	}
+	return edgeIndex(v1, v2) != -1;
 }
 
 
-Graph::EdgeList Graph::edges() const
+Graph::EdgeList const & Graph::edges() const
 {
-	QSet<Edge> set;
-
-	for (Vertex x = 1; x <= numVertices(); ++x)
-	{
-		for (Vertex y = x+1; y <= numVertices(); ++y)
-		{
-			if (connected(x,y))
-			{
-				set << makeEdge(x,y);
-			}
-		}
-	}
+	return m_edges;
+}
 
-	return set.toList();
+int Graph::edgeIndex(Vertex v1, Vertex v2) const
+{
+	return m_edgeIndex.value(makeEdge(v1,v2), -1);
 }
 
 Graph::VertexList Graph::adjacents(Vertex v) const
 {
 	VertexList result;
 
-	for (Vertex u = 1; u <= numVertices(); ++u)
+	Adjacency const & adj = adjacency();
+	for (int i = adj.begin(v); i < adj.end(v); ++i)
 	{
-		if (connected(v,u))
-		{
-			result.append(u);
-		}
+		result.append(adj.targets[i]);
 	}
 
 	return result;
 }
 
+Graph::Adjacency const & Graph::adjacency() const
+{
+	if (m_adjacencyValid) return m_adjacency;
+
+	unsigned int const n = numVertices();
+	Adjacency & adj = m_adjacency;
+
+	// count degrees
+	//
+	adj.offsets.fill(0, n+1);
+	foreach (Edge const & e, m_edges)
+	{
+		++adj.offsets[e.first];
+		++adj.offsets[e.second];
+	}
+
+	// prefix sums: offsets[v] is now one past the end of v's neighbourhood,
+	// and offsets[v-1] its start
+	//
+	for (unsigned int i = 1; i <= n; ++i)
+	{
+		adj.offsets[i] += adj.offsets[i-1];
+	}
+
+	// fill neighbourhoods back to front, keeping edges in edges() order
+	//
+	adj.targets.resize(2*m_edges.size());
+	adj.edgeIds.resize(2*m_edges.size());
+
+	QVector<int> fill = adj.offsets;
+	for (int ei = m_edges.size()-1; ei >= 0; --ei)
+	{
+		Edge const & e = m_edges[ei];
+
+		int i = --fill[e.first];
+		adj.targets[i] = e.second;
+		adj.edgeIds[i] = ei;
+
+		int j = --fill[e.second];
+		adj.targets[j] = e.first;
+		adj.edgeIds[j] = ei;
+	}
+
+	m_adjacencyValid = true;
+	return m_adjacency;
+}
+
 
 Graph::Paths Graph::allPairsShortestPaths() const
 {
 	unsigned int const n = numVertices();
+	Adjacency const & adj = adjacency();
 
 	base::Matrix<int> path(n,n);
-	base::Matrix<Vertex> next(n,n);
+	base::Matrix<Vertex> prev(n,n);
 
 	path.fill(DIST_INF);
-	next.fill(NullVertex);
+	prev.fill(NullVertex);
 
-	for (Vertex v1 = 1; v1 <= n; ++v1)
-	{
-		for (Vertex v2 = 1; v2 <= n; ++v2)
-		{
-			if (v1 == v2)
-			{
-				path(IDX(v1), IDX(v2)) = 0;
-			}
-			else if (connected(v1,v2))
-			{
-				path(IDX(v1), IDX(v2)) = 1;
-			}
-			else
-			{
-				path(IDX(v1), IDX(v2)) = DIST_INF;
-			}
-		}
-	}
+	QVector<Vertex> queue(n);
 
-	for (Vertex vk = 1; vk <= n; ++vk)
+	for (Vertex vs = 1; vs <= n; ++vs)
 	{
-		for (Vertex vi = 1; vi <= n; ++vi)
+		int s = IDX(vs);
+		int head = 0, tail = 0;
+
+		path(s,s) = 0;
+		queue[tail++] = vs;
+
+		while (head < tail)
 		{
-			for (Vertex vj = 1; vj <= n; ++vj)
+			Vertex vu = queue[head++];
+			int u = IDX(vu);
+
+			for (int i = adj.begin(vu); i < adj.end(vu); ++i)
 			{
-				// matrix indices
-				int i = IDX(vi), j = IDX(vj), k = IDX(vk);
+				Vertex vw = adj.targets[i];
+				int w = IDX(vw);
 
-				if (path(i,k) + path(k,j) < path(i,j))
+				if (path(s,w) == DIST_INF)
 				{
-					path(i,j) = path(i,k) + path(k,j);
-					next(i,j) = vk; // NOTE: vk, not k
+					path(s,w) = path(s,u) + 1;
+					prev(s,w) = vu;
+					queue[tail++] = vw;
 				}
 			}
 		}
 	}
 
-	return Paths(path, next);
+	return Paths(path, prev);
 }
 
 Graph::VertexList Graph::Paths::getPath(Vertex start, Vertex end) const
 {
-	VertexList empty;
+	VertexList result;
 
 	if (m_path(IDX(start), IDX(end)) == DIST_INF)
 	{
-		return empty;
+		return result;
 	}
-	else
-	{
-		return empty << start << findPath(start, end) << end;
-	}
-}
-
-Graph::VertexList Graph::Paths::findPath(Vertex start, Vertex end) const
-{
-	VertexList empty;
-
-	Vertex intermediate = m_next(IDX(start), IDX(end));
-
-	if (intermediate == NullVertex)
-	{
-		return empty;
-	}
-	else
-	{
-		return findPath(start, intermediate) + (empty << intermediate) + findPath(intermediate, end);
-	}
-}
 
-
-//! Computes the standard inner (dot) product of two row-vectors.
-/*!
- * The operation is done in the field F_2.
- *
- * \param matA matrix containing the first row-vector
- * \param rowA row index of the first row-vector
- * \param matB matrix containing the second row-vector
- * \param rowB row index of the second row-vector
- */
-int innerProduct(base::BitMatrix & matA, int rowA, base::BitMatrix matB, int rowB)
-{
-	int s = 0;
-
-	for (int c = 0; c < matA.cols(); ++c)
+	for (Vertex v = end; v != start; v = m_prev(IDX(start), IDX(v)))
 	{
-		s += matA(rowA,c) & matB(rowB,c) ? 1 : 0;
+		result.prepend(v);
 	}
+	result.prepend(start);
 
-	return s % 2;
+	return result;
 }
 
+
 //! Returns the row index of the cycle C_i such that <C_i,S_j> = 1.
 /*!
+ * Rows of the Horton set matrix are ordered by weight, so the first
+ * matching row is the lightest such cycle.
+ *
  * \param matHS Horton set matrix
  * \param matS matrix containing S_j vectors
  * \param rowS row index of the S_j vector
  * \return the index i of the C_i vector
  */
-int findCycle(base::BitMatrix & matHS, base::BitMatrix & matS, int rowS)
+int findCycle(base::BitMatrix const & matHS, base::BitMatrix const & matS, int rowS)
 {
 	for (int r = 0; r < matHS.rows(); ++r)
 	{
-		if (innerProduct(matHS, r, matS, rowS) == 1)
+		if (matHS.innerProduct(r, matS, rowS))
 		{
 			return r;
 		}
@@ -255,84 +283,265 @@ int findCycle(base::BitMatrix & matHS, base::BitMatrix & matS, int rowS)
 	return -1;
 }
 
-//! Adds edges from S_i to S_j, i.e. S_j = S_j + S_i.
-void addEdges(base::BitMatrix & matS, int i, int j)
+//! Returns the cycle length, used as the default cycle weight.
+float cycleLength(QList<math::Graph::Vertex> const & cycle)
 {
-	for (int c = 0; c < matS.cols(); ++c)
+	return cycle.size();
+}
+
+
+//! Packed-bit incidence vector of a cycle.
+/*!
+ * The hash is computed once, so that candidate cycles can be
+ * deduplicated in a hash set.
+ */
+struct IncidenceVector
+{
+	//! Edge bits, 64 edges per word.
+	QVector<quint64> bits;
+	//! Hash of the bits.
+	uint hash;
+
+	//! Equality test.
+	bool operator==(IncidenceVector const & other) const
 	{
-		matS(j,c) = matS(j,c) || matS(i,c);
+		return hash == other.hash && bits == other.bits;
 	}
-}
+};
 
-//! Returns whether the first parameter has size less than the second one.
-bool sizeLessThan(QList<math::Graph::Vertex> const & left, QList<math::Graph::Vertex> const & right)
+inline
+uint qHash(IncidenceVector const & iv)
 {
-	return left.size() < right.size();
+	return iv.hash;
 }
 
-QList<Graph::VertexList> Graph::minimumCycleBasis() const
+//! Builds the breadth-first tree rooted at the specified vertex.
+/*!
+ * \param adj adjacency of the graph
+ * \param root root vertex
+ * \param[out] parent parent of each vertex in the tree, NullVertex if unreachable, root's parent is root
+ * \param queue scratch buffer with room for every vertex
+ */
+static
+void breadthFirstTree(Graph::Adjacency const & adj, Graph::Vertex root, QVector<Graph::Vertex> & parent, QVector<Graph::Vertex> & queue)
 {
-	return minimumCycleBasis(&sizeLessThan);
+	parent.fill(Graph::NullVertex);
+
+	int head = 0, tail = 0;
+
+	parent[root] = root;
+	queue[tail++] = root;
+
+	while (head < tail)
+	{
+		Graph::Vertex u = queue[head++];
+
+		for (int i = adj.begin(u); i < adj.end(u); ++i)
+		{
+			Graph::Vertex w = adj.targets[i];
+
+			if (parent[w] == Graph::NullVertex)
+			{
+				parent[w] = u;
+				queue[tail++] = w;
+			}
+		}
+	}
 }
 
-QList<Graph::VertexList> Graph::minimumCycleBasis(LessThan lessThan) const
+//! A candidate cycle for the Horton set.
+struct HortonCandidate
 {
-	typedef std::vector<bool> BitArray;
+	//! Cycle vertices.
+	Graph::VertexList cycle;
+	//! Cycle's incidence vector.
+	IncidenceVector incidence;
+};
 
-	EdgeList edges = this->edges();
-	Paths paths = allPairsShortestPaths();
+//! Generates Horton set candidates for a range of vertices.
+/*!
+ * Each task owns its candidate buffer, so that tasks can run concurrently.
+ * Candidates are in the same order the serial loop would produce them.
+ */
+struct HortonTask
+{
+	//! The graph.
+	Graph const * graph;
+	//! First vertex of the range.
+	Graph::Vertex first;
+	//! One past the last vertex of the range.
+	Graph::Vertex last;
+	//! Candidates found by the task.
+	QList<HortonCandidate> candidates;
+
+	//! Runs the task.
+	void run();
+};
+
+void HortonTask::run()
+{
+	typedef Graph::Vertex Vertex;
+	typedef Graph::VertexList VertexList;
 
-	QList<VertexList> cycles;
-	std::set<BitArray> cycleSet; // incidence matrix
+	Graph::EdgeList const & edges = graph->edges();
+	Graph::Adjacency const & adj = graph->adjacency();
+	int const numWords = (edges.size() + 63) / 64;
 
-	// find all candidate cycles
-	// (this set is a superset of the MCB -- let's call it the Horton set)
-	//
-	for (Vertex v = 1; v <= numVertices(); ++v)
+	// shortest paths from v are read off its breadth-first tree, so only
+	// one parent array per task is kept instead of all-pairs matrices
+	QVector<Vertex> parent(graph->numVertices() + 1);
+	QVector<Vertex> queue(graph->numVertices());
+
+	// vertices of the first path are stamped, for the intersection test
+	QVector<uint> marks(graph->numVertices() + 1, 0);
+	uint stamp = 0;
+
+	QSet<IncidenceVector> found;
+
+	for (Vertex v = first; v < last; ++v)
 	{
-		foreach (Edge e, edges)
+		breadthFirstTree(adj, v, parent, queue);
+
+		foreach (Graph::Edge e, edges)
 		{
 			Vertex x = e.first;
 			Vertex y = e.second;
 
 			if (v == x || v == y) continue;
+			if (parent[x] == Graph::NullVertex || parent[y] == Graph::NullVertex) continue;
 
-			VertexList p1 = paths.getPath(x,v);
-			VertexList p2 = paths.getPath(v,y);
+			// p1 runs from x up to, but not including, v and p2 from v down to y
+			//
+			VertexList p1, p2;
+			for (Vertex u = x; u != v; u = parent[u]) p1.append(u);
+			for (Vertex u = y; u != v; u = parent[u]) p2.prepend(u);
+			p2.prepend(v);
 
-			if (!p1.empty() && !p2.empty())
-			{
-				p1.takeLast();
+			++stamp;
+			foreach (Vertex u, p1) marks[u] = stamp;
 
-				QSet<Vertex> intersection = p1.toSet().intersect(p2.toSet());
-				if (intersection.empty())
+			bool disjoint = true;
+			foreach (Vertex u, p2)
+			{
+				if (marks[u] == stamp)
 				{
-					VertexList cycle = p1 + p2;
+					disjoint = false;
+					break;
+				}
+			}
 
-					// create an incidence vector for this cycle
-					//
-					std::vector<bool> incidenceVector(edges.size(), false);
-					for (VertexList::iterator i = cycle.begin(); i != cycle.end(); ++i)
-					{
-						VertexList::iterator j = i+1;
+			if (!disjoint) continue;
 
-						Vertex v1 = *i;
-						Vertex v2 = (j != cycle.end()) ? *j : cycle.first();
+			HortonCandidate candidate;
+			candidate.cycle = p1 + p2;
 
-						incidenceVector[edges.indexOf(makeEdge(v1,v2))] = true;
-					}
+			// create an incidence vector for this cycle
+			//
+			QVector<quint64> & bits = candidate.incidence.bits;
+			bits.fill(0, numWords);
 
-					if (cycleSet.insert(incidenceVector).second)
-					{
-						cycles.append(p1 + p2);
-					}
-				}
+			VertexList const & cycle = candidate.cycle;
+			for (VertexList::const_iterator i = cycle.begin(); i != cycle.end(); ++i)
+			{
+				VertexList::const_iterator j = i+1;
+
+				Vertex v1 = *i;
+				Vertex v2 = (j != cycle.end()) ? *j : cycle.first();
+
+				int ei = graph->edgeIndex(v1,v2);
+				bits[ei/64] |= quint64(1) << (ei%64);
+			}
+
+			uint hash = 0;
+			foreach (quint64 word, bits)
+			{
+				hash = hash*31 + uint(word ^ (word >> 32));
+			}
+			candidate.incidence.hash = hash;
+
+			if (!found.contains(candidate.incidence))
+			{
+				found.insert(candidate.incidence);
+				candidates.append(candidate);
 			}
 		}
 	}
+}
+
+//! Orders cycle indices by cycle weights.
+struct WeightLessThan
+{
+	//! Constructs the object.
+	WeightLessThan(QVector<float> const & weights) : m_weights(weights) {}
+
+	//! Less-than comparison function.
+	bool operator()(int left, int right) const
+	{
+		return m_weights[left] < m_weights[right];
+	}
+
+private:
+	//! Cycle weights.
+	QVector<float> const & m_weights;
+};
+
 
-	// order by length
-	qSort(cycles.begin(), cycles.end(), lessThan);
+QList<Graph::VertexList> Graph::minimumCycleBasis() const
+{
+	return minimumCycleBasis(&cycleLength);
+}
+
+QList<Graph::VertexList> Graph::minimumCycleBasis(Weight weight) const
+{
+	EdgeList const & edges = this->edges();
+
+	// find all candidate cycles
+	// (this set is a superset of the MCB -- let's call it the Horton set)
+	//
+	unsigned int const n = numVertices();
+	unsigned int const numTasks = qMin(n, (unsigned int) qMax(1, QThread::idealThreadCount()) * 4);
+
+	QVector<HortonTask> tasks(numTasks);
+	for (unsigned int t = 0; t < numTasks; ++t)
+	{
+		tasks[t].graph = this;
+		tasks[t].first = 1 + (n * t) / numTasks;
+		tasks[t].last  = 1 + (n * (t+1)) / numTasks;
+	}
+
+	adjacency(); // make sure the cache is built before going parallel
+	QtConcurrent::blockingMap(tasks, &HortonTask::run);
+
+	// merge task buffers in vertex order, so the result does not depend on scheduling
+	//
+	QList<VertexList> candidates;
+	QVector<float> weights;
+	QSet<IncidenceVector> cycleSet;
+
+	foreach (HortonTask const & task, tasks)
+	{
+		foreach (HortonCandidate const & candidate, task.candidates)
+		{
+			if (!cycleSet.contains(candidate.incidence))
+			{
+				cycleSet.insert(candidate.incidence);
+				candidates.append(candidate.cycle);
+				weights.append(weight(candidate.cycle));
+			}
+		}
+	}
+
+	// order by weight
+	//
+	QVector<int> order(candidates.size());
+	for (int i = 0; i < order.size(); ++i) order[i] = i;
+	qStableSort(order.begin(), order.end(), WeightLessThan(weights));
+
+	QList<VertexList> cycles;
+	foreach (int i, order)
+	{
+		cycles.append(candidates[i]);
+	}
 
 	// create the incidence matrix for the Horton set
 	//
@@ -348,7 +557,7 @@ QList<Graph::VertexList> Graph::minimumCycleBasis(LessThan lessThan) const
 			Vertex v1 = *i;
 			Vertex v2 = (j != cycle.end()) ? *j : cycle.first();
 
-			matHS(cycleIndex, edges.indexOf(makeEdge(v1,v2))) = 1;
+			matHS(cycleIndex, edgeIndex(v1,v2)) = 1;
 		}
 	}
 
@@ -369,11 +578,13 @@ QList<Graph::VertexList> Graph::minimumCycleBasis(LessThan lessThan) const
 
 		selectedCycles.insert(ci);
 
+		// S_j = S_j + S_i for every later S_j not orthogonal to C_i
+		//
 		for (int j = i+1; j < edges.size(); ++j)
 		{
-			if (innerProduct(matS, j, matHS, ci))
+			if (matS.innerProduct(j, matHS, ci))
 			{
-				addEdges(matS, i, j);
+				matS.addRow(j, matS, i);
 			}
 		}
 	}
@@ -20,11 +20,12 @@
 #define MATH_GRAPH_H
 
 #include "math/graph.hh"
-#include "base/bitmatrix.h"
 #include "base/matrix.h"
 
 #include <QList>
+#include <QVector>
 #include <QPair>
+#include <QHash>
 
 #include <tr1/functional>
 
@@ -33,6 +34,11 @@
 /*!
  * Newly created graph is disconnected. Edges are established by calling the connect()
  * function and removed with the disconnect() function.
+ *
+ * Edges are kept in a list with a hash map from edge to its index in that list,
+ * so memory is proportional to the number of edges rather than to the square of
+ * the number of vertices. Algorithms traverse the graph through its compressed
+ * sparse row (CSR) form, returned by adjacency().
  */
 struct math::Graph
 {
@@ -48,6 +54,26 @@ struct math::Graph
 	//! A null-vertex value.
 	static Vertex const NullVertex = 0;
 
+	//! Compressed sparse row form of the adjacency relation.
+	/*!
+	 * Vertices adjacent to the vertex v are targets[i] for offsets[v-1] <= i < offsets[v],
+	 * and edgeIds[i] is the index of the corresponding edge in the list returned by edges().
+	 */
+	struct Adjacency
+	{
+		//! Start of each vertex's neighbourhood, has numVertices()+1 entries.
+		QVector<int> offsets;
+		//! Adjacent vertices, grouped by source vertex.
+		QVector<Vertex> targets;
+		//! Edge index for each entry in targets.
+		QVector<int> edgeIds;
+
+		//! Returns the index of the first entry adjacent to the specified vertex.
+		int begin(Vertex v) const { return offsets[v-1]; }
+		//! Returns the index one past the last entry adjacent to the specified vertex.
+		int end(Vertex v) const { return offsets[v]; }
+	};
+
 	//! Constructs the disconnected graph with the specified number of vertices.
 	/*!
 	 * \param n a number of vertices in the graph
@@ -56,6 +82,8 @@ struct math::Graph
 
 	//! Returns a number of vertices in the graph.
 	unsigned int numVertices() const;
+	//! Returns a number of edges in the graph.
+	int numEdges() const;
 
 	//! Establishes an edge between the specified vertex pair.
 	void connect(Vertex v1, Vertex v2);
@@ -65,12 +93,27 @@ struct math::Graph
 	bool connected(Vertex v1, Vertex v2) const;
 
 	//! Returns all edges present in the graph;
-	EdgeList edges() const;
+	/*!
+	 * Each edge is given with the lesser vertex first.
+	 */
+	EdgeList const & edges() const;
+
+	//! Returns the index of the edge between the specified vertex pair in edges().
+	/*!
+	 * \return edge index, or -1 if the vertices are not adjacent
+	 */
+	int edgeIndex(Vertex v1, Vertex v2) const;
 
 	//! Returns vertices adjacent to the specified one.
 	VertexList adjacents(Vertex v) const;
 
-	//! Structure encapsulating the result of Floyd-Warshall all-pairs-shortest-paths algorithm.
+	//! Returns the compressed sparse row form of the adjacency relation.
+	/*!
+	 * The structure is built on first use after the graph has been modified.
+	 */
+	Adjacency const & adjacency() const;
+
+	//! Structure encapsulating the result of all-pairs-shortest-paths search.
 	/*!
 	 * Used for path reconstruction -- the getPath() method returns the shortest
 	 * path between any two vertices.
@@ -78,8 +121,12 @@ struct math::Graph
 	struct Paths
 	{
 		//! Constructor.
-		Paths(base::Matrix<int> const & path, base::Matrix<Vertex> const & next)
-			: m_path(path), m_next(next)
+		/*!
+		 * \param path path lengths
+		 * \param prev the vertex preceding the end vertex on the path from the start vertex
+		 */
+		Paths(base::Matrix<int> const & path, base::Matrix<Vertex> const & prev)
+			: m_path(path), m_prev(prev)
 		{}
 
 		//! Reconstructs the path between two vertices.
@@ -90,36 +137,51 @@ struct math::Graph
 
 	private:
 		base::Matrix<int>    m_path;
-		base::Matrix<Vertex> m_next;
-
-		//! Finds the path between two vertices.
-		VertexList findPath(Vertex start, Vertex end) const;
+		base::Matrix<Vertex> m_prev;
 	};
 
 	//! Returns shortest paths between all pairs of vertices.
 	/*!
-	 * This method implements the Floyd-Warshall algorithm for finding
-	 * shortest paths between all pairs of vertices.
+	 * Since the graph is weightless, this runs a breadth-first search from
+	 * every vertex, which takes O(VE) time.
 	 */
 	Paths allPairsShortestPaths() const;
 
 	//! Returns the Minimum Cycle Basis of the graph.
+	/*!
+	 * Cycles are weighted by their length.
+	 */
 	QList<VertexList> minimumCycleBasis() const;
 
-	//! Cycle comparation function signature.
-	typedef std::tr1::function<bool (VertexList const & left, VertexList const & right)> LessThan;
+	//! Cycle weight function signature.
+	typedef std::tr1::function<float (VertexList const & cycle)> Weight;
 	
 	//! Returns the Minimum Cycle Basis of the graph.
 	/*!
-	 * The cycle comparation function is specified by user.
+	 * The cycle weight function is specified by user. It is evaluated once
+	 * for every candidate cycle, so it can be expensive.
+	 *
+	 * Candidate cycles (the Horton set) are generated in parallel, but the
+	 * result does not depend on the number of threads. Shortest paths come
+	 * from one breadth-first tree per vertex, built when the vertex is
+	 * processed, so they take O(V) memory per thread.
 	 *
-	 * \param compareFunc LessThan comparator for sorting cycles
+	 * \param weight weight function used for ordering cycles
 	 */
-	QList<VertexList> minimumCycleBasis(LessThan lessThan) const;
+	QList<VertexList> minimumCycleBasis(Weight weight) const;
 
 private:
-	//! Adjacency matrix.
-	base::BitMatrix m_matrix;
+	//! Number of vertices.
+	unsigned int m_numVertices;
+	//! Edges present in the graph.
+	EdgeList m_edges;
+	//! Maps edges to their indices in m_edges.
+	QHash<Edge,int> m_edgeIndex;
+
+	//! Cached CSR adjacency.
+	mutable Adjacency m_adjacency;
+	//! Whether m_adjacency reflects the current edges.
+	mutable bool m_adjacencyValid;
 };
 
 
@@ -22,6 +22,7 @@
 
 #include <qnumeric.h>
 #include <cmath>
+#include <cstring>
 
 
 using namespace math;
@@ -58,6 +59,19 @@ bool Point2f::operator==(Point2f const & other) const
 	return this->x() == other.x() && this->y() == other.y();
 }
 
+uint math::qHash(Point2f const & p)
+{
+	// equal points must hash equally, so fold negative zero to zero
+	float x = p.x() + 0.0f;
+	float y = p.y() + 0.0f;
+
+	quint32 bx, by;
+	memcpy(&bx, &x, sizeof(bx));
+	memcpy(&by, &y, sizeof(by));
+
+	return bx ^ (by * 0x9e3779b1u);
+}
+
 bool Point2f::finite() const
 {
 	return qIsFinite(x()) && qIsFinite(y());
@@ -73,4 +73,11 @@ private:
 };
 
 
+namespace math
+{
+	//! Hash function, for points as QHash and QSet keys.
+	uint qHash(Point2f const & p);
+};
+
+
 #endif // ifndef MATH_POINT2F_H_
@@ -138,6 +138,27 @@ Point2f Polygon::centroid() const
 	return m_centroid;
 }
 
+Rect Polygon::boundingRect() const
+{
+	if (m_points.isEmpty())
+	{
+		return Rect();
+	}
+
+	float left = m_points[0].x(), right = left;
+	float bottom = m_points[0].y(), top = bottom;
+
+	foreach (Point2f const & p, m_points)
+	{
+		left   = qMin(left, p.x());
+		right  = qMax(right, p.x());
+		bottom = qMin(bottom, p.y());
+		top    = qMax(top, p.y());
+	}
+
+	return Rect(Point2f(left, bottom), right - left, top - bottom);
+}
+
 
 bool Polygon::contains(Point2f const & p) const
 {
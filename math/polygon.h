@@ -21,6 +21,7 @@
 
 #include "math/polygon.hh"
 #include "math/point2f.h"
+#include "math/rect.h"
 
 #include <QVector>
 #include <QList>
@@ -58,6 +59,9 @@ struct math::Polygon
 	//! Returns the polygon's centroid.
 	Point2f centroid() const;
 
+	//! Returns the smallest rectangle that contains the polygon.
+	Rect boundingRect() const;
+
 	//! Tests whether the specified point is inside the polygon.
 	bool contains(Point2f const & p) const;
 
@@ -0,0 +1,167 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "math/polygonmask.h"
+#include "math/polygon.h"
+
+#include <cmath>
+
+
+using namespace math;
+
+
+PolygonMask::PolygonMask()
+	: m_size(0)
+	, m_x0(0), m_y0(0)
+	, m_invCellWidth(0), m_invCellHeight(0)
+{
+}
+
+PolygonMask::PolygonMask(Polygon const & polygon)
+	: m_points(polygon.points())
+	, m_size(0)
+	, m_x0(0), m_y0(0)
+	, m_invCellWidth(0), m_invCellHeight(0)
+{
+	int const n = m_points.size();
+	if (n < 3) return;
+
+	// bounding box
+	//
+	float x0 = m_points[0].x(), x1 = x0;
+	float y0 = m_points[0].y(), y1 = y0;
+
+	for (int i = 1; i < n; ++i)
+	{
+		x0 = qMin(x0, m_points[i].x());
+		x1 = qMax(x1, m_points[i].x());
+		y0 = qMin(y0, m_points[i].y());
+		y1 = qMax(y1, m_points[i].y());
+	}
+
+	if (x1 <= x0 || y1 <= y0) return;
+
+	// about two cells for each edge, along each axis
+	//
+	m_size = qBound(4, int(2.0f * sqrtf(float(n))), 128);
+
+	m_x0 = x0;
+	m_y0 = y0;
+	m_invCellWidth  = m_size / (x1 - x0);
+	m_invCellHeight = m_size / (y1 - y0);
+
+	m_cells.fill(OutsideCell, m_size * m_size);
+	m_rowEdges.resize(m_size);
+
+	// cells touched by the bounding box of an edge are boundary cells
+	//
+	for (int i = 0; i < n; ++i)
+	{
+		Point2f const & a = m_points[i];
+		Point2f const & b = m_points[(i+1) % n];
+
+		int c0 = column(qMin(a.x(), b.x())), c1 = column(qMax(a.x(), b.x()));
+		int r0 = row(qMin(a.y(), b.y())),    r1 = row(qMax(a.y(), b.y()));
+
+		for (int r = r0; r <= r1; ++r)
+		{
+			m_rowEdges[r].append(i);
+
+			for (int c = c0; c <= c1; ++c)
+			{
+				m_cells[r*m_size + c] = BoundaryCell;
+			}
+		}
+	}
+
+	// other cells are entirely inside or outside, their centers decide
+	//
+	for (int r = 0; r < m_size; ++r)
+	{
+		float y = m_y0 + (r + 0.5f) / m_invCellHeight;
+
+		for (int c = 0; c < m_size; ++c)
+		{
+			char & cell = m_cells[r*m_size + c];
+			if (cell == BoundaryCell) continue;
+
+			float x = m_x0 + (c + 0.5f) / m_invCellWidth;
+			cell = crossings(x, y, r) ? InsideCell : OutsideCell;
+		}
+	}
+}
+
+int PolygonMask::column(float x) const
+{
+	return qBound(0, int((x - m_x0) * m_invCellWidth), m_size-1);
+}
+
+int PolygonMask::row(float y) const
+{
+	return qBound(0, int((y - m_y0) * m_invCellHeight), m_size-1);
+}
+
+bool PolygonMask::crossings(float x, float y, int row) const
+{
+	int const n = m_points.size();
+	bool inside = false;
+
+	foreach (int i, m_rowEdges[row])
+	{
+		Point2f const & a = m_points[i];
+		Point2f const & b = m_points[(i+1) % n];
+
+		if ((a.y() > y) != (b.y() > y))
+		{
+			float xc = a.x() + (y - a.y()) * (b.x() - a.x()) / (b.y() - a.y());
+			if (x < xc) inside = !inside;
+		}
+	}
+
+	return inside;
+}
+
+bool PolygonMask::contains(Point2f const & p) const
+{
+	if (m_size == 0) return false;
+
+	float x = p.x(), y = p.y();
+
+	// outside the bounding box
+	//
+	float cx = (x - m_x0) * m_invCellWidth;
+	float cy = (y - m_y0) * m_invCellHeight;
+
+	if (cx < 0 || cy < 0 || cx > m_size || cy > m_size)
+	{
+		return false;
+	}
+
+	int r = row(y);
+
+	switch (m_cells[r*m_size + column(x)])
+	{
+	case InsideCell:
+		return true;
+	case OutsideCell:
+		return false;
+	default:
+		return crossings(x, y, r);
+	}
+}
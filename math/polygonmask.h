@@ -0,0 +1,84 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+#ifndef MATH_POLYGONMASK_H_
+#define MATH_POLYGONMASK_H_
+
+#include "math/polygonmask.hh"
+#include "math/polygon.hh"
+#include "math/point2f.h"
+
+#include <QVector>
+
+
+//! Accelerated point-in-polygon test.
+/*!
+ * The polygon's bounding box is divided into a grid of cells. Cells that no
+ * polygon edge passes through are entirely inside or entirely outside, and
+ * points in them are classified by a lookup. Points in the other cells are
+ * tested exactly, by counting crossings with the edges of the cell's row
+ * only.
+ *
+ * The result is the same as that of Polygon::contains() (odd-even rule).
+ */
+struct math::PolygonMask
+{
+//! \name Object construction.
+//@{
+	//! Constructs an empty mask, that contains no points.
+	PolygonMask();
+
+	//! Constructs the mask of the specified polygon.
+	PolygonMask(Polygon const & polygon);
+//@}
+
+	//! Tests whether the specified point is inside the polygon.
+	bool contains(Point2f const & p) const;
+
+private:
+	//! Classification of a grid cell.
+	enum CellType
+	{
+		OutsideCell = 0,
+		InsideCell,
+		BoundaryCell
+	};
+
+	//! Polygon vertices.
+	QVector<Point2f> m_points;
+	//! Number of cells along each axis.
+	int m_size;
+	//! Lower-left corner of the grid.
+	float m_x0, m_y0;
+	//! Inverse of the cell size.
+	float m_invCellWidth, m_invCellHeight;
+	//! Cell types, row by row.
+	QVector<char> m_cells;
+	//! Indices of edges that span each row of cells.
+	QVector< QVector<int> > m_rowEdges;
+
+	//! Returns the grid column of the specified x coordinate, clamped to the grid.
+	int column(float x) const;
+	//! Returns the grid row of the specified y coordinate, clamped to the grid.
+	int row(float y) const;
+	//! Tests the point exactly, using the edges that span the specified row.
+	bool crossings(float x, float y, int row) const;
+};
+
+
+#endif // ifndef MATH_POLYGONMASK_H_
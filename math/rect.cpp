@@ -37,6 +37,11 @@ Rect::Rect(Point2f corner, float width, float height)
 }
 
 
+Point2f Rect::corner() const
+{
+	return m_corner;
+}
+
 float Rect::width() const
 {
 	return m_width;
@@ -37,6 +37,9 @@ struct math::Rect
 	Rect(Point2f corner, float width, float height);
 //@}
 
+	//! Returns the bottom-left corner.
+	Point2f corner() const;
+
 	//! Returns rectangle's width.
 	float width() const;
 	//! Returns rectangle's height.
@@ -0,0 +1,48 @@
+
+TARGET = newtown
+TEMPLATE = app
+
+QT += opengl
+
+include(common.pri)
+
+LIBS += -L$$CORE_LIB_DIR -l$$CORE_LIB_NAME -lGLU
+PRE_TARGETDEPS += $$CORE_LIB_DIR/lib$${CORE_LIB_NAME}.a
+
+SOURCES += \
+    app/mainwindow.cpp \
+    app/toolbox.cpp \
+    app/main.cpp \
+    app/util.cpp \
+    app/view.cpp \
+    app/scene.cpp \
+    app/glwidget.cpp \
+    app/fielditem.cpp \
+    app/graphitem.cpp \
+    app/roadtileitem.cpp \
+    app/model.cpp \
+    app/tracingdriver.cpp \
+    demo/demo.cpp \
+    demo/transformdemo.cpp \
+    core/fieldpainter.cpp
+HEADERS += \
+    app/mainwindow.h \
+    app/toolbox.h \
+    app/util.h \
+    app/view.h \
+    app/scene.h \
+    app/glwidget.h \
+    app/fielditem.h \
+    app/graphitem.h \
+    app/roadtileitem.h \
+    app/model.h \
+    app/tracingdriver.h \
+    demo/transformdemo.h \
+    core/fieldpainter.h
+
+FORMS += \
+    ui/mainwindow.ui \
+    ui/toolbox.ui \
+    ui/fieldpainterview.ui
+
+RESOURCES += data/resources.qrc
@@ -0,0 +1,24 @@
+
+TARGET = newtown-batch
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(common.pri)
+
+LIBS += -L$$CORE_LIB_DIR -l$$CORE_LIB_NAME
+PRE_TARGETDEPS += $$CORE_LIB_DIR/lib$${CORE_LIB_NAME}.a
+
+# the model is shared with the GUI application
+#
+SOURCES += \
+    batch/main.cpp \
+    batch/input.cpp \
+    batch/export.cpp \
+    batch/phasetimer.cpp \
+    app/model.cpp
+HEADERS += \
+    batch/input.h \
+    batch/export.h \
+    batch/phasetimer.h \
+    app/model.h
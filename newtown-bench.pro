@@ -0,0 +1,22 @@
+
+TARGET = newtown-bench
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(common.pri)
+
+LIBS += -L$$CORE_LIB_DIR -l$$CORE_LIB_NAME
+PRE_TARGETDEPS += $$CORE_LIB_DIR/lib$${CORE_LIB_NAME}.a
+
+# the model is shared with the GUI application
+#
+SOURCES += \
+    bench/main.cpp \
+    bench/benchmark.cpp \
+    bench/scene.cpp \
+    app/model.cpp
+HEADERS += \
+    bench/benchmark.h \
+    bench/scene.h \
+    app/model.h
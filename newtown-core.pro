@@ -0,0 +1,104 @@
+
+TARGET = newtown-core
+TEMPLATE = lib
+CONFIG += staticlib
+
+include(common.pri)
+
+DESTDIR = $$CORE_LIB_DIR
+
+SOURCES += \
+    core/parameters.cpp \
+    core/field.cpp \
+    core/filter.cpp \
+    core/heightmap.cpp \
+    core/mapimage.cpp \
+    core/obstaclemask.cpp \
+    core/border.cpp \
+    core/boundarygeometry.cpp \
+    core/edge.cpp \
+    core/changeset.cpp \
+    core/tracer.cpp \
+    core/tracer_data.cpp \
+    core/tracer_params.cpp \
+    core/tracer_tracing.cpp \
+    core/seeder.cpp \
+    core/grapher.cpp \
+    core/region.cpp \
+    core/city.cpp \
+    core/district.cpp \
+    core/block.cpp \
+    core/volumebox.cpp \
+    core/volumetree.cpp \
+    math/funcs.cpp \
+    math/vector2f.cpp \
+    math/point2f.cpp \
+    math/polygon.cpp \
+    math/polygonmask.cpp \
+    math/rect.cpp \
+    math/tensor.cpp \
+    math/graph.cpp \
+    base/bitmatrix.cpp \
+    base/profiler.cpp
+HEADERS += \
+    core/parameters.h \
+    core/parameters.hh \
+    core/point.hh \
+    core/point.h \
+    core/field.h \
+    core/filter.h \
+    core/heightmap.hh \
+    core/heightmap.h \
+    core/mapimage.h \
+    core/obstaclemask.hh \
+    core/obstaclemask.h \
+    core/raster.hh \
+    core/raster.h \
+    core/border.h \
+    core/boundarygeometry.h \
+    core/boundarygeometry.hh \
+    core/edge.hh \
+    core/edge.h \
+    core/changeset.hh \
+    core/changeset.h \
+    core/tracer.hh \
+    core/tracer.h \
+    core/seeder.hh \
+    core/seeder.h \
+    core/grapher.hh \
+    core/grapher.h \
+    core/region.h \
+    core/region.hh \
+    core/city.h \
+    core/city.hh \
+    core/district.h \
+    core/district.hh \
+    core/block.h \
+    core/block.hh \
+    core/volumebox.h \
+    core/volumebox.hh \
+    core/volumetree.h \
+    core/volumetree.hh \
+    math/funcs.h \
+    math/vector2f.hh \
+    math/vector2f.h \
+    math/point2f.hh \
+    math/point2f.h \
+    math/polygon.h \
+    math/polygon.hh \
+    math/polygonmask.h \
+    math/polygonmask.hh \
+    math/rect.h \
+    math/rect.hh \
+    math/tensor.hh \
+    math/tensor.h \
+    math/graph.h \
+    math/graph.hh \
+    base/matrix.hh \
+    base/matrix.h \
+    base/bitmatrix.h \
+    base/bitmatrix.hh \
+    base/profiler.h \
+    base/profiler.hh \
+    base/config.h \
+    base/names.h
@@ -0,0 +1,12 @@
+TARGET = newtown-tests
+TEMPLATE = app
+CONFIG += console
+CONFIG -= app_bundle
+
+include(common.pri)
+
+LIBS += -L$$CORE_LIB_DIR -l$$CORE_LIB_NAME
+PRE_TARGETDEPS += $$CORE_LIB_DIR/lib$${CORE_LIB_NAME}.a
+
+SOURCES += \
+    tests/main.cpp
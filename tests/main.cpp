@@ -0,0 +1,300 @@
+/*
+ * This file is part of Newtown.
+ *
+ * Copyright (C) 2013 Borko Jandras <bjandras@gmail.com>
+ *
+ * This program is free software: you can redistribute it and/or modify
+ * it under the terms of the GNU General Public License as published by
+ * the Free Software Foundation, either version 3 of the License, or
+ * (at your option) any later version.
+ *
+ * This program is distributed in the hope that it will be useful,
+ * but WITHOUT ANY WARRANTY; without even the implied warranty of
+ * MERCHANTABILITY or FITNESS FOR A PARTICULAR PURPOSE.  See the
+ * GNU General Public License for more details.
+ *
+ * You should have received a copy of the GNU General Public License
+ * along with this program.  If not, see <http://www.gnu.org/licenses/>.
+ */
+
+#include "core/city.h"
+#include "core/changeset.h"
+#include "core/district.h"
+#include "core/tracer.h"
+#include "core/point.h"
+#include "core/field.h"
+#include "math/tensor.h"
+
+#include <QCoreApplication>
+#include <QDebug>
+#include <QPointer>
+
+#include <stdio.h>
+
+
+//! Fails the enclosing test if the condition does not hold.
+#define CHECK(condition) \
+	if (!(condition)) \
+	{ \
+		qCritical() << __FILE__ ":" << __LINE__ << "check failed:" << #condition; \
+		return false; \
+	}
+
+
+//! Traces a square of major roads and returns the district found inside it.
+static
+core::District * traceSquareDistrict(core::City & city)
+{
+	city.traceLineSegment(core::Point(0.2f, 0.2f), core::Point(0.8f, 0.2f));
+	city.traceLineSegment(core::Point(0.8f, 0.2f), core::Point(0.8f, 0.8f));
+	city.traceLineSegment(core::Point(0.8f, 0.8f), core::Point(0.2f, 0.8f));
+	city.traceLineSegment(core::Point(0.2f, 0.8f), core::Point(0.2f, 0.2f));
+
+	city.findSubregions();
+
+	return city.districts().value(0);
+}
+
+//! A district keeps its streets when its border edge is split by a dangling road.
+static
+bool testDistrictSurvivesSpurAndSplit()
+{
+	core::City city;
+
+	QPointer<core::District> district = traceSquareDistrict(city);
+	CHECK(! district.isNull());
+	CHECK(city.districts().size() == 1);
+
+	// local streets inside the district
+	//
+	district->traceLineSegment(core::Point(0.3f, 0.5f), core::Point(0.7f, 0.5f));
+	district->traceLineSegment(core::Point(0.5f, 0.3f), core::Point(0.5f, 0.7f));
+
+	int numStreets = district->tracer().edgesCount();
+	CHECK(numStreets > 0);
+
+	int numBorderEdges = city.tracer().edgesCount();
+
+	// a dangling road touching the bottom edge splits it in two
+	//
+	city.traceLineSegment(core::Point(0.4f, 0.3f), core::Point(0.4f, 0.1f));
+	CHECK(city.tracer().edgesCount() == numBorderEdges + 2);
+
+	CHECK(! district.isNull());
+	CHECK(city.districts().size() == 1);
+	CHECK(city.districts().first() == district);
+	CHECK(district->tracer().edgesCount() == numStreets);
+	CHECK(district->contains(core::Point(0.5f, 0.5f)));
+
+	return true;
+}
+
+//! Returns the district containing the specified point.
+static
+core::District * districtAt(core::City const & city, core::Point const & p)
+{
+	foreach (core::District * district, city.districts())
+	{
+		if (district->contains(p)) return district;
+	}
+
+	return NULL;
+}
+
+//! Checks that a road across a district replaces it with two new, empty districts.
+static
+bool checkDistrictSplit(core::City & city, QPointer<core::District> const & district)
+{
+	CHECK(district.isNull());
+	CHECK(city.districts().size() == 2);
+
+	core::District * left = districtAt(city, core::Point(0.25f, 0.5f));
+	core::District * right = districtAt(city, core::Point(0.7f, 0.5f));
+
+	CHECK(left != NULL);
+	CHECK(right != NULL);
+	CHECK(left != right);
+	CHECK(! left->contains(core::Point(0.7f, 0.5f)));
+	CHECK(! right->contains(core::Point(0.25f, 0.5f)));
+	CHECK(left->tracer().edgesCount() == 0);
+	CHECK(right->tracer().edgesCount() == 0);
+
+	return true;
+}
+
+//! A road traced across a district splits it, even if one part is much smaller.
+static
+bool testDistrictSplitByLine()
+{
+	core::City city;
+
+	QPointer<core::District> district = traceSquareDistrict(city);
+	CHECK(! district.isNull());
+
+	district->traceLineSegment(core::Point(0.25f, 0.5f), core::Point(0.7f, 0.5f));
+	CHECK(district->tracer().edgesCount() > 0);
+
+	// a sixth of the district is cut off by a road from the middle to the
+	// bottom and top roads
+	//
+	city.traceLineSegment(core::Point(0.3f, 0.5f), core::Point(0.3f, 0.1f));
+	city.traceLineSegment(core::Point(0.3f, 0.5f), core::Point(0.3f, 0.9f));
+
+	return checkDistrictSplit(city, district);
+}
+
+//! Constant field with vertical minor eigenvectors.
+class ConstantField : public core::TensorField
+{
+public:
+	math::Tensor operator()(math::Vector2f const &) const { return math::Tensor(1.0f, 0.0f); }
+};
+
+//! Traces streamline segments from the specified point until one ends on an existing road.
+static
+void traceStreamlineToRoad(core::City & city, core::TensorField const & field, core::Point const & from, math::Vector2f const & direction)
+{
+	math::Vector2f p = from.pos();
+
+	for (int i = 0; i < 100; ++i)
+	{
+		city.traceField(field, core::Point(p), direction, false);
+
+		// continue from the farthest end-point traced so far along the vertical
+		// line through the start
+		//
+		math::Vector2f next = p;
+		foreach (core::Edge * edge, city.tracer().edges())
+		{
+			math::Vector2f ends[2] = { edge->v1().pos(), edge->v2().pos() };
+
+			for (int k = 0; k < 2; ++k)
+			{
+				if (qAbs(ends[k](0) - p(0)) < 0.01f && (ends[k](1) - next(1)) * direction(1) > 0)
+				{
+					next = ends[k];
+				}
+			}
+		}
+
+		if (next == p || next(1) <= 0.21f || next(1) >= 0.79f) return;
+
+		p = next;
+	}
+}
+
+//! Streamlines traced across a district split it.
+static
+bool testDistrictSplitByStreamline()
+{
+	core::City city;
+	ConstantField field;
+
+	QPointer<core::District> district = traceSquareDistrict(city);
+	CHECK(! district.isNull());
+
+	district->traceLineSegment(core::Point(0.25f, 0.5f), core::Point(0.7f, 0.5f));
+
+	// up and down from the middle, to the top and bottom roads
+	//
+	traceStreamlineToRoad(city, field, core::Point(0.3f, 0.5f), math::Vector2f(0.0f,  1.0f));
+	traceStreamlineToRoad(city, field, core::Point(0.3f, 0.5f), math::Vector2f(0.0f, -1.0f));
+
+	return checkDistrictSplit(city, district);
+}
+
+//! Removing the road between two districts merges them into a new district.
+static
+bool testDistrictsMergedByEdgeRemoval()
+{
+	core::City city;
+
+	traceSquareDistrict(city);
+	city.traceLineSegment(core::Point(0.3f, 0.5f), core::Point(0.3f, 0.1f));
+	city.traceLineSegment(core::Point(0.3f, 0.5f), core::Point(0.3f, 0.9f));
+
+	QPointer<core::District> left = districtAt(city, core::Point(0.25f, 0.5f));
+	QPointer<core::District> right = districtAt(city, core::Point(0.7f, 0.5f));
+	CHECK(city.districts().size() == 2);
+	CHECK(! left.isNull());
+	CHECK(! right.isNull());
+
+	// remove the part of the road between the two districts
+	//
+	foreach (core::Edge * edge, city.tracer().edges())
+	{
+		math::Vector2f p1 = edge->v1().pos();
+		math::Vector2f p2 = edge->v2().pos();
+
+		if (qAbs(p1(0) - 0.3f) < 0.01f && qAbs(p2(0) - 0.3f) < 0.01f
+		&& qMin(p1(1), p2(1)) > 0.19f && qMax(p1(1), p2(1)) < 0.81f)
+		{
+			city.removeEdge(edge);
+		}
+	}
+
+	CHECK(left.isNull());
+	CHECK(right.isNull());
+	CHECK(city.districts().size() == 1);
+
+	core::District * district = city.districts().first();
+	CHECK(district->contains(core::Point(0.25f, 0.5f)));
+	CHECK(district->contains(core::Point(0.7f, 0.5f)));
+
+	return true;
+}
+
+//! Seeds of two regions at one point are delivered as two seeds.
+static
+bool testSeedsCountedPerPoint()
+{
+	core::Point p(0.5f, 0.5f);
+
+	core::ChangeSet changes;
+	changes.addSeed(p);
+	changes.addSeed(p);
+	CHECK(changes.addedSeeds().value(p) == 2);
+
+	// one region's seed is consumed, the other's is still there
+	changes.removeSeed(p);
+	CHECK(changes.addedSeeds().value(p) == 1);
+	CHECK(changes.removedSeeds().isEmpty());
+
+	changes.clear();
+	changes.removeSeed(p);
+	changes.removeSeed(p);
+	changes.addSeed(p);
+	CHECK(changes.removedSeeds().value(p) == 2);
+	CHECK(changes.addedSeeds().value(p) == 1);
+
+	return true;
+}
+
+
+int main(int argc, char * argv[])
+{
+	QCoreApplication app(argc, argv);
+
+	int failed = 0;
+
+#define RUN(test) \
+	if (test()) \
+	{ \
+		printf("PASS %s\n", #test); \
+	} \
+	else \
+	{ \
+		printf("FAIL %s\n", #test); \
+		++failed; \
+	}
+
+	RUN(testDistrictSurvivesSpurAndSplit);
+	RUN(testDistrictSplitByLine);
+	RUN(testDistrictSplitByStreamline);
+	RUN(testDistrictsMergedByEdgeRemoval);
+	RUN(testSeedsCountedPerPoint);
+
+#undef RUN
+
+	return failed;
+}